@@ -0,0 +1,83 @@
+#include "../src/compiled_expression.h"
+#include "../src/parallel_evaluator.h"
+#include "../src/shunting_yard.h"
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <format>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace SYP;
+
+TEST_CASE("benchmark concurrent evaluation", "[Concurrency]") {
+  // total work stays the same, ideal scaling halves the time with every doubling of threads
+  constexpr int evaluations = 200000;
+  const CompiledExpression expr(tokenize("(a * 3 + b) % 7 == 2 && a > b"),
+                                { { "a", TokenType::Signed }, { "b", TokenType::Signed } });
+
+  unsigned maxThreads = std::max(1u, std::thread::hardware_concurrency());
+  for (unsigned threads = 1;; threads = std::min(threads * 2, maxThreads)) {
+    BENCHMARK(std::format("evaluate {} times on {} threads", evaluations, threads)) {
+      std::atomic<int> matches{0};
+      std::vector<std::thread> workers;
+      for (unsigned t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t]() {
+          std::vector<Token> slots{ Token(int64_t(0)), Token(int64_t(t)) };
+          int local = 0;
+          for (int i = static_cast<int>(t); i < evaluations; i += static_cast<int>(threads)) {
+            slots[0] = Token(int64_t(i));
+            local += std::get<bool>(expr.evaluate(slots)) ? 1 : 0;
+          }
+          matches += local;
+        });
+      }
+      for (auto &worker : workers) {
+        worker.join();
+      }
+      return matches.load();
+    };
+    if (threads == maxThreads) {
+      break;
+    }
+  }
+}
+
+TEST_CASE("benchmark parallel evaluator", "[Concurrency]") {
+  constexpr size_t rows = 1000000;
+  std::vector<int64_t> count(rows);
+  std::vector<double> price(rows);
+  for (size_t i = 0; i < rows; ++i) {
+    count[i] = static_cast<int64_t>(i % 13);
+    price[i] = static_cast<double>(i % 100) * 0.5;
+  }
+  RowSet rowSet(rows);
+  rowSet.add("count", Column(count.data())).add("price", Column(price.data()));
+
+  VariableTypes types{ { "count", TokenType::Signed }, { "price", TokenType::Float } };
+  std::vector<CompiledExpression> expressions;
+  std::vector<std::unique_ptr<bool[]>> results;
+  std::vector<OutputColumn> outputs;
+  for (int i = 0; i < 16; ++i) {
+    expressions.emplace_back(tokenize(std::format("count * {} > 20 && price < {}.5", i % 4 + 1, i * 3)), types);
+    results.emplace_back(new bool[rows]);
+    outputs.emplace_back(results.back().get());
+  }
+
+  unsigned maxThreads = std::max(1u, std::thread::hardware_concurrency());
+  for (unsigned threads = 1;; threads = std::min(threads * 2, maxThreads)) {
+    ParallelEvaluator evaluator(threads);
+    BENCHMARK(std::format("evaluate 16 expressions over {} rows on {} threads", rows, threads)) {
+      evaluator.evaluate(expressions, rowSet, outputs);
+      return results[0][rows - 1];
+    };
+    if (threads == maxThreads) {
+      break;
+    }
+  }
+}
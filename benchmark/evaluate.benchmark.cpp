@@ -1,11 +1,22 @@
+#include "../src/batch.h"
+#include "../src/compiled_expression.h"
 #include "../src/evaluate.h"
+#include "../src/expression_set.h"
+#include "../src/incremental_engine.h"
+#include "../src/jit.h"
 #include "../src/shunting_yard.h"
+#include "../src/static_expression.h"
 
 #include <catch2/catch_test_macros.hpp>
 #include <catch2/benchmark/catch_benchmark.hpp>
 
+#include <algorithm>
 #include <cstdint>
+#include <format>
+#include <memory>
 #include <stdexcept>
+#include <string>
+#include <vector>
 
 using namespace std::string_view_literals;
 using namespace SYP;
@@ -28,9 +39,222 @@ TEST_CASE("benchmark evaluate", "[Evaluate]") {
     return evaluate(tokens, variables);
   };
 
+  CompiledExpression compiled(tokens);
+  auto slots = compiled.bind(variables);
+  BENCHMARK("evaluate compiled") {
+    return compiled.evaluate(slots);
+  };
+
+  CompiledExpression typed(tokens, { { "two", TokenType::Signed } });
+  auto typedSlots = typed.bind(variables);
+  BENCHMARK("evaluate typed") {
+    return typed.evaluate(typedSlots);
+  };
+
   int64_t var = 2;
   BENCHMARK("evaluate reference") {
     return (3 * var) == 6;
   };
+
+  BENCHMARK("evaluate static") {
+    return PAGAN_EXPR("3 * two == 6")(var);
+  };
+}
+
+int64_t clampValue(int64_t value, int64_t low, int64_t high) {
+  return std::clamp(value, low, high);
+}
+
+TEST_CASE("benchmark function calls", "[Evaluate]") {
+  SymbolTable symbols;
+  symbols.registerFunction("clamp", [](FunctionArgs args) {
+    return Token(std::clamp(args[0].signedValue, args[1].signedValue, args[2].signedValue));
+  });
+  symbols.registerFunction("legacy_clamp", [](const std::vector<Token> &args) {
+    return Token(std::clamp(args[0].signedValue, args[1].signedValue, args[2].signedValue));
+  });
+  auto resolve = [&symbols](const std::string &name) { return Token(name, TokenType::Function, symbols); };
+
+  CompiledExpression compiled(tokenize("clamp(7, 0, 5) + clamp(-3, 0, 5)", symbols));
+  auto slots = compiled.bind(resolve);
+  BENCHMARK("call span function") {
+    return compiled.evaluate(slots);
+  };
+
+  symbols.registerFunction<&clampValue>("native_clamp");
+  CompiledExpression native(tokenize("native_clamp(7, 0, 5) + native_clamp(-3, 0, 5)", symbols));
+  auto nativeSlots = native.bind(resolve);
+  BENCHMARK("call native function") {
+    return native.evaluate(nativeSlots);
+  };
+
+  CompiledExpression legacy(tokenize("legacy_clamp(7, 0, 5) + legacy_clamp(-3, 0, 5)", symbols));
+  auto legacySlots = legacy.bind(resolve);
+  BENCHMARK("call vector function") {
+    return legacy.evaluate(legacySlots);
+  };
+}
+
+TEST_CASE("benchmark evaluate batch", "[Evaluate]") {
+  constexpr size_t rows = 10000;
+  std::vector<int64_t> values(rows);
+  for (size_t i = 0; i < rows; ++i) {
+    values[i] = static_cast<int64_t>(i % 5);
+  }
+  std::unique_ptr<bool[]> out(new bool[rows]);
+
+  CompiledExpression typed(tokenize("3 * two == 6"sv), { { "two", TokenType::Signed } });
+  std::vector<Column> columns{ Column(values.data()) };
+  BENCHMARK("evaluate batch 10000 rows") {
+    evaluateBatch(typed, columns, rows, out.get());
+    return out[0];
+  };
+
+  std::vector<Token> slots(1);
+  BENCHMARK("evaluate typed 10000 rows") {
+    bool last = false;
+    for (size_t i = 0; i < rows; ++i) {
+      slots[0] = Token(values[i]);
+      last = std::get<bool>(typed.evaluate(slots));
+    }
+    return last;
+  };
 }
 
+TEST_CASE("benchmark expression set", "[Evaluate]") {
+  // rules sharing the order total, as they typically do
+  std::vector<std::string> rules{
+    "(price * qty - discount) * rate > 1000",
+    "(price * qty - discount) * rate < 10",
+    "(price * qty - discount) * rate / qty > price",
+    "(price * qty - discount) > 500 && qty > 2",
+    "(price * qty - discount) * rate % 7 == 3",
+    "qty > 100 || (price * qty - discount) * rate == 0",
+  };
+  auto resolve = [](const std::string &name) {
+    return name == "qty" ? Token(int64_t(12)) : name == "discount" ? Token(int64_t(30)) : Token(int64_t(17));
+  };
+
+  std::vector<CompiledExpression> separate;
+  std::vector<TokenQueue> queues;
+  for (const auto &rule : rules) {
+    separate.emplace_back(tokenize(rule));
+    queues.push_back(tokenize(rule));
+  }
+  std::vector<std::vector<Token>> separateSlots;
+  for (const auto &expr : separate) {
+    separateSlots.push_back(expr.bind(resolve));
+  }
+  BENCHMARK("evaluate 6 rules separately") {
+    int matches = 0;
+    for (size_t i = 0; i < separate.size(); ++i) {
+      matches += std::get<bool>(separate[i].evaluate(separateSlots[i])) ? 1 : 0;
+    }
+    return matches;
+  };
+
+  ExpressionSet set(queues);
+  auto slots = set.bind(resolve);
+  std::vector<Result> results(set.size());
+  BENCHMARK("evaluate 6 rules as set") {
+    set.evaluate(slots, results);
+    return results[0];
+  };
+}
+
+TEST_CASE("benchmark incremental engine", "[Evaluate]") {
+  // 200 variables, every event changes a few of them
+  constexpr int variables = 200;
+  std::vector<TokenQueue> rules;
+  std::vector<CompiledExpression> compiled;
+  for (int i = 0; i < 50; ++i) {
+    auto rule = std::format("(v{} * v{} + v{}) % 7 == v{} % 7 || v{} > 90", i * 4 % variables, (i * 4 + 1) % variables,
+                            (i * 4 + 2) % variables, (i * 4 + 3) % variables, (i * 7) % variables);
+    rules.push_back(tokenize(rule));
+    compiled.emplace_back(tokenize(rule));
+  }
+
+  std::vector<int64_t> values(variables);
+  for (int i = 0; i < variables; ++i) {
+    values[i] = i % 50;
+  }
+  auto resolve = [&values](const std::string &name) { return Token(values[std::stoi(name.substr(1))]); };
+
+  int event = 0;
+  BENCHMARK("evaluate 50 rules per event") {
+    values[(event * 13) % variables] = event % 100;
+    values[(event * 17 + 5) % variables] = event % 60;
+    values[(event * 31 + 9) % variables] = event % 80;
+    ++event;
+    int matches = 0;
+    for (const auto &expr : compiled) {
+      matches += std::get<bool>(expr.evaluate(expr.bind(resolve))) ? 1 : 0;
+    }
+    return matches;
+  };
+
+  IncrementalEngine engine(rules);
+  for (int i = 0; i < variables; ++i) {
+    engine.set(std::format("v{}", i), Token(values[i]));
+  }
+  (void)engine.update();
+  std::vector<size_t> slots;
+  for (int i = 0; i < variables; ++i) {
+    slots.push_back(engine.slotOf(std::format("v{}", i)));
+  }
+  BENCHMARK("update 50 rules per event incrementally") {
+    engine.set(slots[(event * 13) % variables], Token(int64_t(event % 100)));
+    engine.set(slots[(event * 17 + 5) % variables], Token(int64_t(event % 60)));
+    engine.set(slots[(event * 31 + 9) % variables], Token(int64_t(event % 80)));
+    ++event;
+    return engine.update().size();
+  };
+}
+
+TEST_CASE("benchmark many rules", "[Evaluate]") {
+  // a working set of compiled rules that doesn't fit in the first level caches
+  constexpr int ruleCount = 50000;
+  VariableTypes types;
+  std::vector<Token> values;
+  for (int i = 0; i < 100; ++i) {
+    types.emplace(std::format("v{}", i), TokenType::Signed);
+    values.emplace_back(int64_t(i));
+  }
+  std::vector<CompiledExpression> rules;
+  std::vector<std::vector<Token>> slots;
+  for (int i = 0; i < ruleCount; ++i) {
+    rules.emplace_back(tokenize(std::format("(v{} * {} + v{}) % 7 == {} || v{} > {}", i % 100, i % 13 + 1,
+                                            (i * 7) % 100, i % 7, (i * 3) % 100, i % 97)),
+                       types);
+    slots.push_back(rules.back().bind([&values](const std::string &name) { return values[std::stoi(name.substr(1))]; }));
+  }
+
+  BENCHMARK("evaluate 50000 rules") {
+    int matches = 0;
+    for (int i = 0; i < ruleCount; ++i) {
+      matches += std::get<bool>(rules[i].evaluate(slots[i])) ? 1 : 0;
+    }
+    return matches;
+  };
+}
+
+TEST_CASE("benchmark jit", "[Evaluate]") {
+  auto tokens = tokenize("(price * qty - discount) * 2 > limit && rate * 1.5 < 10.0"sv);
+  VariableTypes types{ { "price", TokenType::Signed }, { "qty", TokenType::Signed }, { "discount", TokenType::Signed },
+                       { "limit", TokenType::Signed }, { "rate", TokenType::Float } };
+  std::unordered_map<std::string, Token> values{ { "price", Token(int64_t(10)) }, { "qty", Token(int64_t(3)) },
+                                                 { "discount", Token(int64_t(4)) }, { "limit", Token(int64_t(20)) },
+                                                 { "rate", Token(2.5) } };
+  auto resolve = [&values](const std::string &name) { return values.at(name); };
+
+  CompiledExpression typed(tokens, types);
+  auto slots = typed.bind(resolve);
+  BENCHMARK("evaluate typed") {
+    return typed.evaluate(slots);
+  };
+
+  JitExpression jit(tokens, types, 0);
+  BENCHMARK("evaluate native") {
+    return jit.evaluate(slots);
+  };
+}
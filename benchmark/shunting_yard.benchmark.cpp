@@ -1,11 +1,97 @@
+#include "archive.h"
+#include "compiled_expression.h"
+#include "expression_cache.h"
 #include "shunting_yard.h"
 
 #include <catch2/catch_test_macros.hpp>
 #include <catch2/benchmark/catch_benchmark.hpp>
 
+#include <filesystem>
+#include <format>
+#include <vector>
+
 TEST_CASE("benchmark shunting_yard", "[ShuntingYard]") {
   std:: string expression = "3 * two == 6";
   BENCHMARK("tokenize") {
     return SYP::tokenize(expression);
   };
+
+  std::string rule = "enabled && (priority >= 3 || owner == \"admin\") && !(retries > 5) and size << 2 < limit - 10";
+  BENCHMARK("tokenize rule") {
+    return SYP::tokenize(rule);
+  };
+
+  std::string numbers = "0.125 * 3.5e2 + 1.75 * 2.25 - 1e-3 * 42.0 + 0x1f * 0b101";
+  BENCHMARK("tokenize numbers") {
+    return SYP::tokenize(numbers);
+  };
+
+  std::string script;
+  for (int i = 0; i < 1000; ++i) {
+    script += rule + ";\n";
+  }
+  BENCHMARK("tokenize script of 1000 statements") {
+    size_t count = 0;
+    size_t begin = 0;
+    for (size_t end = script.find(';'); end != std::string::npos; begin = end + 1, end = script.find(';', begin)) {
+      count += SYP::tokenize(std::string_view(script).substr(begin, end - begin)).size();
+    }
+    return count;
+  };
+
+  BENCHMARK("stream script of 1000 statements in 4k chunks") {
+    size_t count = 0;
+    SYP::StreamTokenizer tokenizer;
+    auto onStatement = [&count](const SYP::TokenQueue &tokens) { count += tokens.size(); };
+    for (size_t offset = 0; offset < script.size(); offset += 4096) {
+      tokenizer.feed(std::string_view(script).substr(offset, 4096), onStatement);
+    }
+    tokenizer.finish(onStatement);
+    return count;
+  };
+}
+
+TEST_CASE("benchmark expression cache", "[ExpressionCache]") {
+  std::string rule = "enabled && (priority >= 3 || owner == \"admin\") && !(retries > 5) and size << 2 < limit - 10";
+  BENCHMARK("compile rule") {
+    return SYP::CompiledExpression(SYP::tokenize(rule));
+  };
+
+  SYP::ExpressionCache cache(1024);
+  BENCHMARK("cached rule") {
+    return cache.get(rule);
+  };
+
+  BENCHMARK("normalize rule") {
+    return SYP::ExpressionCache::normalize(rule);
+  };
+}
+
+TEST_CASE("benchmark archive", "[Archive]") {
+  constexpr int ruleCount = 10000;
+  std::vector<std::string> rules;
+  std::vector<SYP::Program> programs;
+  for (int i = 0; i < ruleCount; ++i) {
+    rules.push_back(std::format("(v{} * {} + v{}) % 7 == {} || owner == \"user{}\"", i % 100, i % 13 + 1, (i * 7) % 100,
+                                i % 7, i % 50));
+    programs.push_back(SYP::compile(SYP::tokenize(rules.back())));
+  }
+  auto path = (std::filesystem::temp_directory_path() / "pagan_benchmark.expa").string();
+  SYP::writeArchive(path, programs);
+
+  BENCHMARK("compile 10000 rules") {
+    std::vector<SYP::CompiledExpression> compiled;
+    compiled.reserve(rules.size());
+    for (const auto &rule : rules) {
+      compiled.emplace_back(SYP::tokenize(rule));
+    }
+    return compiled.size();
+  };
+
+  BENCHMARK("load 10000 rules") {
+    SYP::ExpressionArchive archive(path);
+    return archive[ruleCount - 1].slotCount();
+  };
+
+  std::filesystem::remove(path);
 }
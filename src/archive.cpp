@@ -0,0 +1,527 @@
+#include "archive.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <stdexcept>
+#include <type_traits>
+#include <unordered_map>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define PAGAN_ARCHIVE_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace SYP {
+
+namespace {
+
+static_assert(std::is_trivially_copyable_v<Token> && std::is_standard_layout_v<Token>);
+static_assert(std::is_trivially_copyable_v<Instruction>);
+
+constexpr std::array<char, 8> s_Magic{ 'P', 'A', 'G', 'A', 'N', 'E', 'X', 'A' };
+constexpr uint32_t s_ByteOrder = 0x01020304;
+
+/**
+ * all sections are arrays at 8 byte aligned offsets from the start of the file, everything
+ * references other data by index so the file can be mapped anywhere
+ */
+struct Header {
+  std::array<char, 8> magic;
+  uint32_t version;
+  uint32_t byteOrder;
+  uint32_t tokenSize;
+  uint32_t valueOffset;
+  uint32_t expressionCount;
+  uint32_t slotCount;
+  uint32_t instructionCount;
+  uint32_t constantCount;
+  uint32_t relocationCount;
+  uint32_t stringCount;
+  uint64_t expressions;
+  uint64_t slots;
+  uint64_t code;
+  uint64_t constants;
+  // indices of the string constants, stored with the string index as value
+  uint64_t relocations;
+  uint64_t strings;
+  uint64_t stringData;
+  uint64_t size;
+};
+
+struct ExpressionRecord {
+  uint32_t code;
+  uint32_t codeCount;
+  uint32_t constants;
+  uint32_t constantCount;
+  uint32_t slots;
+  uint32_t slotCount;
+  uint32_t stackSize;
+  uint32_t memoCount;
+  uint32_t resultType;
+  uint32_t reserved;
+};
+
+struct StringRecord {
+  uint64_t offset;
+  uint32_t length;
+  // 1 if the string is used as a function name
+  uint32_t function;
+};
+
+uint32_t toIndex(size_t value) {
+  if (value > std::numeric_limits<uint32_t>::max()) {
+    throw std::runtime_error("too many expressions for one archive");
+  }
+  return static_cast<uint32_t>(value);
+}
+
+class ArchiveWriter {
+public:
+  void add(const Program &program) {
+    if (program.yieldCount > 0) {
+      throw std::runtime_error("programs with several results can't be archived");
+    }
+    m_Expressions.push_back(ExpressionRecord{ toIndex(m_Code.size()), toIndex(program.code.size()),
+                                              toIndex(m_Constants.size()), toIndex(program.constants.size()),
+                                              toIndex(m_Slots.size()), toIndex(program.slots.size()),
+                                              toIndex(program.stackSize), toIndex(program.memoCount),
+                                              static_cast<uint32_t>(program.resultType), 0 });
+    m_Code.insert(m_Code.end(), program.code.begin(), program.code.end());
+    for (const auto &tok : program.constants) {
+      constant(tok);
+    }
+    for (size_t i = 0; i < program.slots.size(); ++i) {
+      m_Slots.push_back(detail::ArchiveSlot{ string(program.slots[i], program.functionSlots[i]),
+                                             static_cast<uint16_t>(program.slotTypes[i]),
+                                             static_cast<uint16_t>(program.functionSlots[i] ? 1 : 0) });
+    }
+  }
+
+  void write(std::ostream &out) const {
+    Header header{};
+    header.magic = s_Magic;
+    header.version = ExpressionArchive::s_Version;
+    header.byteOrder = s_ByteOrder;
+    header.tokenSize = sizeof(Token);
+    header.valueOffset = offsetof(Token, unsignedValue);
+    header.expressionCount = toIndex(m_Expressions.size());
+    header.slotCount = toIndex(m_Slots.size());
+    header.instructionCount = toIndex(m_Code.size());
+    header.constantCount = toIndex(m_Constants.size());
+    header.relocationCount = toIndex(m_Relocations.size());
+    header.stringCount = toIndex(m_Strings.size());
+
+    uint64_t offset = sizeof(Header);
+    auto place = [&offset](uint64_t &section, size_t bytes) {
+      section = offset;
+      offset = (offset + bytes + 7) / 8 * 8;
+    };
+    place(header.expressions, m_Expressions.size() * sizeof(ExpressionRecord));
+    place(header.slots, m_Slots.size() * sizeof(detail::ArchiveSlot));
+    place(header.code, m_Code.size() * sizeof(Instruction));
+    place(header.constants, m_Constants.size() * sizeof(Token));
+    place(header.relocations, m_Relocations.size() * sizeof(uint32_t));
+    place(header.strings, m_Strings.size() * sizeof(StringRecord));
+    place(header.stringData, m_StringData.size());
+    header.size = offset;
+
+    uint64_t written = 0;
+    auto section = [&](uint64_t start, const void *data, size_t bytes) {
+      static constexpr char s_Padding[8]{};
+      out.write(s_Padding, static_cast<std::streamsize>(start - written));
+      out.write(static_cast<const char *>(data), static_cast<std::streamsize>(bytes));
+      written = start + bytes;
+    };
+    section(0, &header, sizeof(Header));
+    section(header.expressions, m_Expressions.data(), m_Expressions.size() * sizeof(ExpressionRecord));
+    section(header.slots, m_Slots.data(), m_Slots.size() * sizeof(detail::ArchiveSlot));
+    section(header.code, m_Code.data(), m_Code.size() * sizeof(Instruction));
+    section(header.constants, m_Constants.data(), m_Constants.size() * sizeof(Token));
+    section(header.relocations, m_Relocations.data(), m_Relocations.size() * sizeof(uint32_t));
+    section(header.strings, m_Strings.data(), m_Strings.size() * sizeof(StringRecord));
+    section(header.stringData, m_StringData.data(), m_StringData.size());
+    section(header.size, nullptr, 0);
+    if (!out) {
+      throw std::runtime_error("failed to write archive");
+    }
+  }
+
+private:
+  void constant(const Token &tok) {
+    uint64_t value = 0;
+    switch (tok.type) {
+    case TokenType::Signed:
+    case TokenType::Unsigned:
+    case TokenType::Float:
+      value = tok.unsignedValue;
+      break;
+    case TokenType::Boolean:
+      value = tok.boolValue ? 1 : 0;
+      break;
+    case TokenType::String:
+      m_Relocations.push_back(toIndex(m_Constants.size()));
+      value = string(*tok.name, false);
+      break;
+    default:
+      throw std::runtime_error(std::format("constant of type {} can't be archived", getTypeName(tok.type)));
+    }
+    // written field by field so the padding is zero
+    std::array<char, sizeof(Token)> bytes{};
+    std::memcpy(bytes.data() + offsetof(Token, type), &tok.type, sizeof(tok.type));
+    std::memcpy(bytes.data() + offsetof(Token, unsignedValue), &value, sizeof(value));
+    m_Constants.push_back(bytes);
+  }
+
+  uint32_t string(const std::string &value, bool function) {
+    auto [iter, added] = m_StringIds.emplace(value, toIndex(m_Strings.size()));
+    if (added) {
+      m_Strings.push_back(StringRecord{ m_StringData.size(), toIndex(value.size()), 0 });
+      m_StringData.append(value);
+    }
+    m_Strings[iter->second].function |= function ? 1 : 0;
+    return iter->second;
+  }
+
+private:
+  std::vector<ExpressionRecord> m_Expressions;
+  std::vector<detail::ArchiveSlot> m_Slots;
+  std::vector<Instruction> m_Code;
+  std::vector<std::array<char, sizeof(Token)>> m_Constants;
+  std::vector<uint32_t> m_Relocations;
+  std::vector<StringRecord> m_Strings;
+  std::string m_StringData;
+  std::unordered_map<std::string, uint32_t> m_StringIds;
+};
+
+[[noreturn]] void throwDamaged() {
+  throw std::runtime_error("damaged expression archive");
+}
+
+template <typename T>
+T *sectionOf(void *memory, size_t size, uint64_t offset, uint64_t count) {
+  if ((offset % alignof(T) != 0) || (offset > size) || (count > (size - offset) / sizeof(T))) {
+    throwDamaged();
+  }
+  return reinterpret_cast<T *>(static_cast<char *>(memory) + offset);
+}
+
+bool validType(uint32_t type) {
+  return type <= static_cast<uint32_t>(TokenType::Slot);
+}
+
+/**
+ * follow every path through the code and check that no instruction pops from an empty stack or
+ * pushes beyond stackSize, since the VM trusts both. Each instruction has to be reached with the
+ * same depth on all paths. Expects opcodes and jump targets to be checked already
+ */
+bool stackFits(const ProgramView &program) {
+  const auto &code = program.code;
+  std::vector<int64_t> depths(code.size(), -1);
+  std::vector<size_t> pending;
+
+  auto reach = [&](size_t target, int64_t depth) {
+    if ((target >= code.size()) || (depth < 0) || (static_cast<uint64_t>(depth) > program.stackSize)) {
+      return false;
+    }
+    if (depths[target] < 0) {
+      depths[target] = depth;
+      pending.push_back(target);
+      return true;
+    }
+    return depths[target] == depth;
+  };
+
+  if (!reach(0, 0)) {
+    return false;
+  }
+  while (!pending.empty()) {
+    auto index = pending.back();
+    pending.pop_back();
+    auto depth = depths[index];
+    auto operand = static_cast<int64_t>(code[index].operand());
+    bool fits = true;
+    switch (code[index].code()) {
+    case OpCode::Return: break;
+    case OpCode::LoadConst:
+    case OpCode::LoadSlot: fits = reach(index + 1, depth + 1); break;
+    case OpCode::Operator: {
+      int64_t arity = static_cast<OperatorType>(operand) == OperatorType::LogicalNot ? 1 : 2;
+      fits = (depth >= arity) && reach(index + 1, depth - arity + 1);
+      break;
+    }
+    // pops the arguments and replaces the function with the result
+    case OpCode::Call: fits = (depth > operand) && reach(index + 1, depth - operand); break;
+    // pushes the memo or skips the following instruction
+    case OpCode::LoadMemo: fits = reach(index + 1, depth + 1) && reach(index + 2, depth); break;
+    case OpCode::StoreMemo:
+    case OpCode::NotBool:
+    case OpCode::ToBool:
+    case OpCode::ConvI64ToF64:
+    case OpCode::ConvU64ToF64:
+    case OpCode::ConvI64ToU64:
+    case OpCode::ConvU64ToI64:
+    case OpCode::ConvIntToBool: fits = (depth >= 1) && reach(index + 1, depth); break;
+    case OpCode::Jump: fits = reach(operand, depth); break;
+    case OpCode::JumpIfFalse: fits = (depth >= 1) && reach(index + 1, depth - 1) && reach(operand, depth - 1); break;
+    case OpCode::JumpIfFalseOrPop:
+    case OpCode::JumpIfTrueOrPop: fits = (depth >= 1) && reach(index + 1, depth - 1) && reach(operand, depth); break;
+    // typed binary operators
+    default: fits = (depth >= 2) && reach(index + 1, depth - 1); break;
+    }
+    if (!fits) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}
+
+void writeArchive(std::ostream &out, std::span<const Program> programs) {
+  ArchiveWriter writer;
+  for (const auto &program : programs) {
+    writer.add(program);
+  }
+  writer.write(out);
+}
+
+void writeArchive(const std::string &path, std::span<const Program> programs) {
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  if (!out) {
+    throw std::runtime_error(std::format("failed to create {}", path));
+  }
+  writeArchive(out, programs);
+}
+
+ExpressionArchive::ExpressionArchive(const std::string &path, SymbolTable &symbols) {
+#ifdef PAGAN_ARCHIVE_MMAP
+  int file = open(path.c_str(), O_RDONLY);
+  if (file < 0) {
+    throw std::runtime_error(std::format("failed to open {}", path));
+  }
+  struct stat info {};
+  if ((fstat(file, &info) != 0) || (static_cast<size_t>(info.st_size) < sizeof(Header))) {
+    close(file);
+    throw std::runtime_error(std::format("{} is not an expression archive", path));
+  }
+  m_Size = static_cast<size_t>(info.st_size);
+  // private and writable so string literals can be relocated, pages that aren't written to stay
+  // shared with the page cache
+  void *memory = mmap(nullptr, m_Size, PROT_READ | PROT_WRITE, MAP_PRIVATE, file, 0);
+  close(file);
+  if (memory == MAP_FAILED) {
+    throw std::runtime_error(std::format("failed to map {}", path));
+  }
+  m_Memory = memory;
+#else
+  std::ifstream in(path, std::ios::binary | std::ios::ate);
+  if (!in) {
+    throw std::runtime_error(std::format("failed to open {}", path));
+  }
+  m_Size = static_cast<size_t>(in.tellg());
+  if (m_Size < sizeof(Header)) {
+    throw std::runtime_error(std::format("{} is not an expression archive", path));
+  }
+  m_Buffer.resize((m_Size + 7) / 8);
+  in.seekg(0);
+  in.read(reinterpret_cast<char *>(m_Buffer.data()), static_cast<std::streamsize>(m_Size));
+  m_Memory = m_Buffer.data();
+#endif
+
+  try {
+    load(symbols);
+  } catch (...) {
+    release();
+    throw;
+  }
+}
+
+ExpressionArchive::~ExpressionArchive() {
+  release();
+}
+
+void ExpressionArchive::release() {
+#ifdef PAGAN_ARCHIVE_MMAP
+  if (m_Memory != nullptr) {
+    munmap(m_Memory, m_Size);
+  }
+#endif
+  m_Memory = nullptr;
+}
+
+void ExpressionArchive::load(SymbolTable &symbols) {
+  Header header;
+  std::memcpy(&header, m_Memory, sizeof(Header));
+  if (header.magic != s_Magic) {
+    throw std::runtime_error("not an expression archive");
+  }
+  if (header.version != s_Version) {
+    throw std::runtime_error(std::format("unsupported archive version {}", header.version));
+  }
+  if ((header.byteOrder != s_ByteOrder) || (header.tokenSize != sizeof(Token)) ||
+      (header.valueOffset != offsetof(Token, unsignedValue))) {
+    throw std::runtime_error("archive was written by a build with a different memory layout");
+  }
+  if (header.size != m_Size) {
+    throw std::runtime_error("archive is truncated");
+  }
+
+  m_ExpressionCount = header.expressionCount;
+  m_Expressions = sectionOf<const ExpressionRecord>(m_Memory, m_Size, header.expressions, header.expressionCount);
+  m_Slots = std::span(sectionOf<const detail::ArchiveSlot>(m_Memory, m_Size, header.slots, header.slotCount),
+                      header.slotCount);
+  m_Code = std::span(sectionOf<const Instruction>(m_Memory, m_Size, header.code, header.instructionCount),
+                     header.instructionCount);
+  auto *constants = sectionOf<Token>(m_Memory, m_Size, header.constants, header.constantCount);
+  m_Constants = std::span<const Token>(constants, header.constantCount);
+  const auto *relocations = sectionOf<const uint32_t>(m_Memory, m_Size, header.relocations, header.relocationCount);
+  const auto *strings = sectionOf<const StringRecord>(m_Memory, m_Size, header.strings, header.stringCount);
+  const auto *stringData = sectionOf<const char>(m_Memory, m_Size, header.stringData, 0);
+  size_t stringSize = m_Size - header.stringData;
+
+  // the only work proportional to the content, once per distinct string
+  m_Strings.resize(header.stringCount);
+  m_Functions.resize(header.stringCount, nullptr);
+  for (size_t i = 0; i < header.stringCount; ++i) {
+    const auto &record = strings[i];
+    if ((record.offset > stringSize) || (record.length > stringSize - record.offset)) {
+      throwDamaged();
+    }
+    std::string_view value(stringData + record.offset, record.length);
+    m_Strings[i] = symbols.internVariable(value);
+    if (record.function != 0) {
+      m_Functions[i] = symbols.internFunction(value);
+    }
+  }
+
+  for (size_t i = 0; i < header.relocationCount; ++i) {
+    auto index = relocations[i];
+    if ((index >= header.constantCount) || (constants[index].type != TokenType::String) ||
+        (constants[index].unsignedValue >= header.stringCount)) {
+      throwDamaged();
+    }
+    constants[index].name = m_Strings[constants[index].unsignedValue];
+  }
+}
+
+ArchivedExpression ExpressionArchive::operator[](size_t index) const {
+  if (index >= m_ExpressionCount) {
+    throw std::runtime_error(std::format("expression {} out of range, archive has {}", index, m_ExpressionCount));
+  }
+  const auto &record = static_cast<const ExpressionRecord *>(m_Expressions)[index];
+  if ((record.codeCount == 0) || (record.code > m_Code.size()) || (record.codeCount > m_Code.size() - record.code) ||
+      (record.constants > m_Constants.size()) || (record.constantCount > m_Constants.size() - record.constants) ||
+      (record.slots > m_Slots.size()) || (record.slotCount > m_Slots.size() - record.slots) ||
+      !validType(record.resultType)) {
+    throwDamaged();
+  }
+  ProgramView program{ m_Code.subspan(record.code, record.codeCount),
+                       m_Constants.subspan(record.constants, record.constantCount), record.stackSize,
+                       record.memoCount, 0 };
+  return ArchivedExpression(*this, program, m_Slots.subspan(record.slots, record.slotCount),
+                            static_cast<TokenType>(record.resultType));
+}
+
+void ExpressionArchive::verify() const {
+  for (size_t index = 0; index < m_ExpressionCount; ++index) {
+    auto expression = (*this)[index];
+    const auto &program = expression.program();
+    for (const auto &slot : expression.m_Slots) {
+      if ((slot.name >= m_Strings.size()) || !validType(slot.type) ||
+          ((slot.function != 0) && (m_Functions[slot.name] == nullptr))) {
+        throwDamaged();
+      }
+    }
+    for (const auto &tok : program.constants) {
+      if (!validType(static_cast<uint32_t>(tok.type))) {
+        throwDamaged();
+      }
+    }
+
+    auto invalid = [&](const Instruction &instruction) {
+      auto operand = instruction.operand();
+      switch (instruction.code()) {
+      case OpCode::LoadConst: return operand >= program.constants.size();
+      case OpCode::LoadSlot: return operand >= expression.slotCount();
+      case OpCode::LoadMemo:
+      case OpCode::StoreMemo: return operand >= program.memoCount;
+      case OpCode::Operator: return operand >= static_cast<uint32_t>(OperatorType::OperatorCount);
+      case OpCode::Call: return operand >= program.stackSize;
+      case OpCode::Jump:
+      case OpCode::JumpIfFalse:
+      case OpCode::JumpIfFalseOrPop:
+      case OpCode::JumpIfTrueOrPop: return operand >= program.code.size();
+      case OpCode::Yield: return true;
+      default: return instruction.code() >= OpCode::OpCodeCount;
+      }
+    };
+    // every stack entry and memo takes at least one instruction, larger sizes are damage that
+    // would only make evaluation allocate more
+    if (std::any_of(program.code.begin(), program.code.end(), invalid) ||
+        (program.code.back().code() != OpCode::Return) || (program.stackSize > program.code.size()) ||
+        (program.memoCount > program.code.size()) || !stackFits(program)) {
+      throw std::runtime_error(std::format("expression {} in archive has invalid code", index));
+    }
+  }
+}
+
+const std::string &ArchivedExpression::variable(size_t slot) const {
+  return *m_Archive->m_Strings[m_Slots[slot].name];
+}
+
+size_t ArchivedExpression::slotOf(std::string_view name) const {
+  for (size_t i = 0; i < m_Slots.size(); ++i) {
+    if (variable(i) == name) {
+      return i;
+    }
+  }
+  return npos;
+}
+
+TokenType ArchivedExpression::slotType(size_t slot) const {
+  return static_cast<TokenType>(m_Slots[slot].type);
+}
+
+std::vector<Token> ArchivedExpression::bind(const std::function<Token(const std::string &)> &resolve) const {
+  std::vector<Token> slots;
+  slots.reserve(m_Slots.size());
+  for (size_t i = 0; i < m_Slots.size(); ++i) {
+    if (isFunctionSlot(i)) {
+      Token tok;
+      tok.type = TokenType::Function;
+      tok.function = m_Archive->m_Functions[m_Slots[i].name];
+      slots.push_back(tok);
+      continue;
+    }
+    auto tok = resolve(variable(i));
+    auto declared = slotType(i);
+    if ((declared != TokenType::Undefined) && (tok.type != declared)) {
+      throw std::runtime_error(std::format("{} declared as {} but resolved to {}", variable(i),
+                                           getTypeName(declared), getTypeName(tok.type)));
+    }
+    slots.push_back(tok);
+  }
+  return slots;
+}
+
+Result ArchivedExpression::evaluate(std::span<const Token> slots) const {
+  auto &workspace = Workspace::local();
+  workspace.reset();
+  return evaluate(slots, workspace);
+}
+
+Result ArchivedExpression::evaluate(std::span<const Token> slots, Workspace &workspace) const {
+  if (slots.size() < m_Slots.size()) {
+    throw std::runtime_error(std::format("expected {} bound slots, got {}", m_Slots.size(), slots.size()));
+  }
+  return toResult(execute(m_Program, slots, workspace));
+}
+
+}
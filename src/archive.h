@@ -0,0 +1,151 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <ostream>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "bytecode.h"
+#include "evaluate.h"
+#include "symbol_table.h"
+#include "workspace.h"
+
+namespace SYP {
+
+/**
+ * write compiled programs to a binary archive that ExpressionArchive loads without parsing.
+ * The format stores tokens and instructions in their in-memory layout, so an archive can only
+ * be loaded by a build with the same layout and byte order, which is checked when loading.
+ * Throws if writing fails
+ */
+void writeArchive(std::ostream &out, std::span<const Program> programs);
+
+void writeArchive(const std::string &path, std::span<const Program> programs);
+
+class ExpressionArchive;
+
+namespace detail {
+
+/**
+ * slot of an archived expression as stored in the file
+ */
+struct ArchiveSlot {
+  // index in the string table
+  uint32_t name;
+  uint16_t type;
+  uint16_t function;
+};
+
+}
+
+/**
+ * handle to an expression in an archive, references the archive's memory and is only valid as
+ * long as the archive. Cheap to create and copy
+ */
+class ArchivedExpression {
+public:
+  static constexpr size_t npos = std::numeric_limits<size_t>::max();
+
+public:
+  [[nodiscard]] size_t slotCount() const { return m_Slots.size(); }
+
+  /**
+   * name of the symbol bound to a slot
+   */
+  [[nodiscard]] const std::string &variable(size_t slot) const;
+
+  [[nodiscard]] size_t slotOf(std::string_view name) const;
+
+  [[nodiscard]] bool isFunctionSlot(size_t slot) const { return m_Slots[slot].function != 0; }
+
+  [[nodiscard]] TokenType slotType(size_t slot) const;
+
+  [[nodiscard]] TokenType resultType() const { return m_ResultType; }
+
+  [[nodiscard]] const ProgramView &program() const { return m_Program; }
+
+  /**
+   * resolve the variables like CompiledExpression::bind. Function slots are bound to the
+   * functions of the symbol table the archive was loaded with and aren't passed to resolve
+   */
+  [[nodiscard]] std::vector<Token> bind(const std::function<Token(const std::string &)> &resolve) const;
+
+  [[nodiscard]] Result evaluate(std::span<const Token> slots) const;
+
+  [[nodiscard]] Result evaluate(std::span<const Token> slots, Workspace &workspace) const;
+
+private:
+  friend class ExpressionArchive;
+
+  ArchivedExpression(const ExpressionArchive &archive, ProgramView program,
+                     std::span<const detail::ArchiveSlot> slots, TokenType resultType)
+    : m_Archive(&archive), m_Program(program), m_Slots(slots), m_ResultType(resultType) {}
+
+private:
+  const ExpressionArchive *m_Archive;
+  ProgramView m_Program;
+  std::span<const detail::ArchiveSlot> m_Slots;
+  TokenType m_ResultType;
+};
+
+/**
+ * archive written by writeArchive, mapped into memory. Expressions are evaluated in place, only
+ * the strings of the archive get interned once while loading and string literals are pointed at
+ * those. Instructions aren't checked on load, archives are expected to come from writeArchive,
+ * verify checks them completely.
+ * Not copyable, expressions can be evaluated concurrently like compiled expressions
+ */
+class ExpressionArchive {
+public:
+  static constexpr uint32_t s_Version = 1;
+
+public:
+  explicit ExpressionArchive(const std::string &path, SymbolTable &symbols = SymbolTable::defaultTable());
+  ~ExpressionArchive();
+
+  ExpressionArchive(const ExpressionArchive &) = delete;
+  ExpressionArchive &operator=(const ExpressionArchive &) = delete;
+
+  /**
+   * number of expressions, in the order they were written
+   */
+  [[nodiscard]] size_t size() const { return m_ExpressionCount; }
+
+  /**
+   * throws if the index is out of range or the record of the expression is damaged
+   */
+  [[nodiscard]] ArchivedExpression operator[](size_t index) const;
+
+  /**
+   * check the code of all expressions, throws on the first invalid instruction or if the code
+   * needs a deeper stack than the record declares. Evaluation trusts both, call this before
+   * evaluating archives that may not come from writeArchive
+   */
+  void verify() const;
+
+private:
+  friend class ArchivedExpression;
+
+  void load(SymbolTable &symbols);
+  void release();
+
+private:
+  void *m_Memory{nullptr};
+  size_t m_Size{0};
+  // set if the file was read rather than mapped
+  std::vector<uint64_t> m_Buffer;
+  size_t m_ExpressionCount{0};
+  const void *m_Expressions{nullptr};
+  std::span<const Instruction> m_Code;
+  std::span<const Token> m_Constants;
+  std::span<const detail::ArchiveSlot> m_Slots;
+  std::vector<const std::string *> m_Strings;
+  std::vector<const FunctionEntry *> m_Functions;
+};
+
+}
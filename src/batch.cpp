@@ -0,0 +1,282 @@
+#include "batch.h"
+
+#include "batch_kernels.h"
+#include "bytecode.h"
+#include "type_check.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <format>
+#include <stdexcept>
+#include <vector>
+
+namespace SYP {
+
+namespace {
+
+constexpr size_t s_BlockSize = 256;
+
+// words holding the bits of the values of a block of rows
+using Block = std::array<uint64_t, s_BlockSize>;
+
+/**
+ * true if every value in the program has a statically known, non-string type so it can be
+ * run column by column
+ */
+bool isColumnar(const Program &program) {
+  if ((program.resultType == TokenType::Undefined) || (program.resultType == TokenType::String)) {
+    return false;
+  }
+  for (auto type : program.slotTypes) {
+    if ((type == TokenType::Undefined) || (type == TokenType::String)) {
+      return false;
+    }
+  }
+  return std::none_of(program.code.begin(), program.code.end(), [&program](const Instruction &instruction) {
+    switch (instruction.code()) {
+    case OpCode::Operator:
+    case OpCode::Call:
+    case OpCode::ToBool:
+    case OpCode::AddStr:
+    case OpCode::EqStr:
+    case OpCode::NeStr:
+    case OpCode::LoadMemo:
+    case OpCode::StoreMemo:
+    case OpCode::Yield:
+      return true;
+    case OpCode::LoadConst:
+      return program.constants[instruction.operand()].type == TokenType::String;
+    default:
+      return false;
+    }
+  });
+}
+
+Token tokenAt(const Column &column, size_t row) {
+  switch (column.type) {
+  case TokenType::Signed: return Token(static_cast<const int64_t *>(column.data)[row]);
+  case TokenType::Unsigned: return Token(static_cast<const uint64_t *>(column.data)[row]);
+  case TokenType::Float: return Token(static_cast<const double *>(column.data)[row]);
+  case TokenType::Boolean: return Token(static_cast<const bool *>(column.data)[row]);
+  default: throw std::runtime_error("invalid column type");
+  }
+}
+
+void store(const OutputColumn &out, size_t row, const Token &value) {
+  if (value.type != out.type) {
+    throw std::runtime_error(std::format("result of type {} doesn't fit output column of type {}",
+                                         getTypeName(value.type), getTypeName(out.type)));
+  }
+  switch (out.type) {
+  case TokenType::Signed: static_cast<int64_t *>(out.data)[row] = value.signedValue; break;
+  case TokenType::Unsigned: static_cast<uint64_t *>(out.data)[row] = value.unsignedValue; break;
+  case TokenType::Float: static_cast<double *>(out.data)[row] = value.floatValue; break;
+  case TokenType::Boolean: static_cast<bool *>(out.data)[row] = value.boolValue; break;
+  default: throw std::runtime_error("invalid column type");
+  }
+}
+
+/**
+ * runs a typed program one instruction at a time over a block of rows using the vectorized
+ * kernels. Booleans are held as masks while the block is processed.
+ * Jumps don't skip anything here, every lane evaluates both sides and the results are combined
+ * where the jump target is reached
+ */
+class ColumnarRunner {
+public:
+  ColumnarRunner(const Program &program, std::span<const Column> columns, const BatchKernels &kernels)
+    : m_Program(program), m_Columns(columns), m_Kernels(kernels), m_Stack(program.stackSize) {}
+
+  void run(size_t offset, size_t count, const OutputColumn &out) {
+    m_Count = count;
+    m_Pending.clear();
+    Block *sp = m_Stack.data();
+
+    for (uint32_t pc = 0;; ++pc) {
+      while (!m_Pending.empty() && (m_Pending.back().target == pc)) {
+        sp = merge(sp);
+      }
+
+      const auto &instruction = m_Program.code[pc];
+      auto code = static_cast<size_t>(instruction.code());
+      if (auto binary = m_Kernels.binary[code]; binary != nullptr) {
+        binary(sp[-2].data(), sp[-1].data(), m_Count);
+        --sp;
+        continue;
+      }
+      if (auto unary = m_Kernels.unary[code]; unary != nullptr) {
+        unary(sp[-1].data(), m_Count);
+        continue;
+      }
+
+      switch (instruction.code()) {
+      case OpCode::Return:
+        store(sp[-1], offset, out);
+        return;
+      case OpCode::LoadConst: {
+        const auto &tok = m_Program.constants[instruction.operand()];
+        auto value = tok.type == TokenType::Boolean ? toMask(tok.boolValue) : tok.unsignedValue;
+        std::fill_n(sp->begin(), m_Count, value);
+        ++sp;
+        break;
+      }
+      case OpCode::LoadSlot:
+        load(m_Columns[instruction.operand()], offset, *sp);
+        ++sp;
+        break;
+      case OpCode::ConvI64ToU64:
+      case OpCode::ConvU64ToI64:
+        // same bits
+        break;
+      case OpCode::JumpIfFalseOrPop:
+      case OpCode::JumpIfTrueOrPop:
+      case OpCode::JumpIfFalse: {
+        // the condition is kept aside until the jump target combines it with what follows
+        auto kind = instruction.code() == OpCode::JumpIfFalseOrPop ? OpCode::AndBool
+                    : instruction.code() == OpCode::JumpIfTrueOrPop ? OpCode::OrBool
+                                                                    : OpCode::JumpIfFalse;
+        if (m_Saved.size() <= m_Pending.size()) {
+          m_Saved.resize(m_Pending.size() + 1);
+        }
+        m_Saved[m_Pending.size()] = *--sp;
+        m_Pending.push_back(Pending{ instruction.operand(), kind });
+        break;
+      }
+      case OpCode::Jump:
+        // end of the true branch of a conditional, the false branch follows directly and the
+        // two get blended at the target
+        m_Pending.back() = Pending{ instruction.operand(), OpCode::Jump };
+        break;
+      default:
+        throw std::runtime_error(std::format("unsupported opcode {} in batch", static_cast<int>(instruction.code())));
+      }
+    }
+  }
+
+private:
+  struct Pending {
+    uint32_t target;
+    // AndBool/OrBool to combine the saved condition with the top of the stack, Jump to blend
+    // the two branches of a conditional
+    OpCode merge;
+  };
+
+private:
+  static uint64_t toMask(bool value) { return value ? ~uint64_t(0) : uint64_t(0); }
+
+  Block *merge(Block *sp) {
+    auto pending = m_Pending.back();
+    m_Pending.pop_back();
+    auto &saved = m_Saved[m_Pending.size()];
+
+    if (pending.merge == OpCode::Jump) {
+      m_Kernels.select(sp[-2].data(), saved.data(), sp[-1].data(), m_Count);
+      return sp - 1;
+    } else if (pending.merge == OpCode::JumpIfFalse) {
+      throw std::runtime_error("conditional without end in batch");
+    }
+    m_Kernels.binary[static_cast<size_t>(pending.merge)](sp[-1].data(), saved.data(), m_Count);
+    return sp;
+  }
+
+  void load(const Column &column, size_t offset, Block &block) const {
+    switch (column.type) {
+    case TokenType::Signed:
+    case TokenType::Unsigned:
+    case TokenType::Float:
+      // all 64 bit values, the kernels interpret the bits
+      std::memcpy(block.data(), static_cast<const uint64_t *>(column.data) + offset, m_Count * sizeof(uint64_t));
+      break;
+    case TokenType::Boolean: {
+      const auto *values = static_cast<const bool *>(column.data) + offset;
+      for (size_t i = 0; i < m_Count; ++i) {
+        block[i] = toMask(values[i]);
+      }
+      break;
+    }
+    default:
+      throw std::runtime_error("invalid column type");
+    }
+  }
+
+  void store(const Block &block, size_t offset, const OutputColumn &out) const {
+    switch (out.type) {
+    case TokenType::Signed:
+    case TokenType::Unsigned:
+    case TokenType::Float:
+      std::memcpy(static_cast<uint64_t *>(out.data) + offset, block.data(), m_Count * sizeof(uint64_t));
+      break;
+    case TokenType::Boolean: {
+      auto *values = static_cast<bool *>(out.data) + offset;
+      for (size_t i = 0; i < m_Count; ++i) {
+        values[i] = block[i] != 0;
+      }
+      break;
+    }
+    default:
+      throw std::runtime_error("invalid column type");
+    }
+  }
+
+private:
+  const Program &m_Program;
+  std::span<const Column> m_Columns;
+  const BatchKernels &m_Kernels;
+  std::vector<Block> m_Stack;
+  // conditions of the jumps that haven't reached their target yet, one per pending entry
+  std::vector<Block> m_Saved;
+  std::vector<Pending> m_Pending;
+  size_t m_Count{0};
+};
+
+}
+
+void evaluateBatch(const CompiledExpression &expr, std::span<const Column> columns, size_t count,
+                   OutputColumn out) {
+  Workspace workspace;
+  evaluateBatch(expr, columns, count, out, workspace);
+}
+
+void evaluateBatch(const CompiledExpression &expr, std::span<const Column> columns, size_t count,
+                   OutputColumn out, Workspace &workspace) {
+  const auto &program = expr.program();
+
+  if (columns.size() < program.slots.size()) {
+    throw std::runtime_error(std::format("expected {} columns, got {}", program.slots.size(), columns.size()));
+  }
+  for (size_t i = 0; i < program.slots.size(); ++i) {
+    if (program.functionSlots[i]) {
+      throw std::runtime_error(std::format("function {} can't be called in a batch", program.slots[i]));
+    }
+    if ((columns[i].data == nullptr) && (count > 0)) {
+      throw std::runtime_error(std::format("no column for {}", program.slots[i]));
+    }
+    if ((program.slotTypes[i] != TokenType::Undefined) && (columns[i].type != program.slotTypes[i])) {
+      throw std::runtime_error(std::format("{} declared as {} but column is {}", program.slots[i],
+                                           getTypeName(program.slotTypes[i]), getTypeName(columns[i].type)));
+    }
+  }
+
+  if (isColumnar(program)) {
+    if (program.resultType != out.type) {
+      throw std::runtime_error(std::format("result of type {} doesn't fit output column of type {}",
+                                           getTypeName(program.resultType), getTypeName(out.type)));
+    }
+    ColumnarRunner runner(program, columns, batchKernels());
+    for (size_t offset = 0; offset < count; offset += s_BlockSize) {
+      runner.run(offset, std::min(s_BlockSize, count - offset), out);
+    }
+    return;
+  }
+
+  std::vector<Token> slots(program.slots.size());
+  for (size_t row = 0; row < count; ++row) {
+    for (size_t i = 0; i < slots.size(); ++i) {
+      slots[i] = tokenAt(columns[i], row);
+    }
+    store(out, row, execute(program, slots, workspace));
+  }
+}
+
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+#include "compiled_expression.h"
+#include "token.h"
+
+namespace SYP {
+
+/**
+ * contiguous values of one variable, row i of a batch reads data[i]
+ */
+struct Column {
+  TokenType type{TokenType::Undefined};
+  const void *data{nullptr};
+
+  Column() = default;
+  Column(const int64_t *values) : type(TokenType::Signed), data(values) {}
+  Column(const uint64_t *values) : type(TokenType::Unsigned), data(values) {}
+  Column(const double *values) : type(TokenType::Float), data(values) {}
+  Column(const bool *values) : type(TokenType::Boolean), data(values) {}
+
+  /**
+   * the rows of this column starting at the specified one
+   */
+  [[nodiscard]] Column from(size_t row) const {
+    Column result(*this);
+    if (data != nullptr) {
+      result.data = static_cast<const char *>(data) + row * elementSize(type);
+    }
+    return result;
+  }
+
+  [[nodiscard]] static size_t elementSize(TokenType type) {
+    return type == TokenType::Boolean ? sizeof(bool) : sizeof(uint64_t);
+  }
+};
+
+/**
+ * destination for the results of a batch, needs room for one value per row
+ */
+struct OutputColumn {
+  TokenType type{TokenType::Undefined};
+  void *data{nullptr};
+
+  OutputColumn(int64_t *values) : type(TokenType::Signed), data(values) {}
+  OutputColumn(uint64_t *values) : type(TokenType::Unsigned), data(values) {}
+  OutputColumn(double *values) : type(TokenType::Float), data(values) {}
+  OutputColumn(bool *values) : type(TokenType::Boolean), data(values) {}
+
+  [[nodiscard]] OutputColumn from(size_t row) const {
+    OutputColumn result(*this);
+    result.data = static_cast<char *>(data) + row * Column::elementSize(type);
+    return result;
+  }
+};
+
+/**
+ * evaluate an expression for count rows. columns holds one column per slot of the expression, in
+ * slot order. If every variable has a declared type the program is run one instruction at a time
+ * over blocks of rows, otherwise it falls back to running the program row by row. Either way the
+ * setup happens once per batch.
+ * Both ways give the same results, integer division by zero and INT64_MIN / -1 produce 0 as in
+ * every other evaluation (see divideInteger).
+ * Function calls and strings are not supported, throws if the result doesn't match the type of
+ * the output column
+ */
+void evaluateBatch(const CompiledExpression &expr, std::span<const Column> columns, size_t count,
+                   OutputColumn out);
+
+/**
+ * evaluate a batch using the scratch memory of the specified workspace for rows that have to be
+ * run one at a time
+ */
+void evaluateBatch(const CompiledExpression &expr, std::span<const Column> columns, size_t count,
+                   OutputColumn out, Workspace &workspace);
+
+}
@@ -0,0 +1,253 @@
+#include "batch_kernels.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+// one copy of the kernels per instruction set, selected when the program starts
+#define PAGAN_SIMD_X86
+#endif
+
+#if defined(__GNUC__)
+#define PAGAN_ALWAYS_INLINE __attribute__((always_inline)) inline
+#else
+#define PAGAN_ALWAYS_INLINE __forceinline
+#endif
+
+namespace SYP {
+
+namespace {
+
+// every function touching vectors carries the target of its kernels and is always inlined, so
+// no vector crosses a call between code compiled for different instruction sets. Each tier
+// defines PAGAN_KERNEL_TARGET before expanding the macros below
+#define PAGAN_VECTOR_INLINE PAGAN_KERNEL_TARGET PAGAN_ALWAYS_INLINE
+
+/**
+ * one value per "vector", used where no vector extensions are available
+ */
+#define PAGAN_SCALAR_TRAITS()                                                  \
+  struct Traits {                                                              \
+    using I = int64_t;                                                         \
+    using U = uint64_t;                                                        \
+    using F = double;                                                          \
+                                                                               \
+    static PAGAN_VECTOR_INLINE U mask(bool value) { return value ? ~U(0) : U(0); } \
+    static PAGAN_VECTOR_INLINE F toFloat(I value) { return static_cast<F>(value); } \
+    static PAGAN_VECTOR_INLINE F toFloat(U value) { return static_cast<F>(value); } \
+  };
+
+// gcc doesn't handle vector_size depending on a template parameter, hence the macro
+#define PAGAN_VECTOR_TRAITS(bytes)                                             \
+  struct Traits {                                                              \
+    typedef int64_t I __attribute__((vector_size(bytes)));                     \
+    typedef uint64_t U __attribute__((vector_size(bytes)));                    \
+    typedef double F __attribute__((vector_size(bytes)));                      \
+                                                                               \
+    /* comparisons on vectors already produce masks */                         \
+    static PAGAN_VECTOR_INLINE U mask(I value) { return __builtin_bit_cast(U, value); } \
+    static PAGAN_VECTOR_INLINE F toFloat(I value) { return __builtin_convertvector(value, F); } \
+    static PAGAN_VECTOR_INLINE F toFloat(U value) { return __builtin_convertvector(value, F); } \
+  };
+
+// loops applying an operation to count words, the last partial vector is padded with zeros.
+// Integer division can't trap on the zero lanes of padding and of rows that a conditional
+// doesn't select, those divide by one and produce zero instead, matching divideInteger
+#define PAGAN_DEFINE_HELPERS()                                                 \
+  using U = Traits::U;                                                         \
+  constexpr size_t width = sizeof(U) / sizeof(uint64_t);                       \
+                                                                               \
+  template <typename Arg, typename Op>                                         \
+  PAGAN_VECTOR_INLINE void binaryLoop(uint64_t *lhs, const uint64_t *rhs, size_t count, Op op) { \
+    size_t i = 0;                                                              \
+    for (; i + width <= count; i += width) {                                   \
+      Arg a;                                                                   \
+      Arg b;                                                                   \
+      std::memcpy(&a, lhs + i, sizeof(U));                                     \
+      std::memcpy(&b, rhs + i, sizeof(U));                                     \
+      auto result = __builtin_bit_cast(U, op(a, b));                           \
+      std::memcpy(lhs + i, &result, sizeof(U));                                \
+    }                                                                          \
+    if (i < count) {                                                           \
+      uint64_t a[width] = {};                                                  \
+      uint64_t b[width] = {};                                                  \
+      std::memcpy(a, lhs + i, (count - i) * sizeof(uint64_t));                 \
+      std::memcpy(b, rhs + i, (count - i) * sizeof(uint64_t));                 \
+      auto result = __builtin_bit_cast(U, op(__builtin_bit_cast(Arg, a), __builtin_bit_cast(Arg, b))); \
+      std::memcpy(lhs + i, &result, (count - i) * sizeof(uint64_t));           \
+    }                                                                          \
+  }                                                                            \
+                                                                               \
+  template <typename Arg, typename Op>                                         \
+  PAGAN_VECTOR_INLINE void unaryLoop(uint64_t *values, size_t count, Op op) {  \
+    size_t i = 0;                                                              \
+    for (; i + width <= count; i += width) {                                   \
+      Arg value;                                                               \
+      std::memcpy(&value, values + i, sizeof(U));                              \
+      auto result = __builtin_bit_cast(U, op(value));                          \
+      std::memcpy(values + i, &result, sizeof(U));                             \
+    }                                                                          \
+    if (i < count) {                                                           \
+      uint64_t value[width] = {};                                              \
+      std::memcpy(value, values + i, (count - i) * sizeof(uint64_t));          \
+      auto result = __builtin_bit_cast(U, op(__builtin_bit_cast(Arg, value))); \
+      std::memcpy(values + i, &result, (count - i) * sizeof(uint64_t));        \
+    }                                                                          \
+  }                                                                            \
+                                                                               \
+  PAGAN_VECTOR_INLINE void selectLoop(uint64_t *result, const uint64_t *mask, const uint64_t *other, size_t count) { \
+    for (size_t i = 0; i < count; i += width) {                                \
+      auto len = std::min(width, count - i) * sizeof(uint64_t);                \
+      U a{};                                                                   \
+      U m{};                                                                   \
+      U b{};                                                                   \
+      std::memcpy(&a, result + i, len);                                        \
+      std::memcpy(&m, mask + i, len);                                          \
+      std::memcpy(&b, other + i, len);                                         \
+      U blended = (a & m) | (b & ~m);                                          \
+      std::memcpy(result + i, &blended, len);                                  \
+    }                                                                          \
+  }                                                                            \
+                                                                               \
+  PAGAN_VECTOR_INLINE Traits::I divideSigned(Traits::I a, Traits::I b) {       \
+    using I = Traits::I;                                                       \
+    auto invalid = __builtin_bit_cast(I, Traits::mask(b == 0) |                \
+                                         (Traits::mask(b == -1) & Traits::mask(a == std::numeric_limits<int64_t>::min()))); \
+    return (a / (b + (invalid & (1 - b)))) & ~invalid;                         \
+  }                                                                            \
+                                                                               \
+  PAGAN_VECTOR_INLINE Traits::U divideUnsigned(Traits::U a, Traits::U b, bool modulo) { \
+    auto zero = Traits::mask(b == 0);                                          \
+    auto divisor = b | (zero & 1);                                             \
+    return (modulo ? a % divisor : a / divisor) & ~zero;                       \
+  }
+
+// X(opcode, operand type, expression on a and b)
+#define PAGAN_BINARY_KERNELS(X)                                                \
+  X(AddI64, I, a + b) X(AddU64, U, a + b) X(AddF64, F, a + b)                  \
+  X(SubI64, I, a - b) X(SubU64, U, a - b) X(SubF64, F, a - b)                  \
+  X(MulI64, I, a * b) X(MulU64, U, a * b) X(MulF64, F, a * b)                  \
+  X(DivI64, I, divideSigned(a, b))                                             \
+  X(DivU64, U, divideUnsigned(a, b, false))                                    \
+  X(DivF64, F, a / b)                                                          \
+  X(ModU64, U, divideUnsigned(a, b, true))                                     \
+  X(ShlI64, U, a << b) X(ShlU64, U, a << b) X(ShrU64, U, a >> b)               \
+  X(XorU64, U, a ^ b) X(AndU64, U, a & b) X(OrU64, U, a | b)                   \
+  X(LtI64, I, Traits::mask(a < b)) X(LtU64, U, Traits::mask(a < b))            \
+  X(LtF64, F, Traits::mask(a < b))                                             \
+  X(LeI64, I, Traits::mask(a <= b)) X(LeU64, U, Traits::mask(a <= b))          \
+  X(LeF64, F, Traits::mask(a <= b))                                            \
+  X(GtI64, I, Traits::mask(a > b)) X(GtU64, U, Traits::mask(a > b))            \
+  X(GtF64, F, Traits::mask(a > b))                                             \
+  X(GeI64, I, Traits::mask(a >= b)) X(GeU64, U, Traits::mask(a >= b))          \
+  X(GeF64, F, Traits::mask(a >= b))                                            \
+  X(EqI64, I, Traits::mask(a == b)) X(EqU64, U, Traits::mask(a == b))          \
+  X(EqF64, F, Traits::mask(a == b))                                            \
+  X(NeI64, I, Traits::mask(a != b)) X(NeU64, U, Traits::mask(a != b))          \
+  X(NeF64, F, Traits::mask(a != b))                                            \
+  X(EqBool, U, ~(a ^ b)) X(NeBool, U, a ^ b)                                   \
+  X(AndBool, U, a & b) X(OrBool, U, a | b)
+
+// X(opcode, operand type, expression on a)
+#define PAGAN_UNARY_KERNELS(X)                                                 \
+  X(NotBool, U, ~a)                                                            \
+  X(ConvI64ToF64, I, Traits::toFloat(a)) X(ConvU64ToF64, U, Traits::toFloat(a)) \
+  X(ConvIntToBool, U, Traits::mask(a != 0))
+
+// the operations are function objects rather than lambdas, the function pointer conversion of a
+// lambda would be a function taking vectors without the kernel target
+#define PAGAN_DEFINE_BINARY_KERNEL(name, type, expr)                           \
+  struct name##Op {                                                            \
+    using Arg = Traits::type;                                                  \
+    PAGAN_VECTOR_INLINE auto operator()(Arg a, Arg b) const { return expr; }   \
+  };                                                                           \
+  PAGAN_KERNEL_TARGET void name(uint64_t *lhs, const uint64_t *rhs, size_t count) { \
+    binaryLoop<name##Op::Arg>(lhs, rhs, count, name##Op{});                    \
+  }
+
+#define PAGAN_DEFINE_UNARY_KERNEL(name, type, expr)                            \
+  struct name##Op {                                                            \
+    using Arg = Traits::type;                                                  \
+    PAGAN_VECTOR_INLINE auto operator()(Arg a) const { return expr; }          \
+  };                                                                           \
+  PAGAN_KERNEL_TARGET void name(uint64_t *values, size_t count) {              \
+    unaryLoop<name##Op::Arg>(values, count, name##Op{});                       \
+  }
+
+#define PAGAN_SET_BINARY_KERNEL(name, type, expr) kernels.binary[static_cast<size_t>(OpCode::name)] = &name;
+#define PAGAN_SET_UNARY_KERNEL(name, type, expr) kernels.unary[static_cast<size_t>(OpCode::name)] = &name;
+
+// defines the helpers and every kernel for the Traits and PAGAN_KERNEL_TARGET in effect, and a
+// table of them
+#define PAGAN_DEFINE_KERNELS(tierName)                                         \
+  PAGAN_DEFINE_HELPERS()                                                       \
+  PAGAN_BINARY_KERNELS(PAGAN_DEFINE_BINARY_KERNEL)                             \
+  PAGAN_UNARY_KERNELS(PAGAN_DEFINE_UNARY_KERNEL)                               \
+  PAGAN_KERNEL_TARGET void select(uint64_t *result, const uint64_t *mask, const uint64_t *other, size_t count) { \
+    selectLoop(result, mask, other, count);                                    \
+  }                                                                            \
+  BatchKernels makeKernels() {                                                 \
+    BatchKernels kernels{ tierName, {}, {}, &select };                         \
+    PAGAN_BINARY_KERNELS(PAGAN_SET_BINARY_KERNEL)                              \
+    PAGAN_UNARY_KERNELS(PAGAN_SET_UNARY_KERNEL)                                \
+    return kernels;                                                            \
+  }                                                                            \
+  const BatchKernels s_Kernels = makeKernels();
+
+namespace scalar {
+#define PAGAN_KERNEL_TARGET
+PAGAN_SCALAR_TRAITS()
+PAGAN_DEFINE_KERNELS("scalar")
+#undef PAGAN_KERNEL_TARGET
+}
+
+#ifdef PAGAN_SIMD_X86
+namespace sse42 {
+#define PAGAN_KERNEL_TARGET __attribute__((target("sse4.2")))
+PAGAN_VECTOR_TRAITS(16)
+PAGAN_DEFINE_KERNELS("sse4.2")
+#undef PAGAN_KERNEL_TARGET
+}
+
+namespace avx2 {
+#define PAGAN_KERNEL_TARGET __attribute__((target("avx2")))
+PAGAN_VECTOR_TRAITS(32)
+PAGAN_DEFINE_KERNELS("avx2")
+#undef PAGAN_KERNEL_TARGET
+}
+
+namespace avx512 {
+#define PAGAN_KERNEL_TARGET __attribute__((target("avx512f,avx512dq")))
+PAGAN_VECTOR_TRAITS(64)
+PAGAN_DEFINE_KERNELS("avx512")
+#undef PAGAN_KERNEL_TARGET
+}
+#endif
+
+}
+
+const BatchKernels &batchKernels() {
+  static const BatchKernels &s_Best = *supportedBatchKernels().front();
+  return s_Best;
+}
+
+std::vector<const BatchKernels *> supportedBatchKernels() {
+  std::vector<const BatchKernels *> result;
+#ifdef PAGAN_SIMD_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512dq")) {
+    result.push_back(&avx512::s_Kernels);
+  }
+  if (__builtin_cpu_supports("avx2")) {
+    result.push_back(&avx2::s_Kernels);
+  }
+  if (__builtin_cpu_supports("sse4.2")) {
+    result.push_back(&sse42::s_Kernels);
+  }
+#endif
+  result.push_back(&scalar::s_Kernels);
+  return result;
+}
+
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "bytecode.h"
+
+namespace SYP {
+
+/**
+ * kernels run over columns of 64 bit words holding the bit patterns of int64_t, uint64_t or
+ * double values. Booleans are masks, all bits set for true and no bits set for false
+ */
+using BinaryKernel = void (*)(uint64_t *lhs, const uint64_t *rhs, size_t count);
+using UnaryKernel = void (*)(uint64_t *values, size_t count);
+// result[i] = mask[i] ? result[i] : other[i]
+using SelectKernel = void (*)(uint64_t *result, const uint64_t *mask, const uint64_t *other, size_t count);
+
+/**
+ * implementations of the typed opcodes for one instruction set
+ */
+struct BatchKernels {
+  const char *name;
+  // indexed by opcode, nullptr for opcodes that don't have a kernel of that kind
+  BinaryKernel binary[static_cast<size_t>(OpCode::OpCodeCount)];
+  UnaryKernel unary[static_cast<size_t>(OpCode::OpCodeCount)];
+  SelectKernel select;
+};
+
+/**
+ * the fastest kernels supported by the cpu this runs on
+ */
+[[nodiscard]] const BatchKernels &batchKernels();
+
+/**
+ * all kernel sets the cpu supports, fastest first. The last one is always the portable scalar
+ * implementation
+ */
+[[nodiscard]] std::vector<const BatchKernels *> supportedBatchKernels();
+
+}
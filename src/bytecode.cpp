@@ -0,0 +1,539 @@
+#include "bytecode.h"
+
+#include "evaluate.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <format>
+#include <stdexcept>
+#include <unordered_map>
+
+#if defined(__GNUC__)
+// labels as values let every instruction dispatch the next one directly
+#define PAGAN_COMPUTED_GOTO
+#endif
+
+namespace SYP {
+
+namespace {
+
+// operands are resolved before they are placed on the stack so operators never call these
+const std::function<Token(const std::string &)> s_Unresolved = noVariables;
+const std::function<void(const std::string &, const Token &)> s_NoAssign = noAssign;
+
+/**
+ * truth value of a condition, integers are true if they are non-zero
+ */
+bool isTrue(const Token &tok) {
+  switch (tok.type) {
+  case TokenType::Boolean: return tok.boolValue;
+  case TokenType::Signed:
+  case TokenType::Unsigned: return tok.unsignedValue != 0;
+  default: throw std::runtime_error("invalid token type for logical");
+  }
+}
+
+OpCode typedOpCode(OperatorType op, TokenType type) {
+  auto pick = [type](OpCode i64, OpCode u64, OpCode f64) {
+    switch (type) {
+    case TokenType::Signed: return i64;
+    case TokenType::Unsigned: return u64;
+    case TokenType::Float: return f64;
+    default: return OpCode::Operator;
+    }
+  };
+
+  switch (op) {
+  case OperatorType::Add:
+    return type == TokenType::String ? OpCode::AddStr : pick(OpCode::AddI64, OpCode::AddU64, OpCode::AddF64);
+  case OperatorType::Subtract: return pick(OpCode::SubI64, OpCode::SubU64, OpCode::SubF64);
+  case OperatorType::Multiply: return pick(OpCode::MulI64, OpCode::MulU64, OpCode::MulF64);
+  case OperatorType::Divide: return pick(OpCode::DivI64, OpCode::DivU64, OpCode::DivF64);
+  // integer operators work on the unsigned representation for both signed and unsigned
+  case OperatorType::Modulo: return pick(OpCode::ModU64, OpCode::ModU64, OpCode::Operator);
+  // signed operands only remain for shifts introduced by strength reduction, those keep the type
+  case OperatorType::ShiftLeft: return pick(OpCode::ShlI64, OpCode::ShlU64, OpCode::Operator);
+  case OperatorType::ShiftRight: return pick(OpCode::ShrU64, OpCode::ShrU64, OpCode::Operator);
+  case OperatorType::Xor: return pick(OpCode::XorU64, OpCode::XorU64, OpCode::Operator);
+  case OperatorType::BitwiseAnd: return pick(OpCode::AndU64, OpCode::AndU64, OpCode::Operator);
+  case OperatorType::BitwiseOr: return pick(OpCode::OrU64, OpCode::OrU64, OpCode::Operator);
+  case OperatorType::LessThan: return pick(OpCode::LtI64, OpCode::LtU64, OpCode::LtF64);
+  case OperatorType::LessOrEqual: return pick(OpCode::LeI64, OpCode::LeU64, OpCode::LeF64);
+  case OperatorType::GreaterThan: return pick(OpCode::GtI64, OpCode::GtU64, OpCode::GtF64);
+  case OperatorType::GreaterOrEqual: return pick(OpCode::GeI64, OpCode::GeU64, OpCode::GeF64);
+  case OperatorType::Equal:
+    if (type == TokenType::Boolean) {
+      return OpCode::EqBool;
+    } else if (type == TokenType::String) {
+      return OpCode::EqStr;
+    }
+    return pick(OpCode::EqI64, OpCode::EqU64, OpCode::EqF64);
+  case OperatorType::NotEqual:
+    if (type == TokenType::Boolean) {
+      return OpCode::NeBool;
+    } else if (type == TokenType::String) {
+      return OpCode::NeStr;
+    }
+    return pick(OpCode::NeI64, OpCode::NeU64, OpCode::NeF64);
+  case OperatorType::LogicalAnd: return type == TokenType::Boolean ? OpCode::AndBool : OpCode::Operator;
+  case OperatorType::LogicalOr: return type == TokenType::Boolean ? OpCode::OrBool : OpCode::Operator;
+  default: return OpCode::Operator;
+  }
+}
+
+OpCode conversionOpCode(TokenType from, TokenType to) {
+  if (to == TokenType::Float) {
+    if (from == TokenType::Signed) {
+      return OpCode::ConvI64ToF64;
+    } else if (from == TokenType::Unsigned) {
+      return OpCode::ConvU64ToF64;
+    }
+  } else if ((to == TokenType::Unsigned) && (from == TokenType::Signed)) {
+    return OpCode::ConvI64ToU64;
+  } else if ((to == TokenType::Signed) && (from == TokenType::Unsigned)) {
+    return OpCode::ConvU64ToI64;
+  } else if ((to == TokenType::Boolean) && ((from == TokenType::Signed) || (from == TokenType::Unsigned))) {
+    return OpCode::ConvIntToBool;
+  }
+  throw std::runtime_error(std::format("no conversion from {} to {}", getTypeName(from), getTypeName(to)));
+}
+
+class Emitter {
+public:
+  Emitter(const ExpressionTree &tree, Program &program, std::span<const uint32_t> memo = {})
+    : m_Tree(tree), m_Program(program), m_Memo(memo) {}
+
+  void node(uint32_t idx) {
+    if (m_Memo.empty() || (m_Memo[idx] == 0)) {
+      value(idx);
+      return;
+    }
+    // the first use computes the value, every later one loads it and jumps past the computation
+    uint32_t memo = m_Memo[idx] - 1;
+    emit(OpCode::LoadMemo, memo, 0);
+    auto toEnd = emit(OpCode::Jump, 0, 0);
+    value(idx);
+    emit(OpCode::StoreMemo, memo, 0);
+    patch(toEnd);
+    m_Program.memoCount = std::max<size_t>(m_Program.memoCount, memo + 1);
+  }
+
+  void value(uint32_t idx) {
+    const auto &node = m_Tree.nodes[idx];
+    switch (node.kind) {
+    case NodeKind::Constant: {
+      // only constants still referenced after optimization end up in the program
+      auto [iter, added] = m_Constants.emplace(node.index, static_cast<uint32_t>(m_Program.constants.size()));
+      if (added) {
+        m_Program.constants.push_back(m_Tree.constants[node.index]);
+      }
+      emit(OpCode::LoadConst, iter->second, 1);
+      break;
+    }
+    case NodeKind::Slot:
+      emit(OpCode::LoadSlot, node.index, 1);
+      break;
+    case NodeKind::Call:
+      emit(OpCode::LoadSlot, node.index, 1);
+      for (auto operand : node.operands) {
+        this->node(operand);
+      }
+      emit(OpCode::Call, static_cast<uint32_t>(node.operands.size()), -static_cast<int>(node.operands.size()));
+      break;
+    case NodeKind::Convert:
+      this->node(node.operands[0]);
+      emit(conversionOpCode(m_Tree.nodes[node.operands[0]].type, node.type), 0, 0);
+      break;
+    case NodeKind::Conditional: {
+      // only the selected branch is evaluated
+      this->node(node.operands[0]);
+      auto toElse = emit(OpCode::JumpIfFalse, 0, -1);
+      auto depth = m_Depth;
+      this->node(node.operands[1]);
+      auto toEnd = emit(OpCode::Jump, 0, 0);
+      m_Depth = depth;
+      patch(toElse);
+      this->node(node.operands[2]);
+      patch(toEnd);
+      break;
+    }
+    case NodeKind::Operator:
+      if (((node.op == OperatorType::LogicalAnd) || (node.op == OperatorType::LogicalOr)) &&
+          needsShortCircuit(node)) {
+        // the right operand is skipped if the left one decides the result, which is then
+        // left on the stack
+        this->node(node.operands[0]);
+        auto toEnd = emit(node.op == OperatorType::LogicalAnd ? OpCode::JumpIfFalseOrPop : OpCode::JumpIfTrueOrPop,
+                          0, -1);
+        this->node(node.operands[1]);
+        if (m_Tree.nodes[node.operands[1]].type != TokenType::Boolean) {
+          emit(OpCode::ToBool, 0, 0);
+        }
+        patch(toEnd);
+      } else if (node.op == OperatorType::LogicalNot) {
+        this->node(node.operands[0]);
+        auto code = m_Tree.nodes[node.operands[0]].type == TokenType::Boolean ? OpCode::NotBool : OpCode::Operator;
+        emit(code, static_cast<uint32_t>(node.op), 0);
+      } else {
+        this->node(node.operands[0]);
+        this->node(node.operands[1]);
+        auto lhs = m_Tree.nodes[node.operands[0]].type;
+        auto rhs = m_Tree.nodes[node.operands[1]].type;
+        // the type checker has converted operands to a common type where possible
+        auto code = ((lhs == rhs) && (lhs != TokenType::Undefined)) ? typedOpCode(node.op, lhs) : OpCode::Operator;
+        emit(code, static_cast<uint32_t>(node.op), -1);
+      }
+      break;
+    }
+  }
+
+  size_t emit(OpCode code, uint32_t operand, int stackEffect) {
+    m_Program.code.push_back(Instruction{ code, operand });
+    m_Depth += stackEffect;
+    m_Program.stackSize = std::max(m_Program.stackSize, m_Depth);
+    return m_Program.code.size() - 1;
+  }
+
+  /**
+   * make the jump at the specified position target the next instruction
+   */
+  void patch(size_t jump) {
+    m_Program.code[jump].setOperand(static_cast<uint32_t>(m_Program.code.size()));
+  }
+
+private:
+  /**
+   * a branch is only worth it if skipping the right operand saves more than the jump costs
+   */
+  [[nodiscard]] bool needsShortCircuit(const Node &node) const {
+    const auto &lhs = m_Tree.nodes[node.operands[0]];
+    const auto &rhs = m_Tree.nodes[node.operands[1]];
+    bool cheap = (rhs.kind == NodeKind::Constant) || (rhs.kind == NodeKind::Slot);
+    return !cheap || (lhs.type != TokenType::Boolean) || (rhs.type != TokenType::Boolean);
+  }
+
+
+  const ExpressionTree &m_Tree;
+  Program &m_Program;
+  std::span<const uint32_t> m_Memo;
+  std::unordered_map<uint32_t, uint32_t> m_Constants;
+  size_t m_Depth{0};
+};
+
+/**
+ * terminate the code and copy the slots. Programs are kept around in large numbers so the
+ * growth slack of the vectors is released
+ */
+void finish(const ExpressionTree &tree, Program &program) {
+  program.code.push_back(Instruction{ OpCode::Return, 0 });
+  program.code.shrink_to_fit();
+  program.constants.shrink_to_fit();
+  program.slots = tree.slots;
+  program.functionSlots = tree.functionSlots;
+  program.slotTypes = tree.slotTypes;
+}
+
+}
+
+OperatorType getOperatorType(OpCode code) {
+  static constexpr OperatorType s_Operators[] = {
+#define PAGAN_OPCODE_OPERATOR(name, op) OperatorType::op,
+      PAGAN_OPCODES(PAGAN_OPCODE_OPERATOR)
+#undef PAGAN_OPCODE_OPERATOR
+  };
+  return s_Operators[static_cast<size_t>(code)];
+}
+
+Program compile(const TokenQueue &tokens, const VariableTypes &types) {
+  auto tree = buildTree(tokens);
+  typeCheck(tree, types);
+  optimize(tree);
+  return compile(tree);
+}
+
+Program compile(const ExpressionTree &tree) {
+  return compile(tree, tree.root);
+}
+
+Program compile(const ExpressionTree &tree, uint32_t root) {
+  Program program;
+  Emitter(tree, program).node(root);
+  finish(tree, program);
+  program.resultType = tree.nodes[root].type;
+  return program;
+}
+
+Program compile(const ExpressionTree &tree, std::span<const uint32_t> roots, std::span<const uint32_t> memo) {
+  Program program;
+  Emitter emitter(tree, program, memo);
+  for (auto root : roots) {
+    emitter.node(root);
+    emitter.emit(OpCode::Yield, 0, -1);
+  }
+  finish(tree, program);
+  program.yieldCount = roots.size();
+  return program;
+}
+
+std::vector<Token> bindSlots(const Program &program, const std::function<Token(const std::string &)> &resolve) {
+  std::vector<Token> slots;
+  slots.reserve(program.slots.size());
+  for (size_t i = 0; i < program.slots.size(); ++i) {
+    auto tok = resolve(program.slots[i]);
+    if (program.functionSlots[i]) {
+      tok.type = TokenType::Function;
+    } else if ((program.slotTypes[i] != TokenType::Undefined) && (tok.type != program.slotTypes[i])) {
+      throw std::runtime_error(std::format("{} declared as {} but resolved to {}", program.slots[i],
+                                           getTypeName(program.slotTypes[i]), getTypeName(tok.type)));
+    }
+    slots.push_back(tok);
+  }
+  return slots;
+}
+
+#ifdef PAGAN_COMPUTED_GOTO
+#define VM_DISPATCH() goto *s_Labels[static_cast<size_t>(ip->code())]
+#define VM_CASE(name) label_##name
+#define VM_NEXT()                                                              \
+  ++ip;                                                                        \
+  VM_DISPATCH();
+#else
+#define VM_DISPATCH() switch (ip->code())
+#define VM_CASE(name) case OpCode::name
+#define VM_NEXT()                                                              \
+  ++ip;                                                                        \
+  continue;
+#endif
+
+#ifdef PAGAN_COMPUTED_GOTO
+#define VM_JUMP(target)                                                        \
+  ip = code + (target);                                                        \
+  VM_DISPATCH();
+#else
+#define VM_JUMP(target)                                                        \
+  ip = code + (target);                                                        \
+  continue;
+#endif
+
+#define VM_BINARY_EXPR(expr)                                                   \
+  {                                                                            \
+    [[maybe_unused]] const Token &lhs = sp[-2];                                \
+    [[maybe_unused]] const Token &rhs = sp[-1];                                \
+    Token result(expr);                                                        \
+    PAGAN_TRACE_OPERATION(getOperatorType(ip->code()),                         \
+                          std::span<const Token>(sp - 2, 2), result);          \
+    *(--sp - 1) = result;                                                      \
+  }                                                                            \
+  VM_NEXT();
+
+#define VM_BINARY(member, op) VM_BINARY_EXPR(lhs.member op rhs.member)
+
+#define VM_CONVERT(expr)                                                       \
+  sp[-1] = Token(expr);                                                        \
+  VM_NEXT();
+
+namespace {
+
+/**
+ * yielded results are placed right above the stack, followed by the memoized values unless the
+ * caller keeps those
+ */
+Token run(const ProgramView &program, std::span<const Token> slots, Token *memo, Workspace &workspace) {
+  size_t memoCount = memo != nullptr ? 0 : program.memoCount;
+  auto &stack = workspace.stack(program.stackSize + program.yieldCount + memoCount);
+  auto &strings = workspace.strings();
+  strings.reset();
+  Token *base = stack.first.data();
+  Token *sp = base;
+  Token *results = base + program.stackSize;
+  size_t yielded = 0;
+  if (memo == nullptr) {
+    memo = results + program.yieldCount;
+    std::fill(memo, memo + memoCount, Token());
+  }
+  const Instruction *code = program.code.data();
+  const Instruction *ip = code;
+  const Token *constants = program.constants.data();
+
+#ifdef PAGAN_COMPUTED_GOTO
+  static const void *s_Labels[] = {
+#define PAGAN_OPCODE_LABEL(name, op) &&label_##name,
+      PAGAN_OPCODES(PAGAN_OPCODE_LABEL)
+#undef PAGAN_OPCODE_LABEL
+  };
+
+  VM_DISPATCH();
+  {
+#else
+  for (;;) {
+    VM_DISPATCH() {
+#endif
+    VM_CASE(Return): {
+      stack.second = sp - base;
+      // a program with several roots has yielded all its results
+      return sp != base ? sp[-1] : Token();
+    }
+    VM_CASE(LoadConst): {
+      *sp++ = constants[ip->operand()];
+      VM_NEXT();
+    }
+    VM_CASE(LoadSlot): {
+      *sp++ = slots[ip->operand()];
+      VM_NEXT();
+    }
+    VM_CASE(Operator): {
+      auto top = sp - base;
+      stack.second = top;
+      auto result = Token(static_cast<OperatorType>(ip->operand())).evaluate(stack, s_Unresolved, s_NoAssign, workspace);
+      PAGAN_TRACE_OPERATION(static_cast<OperatorType>(ip->operand()),
+                            std::span<const Token>(base + stack.second, top - stack.second), result);
+      sp = base + stack.second;
+      *sp++ = result;
+      VM_NEXT();
+    }
+    VM_CASE(Call): {
+      // arguments are passed as a view of the stack
+      auto *args = sp - ip->operand();
+      auto result = args[-1].getFunction().call(FunctionArgs(args, ip->operand()));
+      PAGAN_TRACE_OPERATION(OperatorType::ArgumentList, std::span<const Token>(args - 1, ip->operand() + 1), result);
+      sp = args;
+      sp[-1] = result;
+      VM_NEXT();
+    }
+    VM_CASE(LoadMemo): {
+      if (memo[ip->operand()].type != TokenType::Undefined) {
+        *sp++ = memo[ip->operand()];
+        VM_NEXT();
+      }
+      VM_JUMP((ip - code) + 2)
+    }
+    VM_CASE(StoreMemo): {
+      memo[ip->operand()] = sp[-1];
+      VM_NEXT();
+    }
+    VM_CASE(Yield): {
+      results[yielded++] = *--sp;
+      VM_NEXT();
+    }
+    VM_CASE(AddI64): VM_BINARY(signedValue, +)
+    VM_CASE(AddU64): VM_BINARY(unsignedValue, +)
+    VM_CASE(AddF64): VM_BINARY(floatValue, +)
+    VM_CASE(SubI64): VM_BINARY(signedValue, -)
+    VM_CASE(SubU64): VM_BINARY(unsignedValue, -)
+    VM_CASE(SubF64): VM_BINARY(floatValue, -)
+    VM_CASE(MulI64): VM_BINARY(signedValue, *)
+    VM_CASE(MulU64): VM_BINARY(unsignedValue, *)
+    VM_CASE(MulF64): VM_BINARY(floatValue, *)
+    VM_CASE(DivI64): VM_BINARY_EXPR(divideInteger(lhs.signedValue, rhs.signedValue))
+    VM_CASE(DivU64): VM_BINARY_EXPR(divideInteger(lhs.unsignedValue, rhs.unsignedValue))
+    VM_CASE(DivF64): VM_BINARY(floatValue, /)
+    VM_CASE(ModU64): VM_BINARY_EXPR(moduloInteger(lhs.unsignedValue, rhs.unsignedValue))
+    VM_CASE(ShlI64): VM_BINARY_EXPR(static_cast<int64_t>(lhs.unsignedValue << rhs.unsignedValue))
+    VM_CASE(ShlU64): VM_BINARY(unsignedValue, <<)
+    VM_CASE(ShrU64): VM_BINARY(unsignedValue, >>)
+    VM_CASE(XorU64): VM_BINARY(unsignedValue, ^)
+    VM_CASE(AndU64): VM_BINARY(unsignedValue, &)
+    VM_CASE(OrU64): VM_BINARY(unsignedValue, |)
+    VM_CASE(LtI64): VM_BINARY(signedValue, <)
+    VM_CASE(LtU64): VM_BINARY(unsignedValue, <)
+    VM_CASE(LtF64): VM_BINARY(floatValue, <)
+    VM_CASE(LeI64): VM_BINARY(signedValue, <=)
+    VM_CASE(LeU64): VM_BINARY(unsignedValue, <=)
+    VM_CASE(LeF64): VM_BINARY(floatValue, <=)
+    VM_CASE(GtI64): VM_BINARY(signedValue, >)
+    VM_CASE(GtU64): VM_BINARY(unsignedValue, >)
+    VM_CASE(GtF64): VM_BINARY(floatValue, >)
+    VM_CASE(GeI64): VM_BINARY(signedValue, >=)
+    VM_CASE(GeU64): VM_BINARY(unsignedValue, >=)
+    VM_CASE(GeF64): VM_BINARY(floatValue, >=)
+    VM_CASE(EqI64): VM_BINARY(signedValue, ==)
+    VM_CASE(EqU64): VM_BINARY(unsignedValue, ==)
+    VM_CASE(EqF64): VM_BINARY(floatValue, ==)
+    VM_CASE(NeI64): VM_BINARY(signedValue, !=)
+    VM_CASE(NeU64): VM_BINARY(unsignedValue, !=)
+    VM_CASE(NeF64): VM_BINARY(floatValue, !=)
+    VM_CASE(AndBool): VM_BINARY(boolValue, &&)
+    VM_CASE(OrBool): VM_BINARY(boolValue, ||)
+    VM_CASE(EqBool): VM_BINARY(boolValue, ==)
+    VM_CASE(NeBool): VM_BINARY(boolValue, !=)
+    VM_CASE(AddStr): {
+      auto &concat = strings.allocate();
+      concat.append(sp[-2].getVariableName()).append(sp[-1].getVariableName());
+      VM_BINARY_EXPR(&concat)
+    }
+    VM_CASE(EqStr): VM_BINARY_EXPR(*lhs.name == *rhs.name)
+    VM_CASE(NeStr): VM_BINARY_EXPR(*lhs.name != *rhs.name)
+    VM_CASE(ConvI64ToF64): VM_CONVERT(static_cast<double>(sp[-1].signedValue))
+    VM_CASE(ConvU64ToF64): VM_CONVERT(static_cast<double>(sp[-1].unsignedValue))
+    VM_CASE(ConvI64ToU64): VM_CONVERT(static_cast<uint64_t>(sp[-1].signedValue))
+    VM_CASE(ConvU64ToI64): VM_CONVERT(static_cast<int64_t>(sp[-1].unsignedValue))
+    VM_CASE(ConvIntToBool): VM_CONVERT(sp[-1].unsignedValue != 0)
+    VM_CASE(NotBool): {
+      Token result(!sp[-1].boolValue);
+      PAGAN_TRACE_OPERATION(OperatorType::LogicalNot, std::span<const Token>(sp - 1, 1), result);
+      sp[-1] = result;
+      VM_NEXT();
+    }
+    VM_CASE(ToBool): VM_CONVERT(isTrue(sp[-1]))
+    VM_CASE(Jump): {
+      VM_JUMP(ip->operand())
+    }
+    VM_CASE(JumpIfFalse): {
+      if (!isTrue(*--sp)) {
+        VM_JUMP(ip->operand())
+      }
+      VM_NEXT();
+    }
+    VM_CASE(JumpIfFalseOrPop): {
+      if (!isTrue(sp[-1])) {
+        sp[-1] = Token(false);
+        VM_JUMP(ip->operand())
+      }
+      --sp;
+      VM_NEXT();
+    }
+    VM_CASE(JumpIfTrueOrPop): {
+      if (isTrue(sp[-1])) {
+        sp[-1] = Token(true);
+        VM_JUMP(ip->operand())
+      }
+      --sp;
+      VM_NEXT();
+    }
+#ifndef PAGAN_COMPUTED_GOTO
+    default:
+      throw std::runtime_error(std::format("invalid opcode {}", static_cast<int>(ip->code())));
+    }
+#endif
+  }
+}
+
+}
+
+ProgramView viewOf(const Program &program) {
+  return ProgramView{ program.code, program.constants, program.stackSize, program.memoCount, program.yieldCount };
+}
+
+Token execute(const Program &program, std::span<const Token> slots, Workspace &workspace) {
+  return run(viewOf(program), slots, nullptr, workspace);
+}
+
+Token execute(const ProgramView &program, std::span<const Token> slots, Workspace &workspace) {
+  return run(program, slots, nullptr, workspace);
+}
+
+std::span<const Token> executeAll(const Program &program, std::span<const Token> slots, Workspace &workspace) {
+  (void)run(viewOf(program), slots, nullptr, workspace);
+  return std::span<const Token>(workspace.stack(0).first.data() + program.stackSize, program.yieldCount);
+}
+
+std::span<const Token> executeAll(const Program &program, std::span<const Token> slots, std::span<Token> memo,
+                                  Workspace &workspace) {
+  if (memo.size() < program.memoCount) {
+    throw std::runtime_error(std::format("expected {} memo values, got {}", program.memoCount, memo.size()));
+  }
+  (void)run(viewOf(program), slots, memo.data(), workspace);
+  return std::span<const Token>(workspace.stack(0).first.data() + program.stackSize, program.yieldCount);
+}
+
+}
@@ -0,0 +1,193 @@
+#pragma once
+
+#include <cstdint>
+#include <format>
+#include <functional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "expression_tree.h"
+#include "optimizer.h"
+#include "string_arena.h"
+#include "token.h"
+#include "type_check.h"
+#include "workspace.h"
+
+namespace SYP {
+
+// X(opcode, operator it implements)
+#define PAGAN_OPCODES(X)                                                       \
+  X(Return, Invalid)                                                           \
+  X(LoadConst, Invalid)                                                        \
+  X(LoadSlot, Invalid)                                                         \
+  /* dynamically typed operator, operand is the OperatorType */               \
+  X(Operator, Invalid)                                                         \
+  X(AddI64, Add) X(AddU64, Add) X(AddF64, Add)                                 \
+  X(SubI64, Subtract) X(SubU64, Subtract) X(SubF64, Subtract)                  \
+  X(MulI64, Multiply) X(MulU64, Multiply) X(MulF64, Multiply)                  \
+  X(DivI64, Divide) X(DivU64, Divide) X(DivF64, Divide)                        \
+  X(ModU64, Modulo)                                                            \
+  X(ShlI64, ShiftLeft) X(ShlU64, ShiftLeft) X(ShrU64, ShiftRight)            \
+  X(XorU64, Xor) X(AndU64, BitwiseAnd) X(OrU64, BitwiseOr)                     \
+  X(LtI64, LessThan) X(LtU64, LessThan) X(LtF64, LessThan)                     \
+  X(LeI64, LessOrEqual) X(LeU64, LessOrEqual) X(LeF64, LessOrEqual)            \
+  X(GtI64, GreaterThan) X(GtU64, GreaterThan) X(GtF64, GreaterThan)            \
+  X(GeI64, GreaterOrEqual) X(GeU64, GreaterOrEqual) X(GeF64, GreaterOrEqual)   \
+  X(EqI64, Equal) X(EqU64, Equal) X(EqF64, Equal)                              \
+  X(NeI64, NotEqual) X(NeU64, NotEqual) X(NeF64, NotEqual)                     \
+  X(EqBool, Equal) X(NeBool, NotEqual)                                         \
+  X(AndBool, LogicalAnd) X(OrBool, LogicalOr) X(NotBool, LogicalNot)           \
+  X(AddStr, Add) X(EqStr, Equal) X(NeStr, NotEqual)                            \
+  X(ConvI64ToF64, Invalid) X(ConvU64ToF64, Invalid)                            \
+  X(ConvI64ToU64, Invalid) X(ConvU64ToI64, Invalid)                            \
+  X(ConvIntToBool, Invalid)                                                    \
+  /* truth value of a dynamically typed operand */                            \
+  X(ToBool, Invalid)                                                           \
+  /* jumps, operand is the target instruction */                              \
+  X(Jump, Invalid)                                                             \
+  /* pops the condition */                                                     \
+  X(JumpIfFalse, Invalid)                                                      \
+  /* keep the condition as the result if it decides, pop it otherwise */      \
+  X(JumpIfFalseOrPop, LogicalAnd) X(JumpIfTrueOrPop, LogicalOr)               \
+  /* operand is the argument count, arguments are above the function */      \
+  X(Call, ArgumentList)                                                        \
+  /* push the memoized value and continue with the following jump if it was */\
+  /* computed already, skip that jump otherwise. Operand is the memo index */ \
+  X(LoadMemo, Invalid) X(StoreMemo, Invalid)                                   \
+  /* pop the result of one root of a program with several */                 \
+  X(Yield, Invalid)
+
+enum class OpCode : uint8_t {
+#define PAGAN_OPCODE_ENUM(name, op) name,
+  PAGAN_OPCODES(PAGAN_OPCODE_ENUM)
+#undef PAGAN_OPCODE_ENUM
+  OpCodeCount,
+};
+
+/**
+ * the operator implemented by an opcode, Invalid for instructions that aren't operators
+ */
+[[nodiscard]] OperatorType getOperatorType(OpCode code);
+
+/**
+ * opcode in the low 8 bits and operand in the upper 24 bits of one word, four instructions take
+ * the space of one token. Literals are in the constant pool so the operand is always an index,
+ * a jump target or a count
+ */
+class Instruction {
+public:
+  static constexpr uint32_t s_MaxOperand = (uint32_t(1) << 24) - 1;
+
+public:
+  Instruction(OpCode code, uint32_t operand) : m_Word(static_cast<uint32_t>(code)) { setOperand(operand); }
+
+  [[nodiscard]] OpCode code() const { return static_cast<OpCode>(m_Word & 0xFF); }
+
+  [[nodiscard]] uint32_t operand() const { return m_Word >> 8; }
+
+  void setOperand(uint32_t operand) {
+    if (operand > s_MaxOperand) {
+      throw std::runtime_error(std::format("operand {} exceeds the instruction encoding", operand));
+    }
+    m_Word = (m_Word & 0xFF) | (operand << 8);
+  }
+
+private:
+  uint32_t m_Word;
+};
+
+static_assert(sizeof(Instruction) == 4);
+
+/**
+ * bytecode compiled from a token queue. Variables and function names are loaded from slots,
+ * literals from the constant pool
+ */
+struct Program {
+  std::vector<Instruction> code;
+  std::vector<Token> constants;
+  // names of the referenced symbols, index is the slot
+  std::vector<std::string> slots;
+  std::vector<bool> functionSlots;
+  // declared type of each slot, Undefined if it was not declared
+  std::vector<TokenType> slotTypes;
+  // type of the result, Undefined if it's only known at runtime
+  TokenType resultType{TokenType::Undefined};
+  size_t stackSize{0};
+  // values of shared sub-expressions, kept above the stack during execution
+  size_t memoCount{0};
+  // number of roots of a program compiled from several, 0 otherwise
+  size_t yieldCount{0};
+};
+
+/**
+ * what's needed to run a program, with code and constants stored elsewhere, e.g. in a mapped
+ * archive
+ */
+struct ProgramView {
+  std::span<const Instruction> code;
+  std::span<const Token> constants;
+  size_t stackSize{0};
+  size_t memoCount{0};
+  size_t yieldCount{0};
+};
+
+[[nodiscard]] ProgramView viewOf(const Program &program);
+
+/**
+ * compile a token queue in RPN into bytecode. Operators with operands of statically known types
+ * are emitted as typed instructions, everything else dispatches on the type at runtime.
+ * Type errors among the known types are reported by throwing. Constant sub-expressions are
+ * evaluated at this point
+ */
+[[nodiscard]] Program compile(const TokenQueue &tokens, const VariableTypes &types = {});
+
+/**
+ * compile a tree that has already been type checked
+ */
+[[nodiscard]] Program compile(const ExpressionTree &tree);
+
+/**
+ * compile only the sub-tree starting at the specified node
+ */
+[[nodiscard]] Program compile(const ExpressionTree &tree, uint32_t root);
+
+/**
+ * compile several roots of a tree into one program that yields their results in order. Nodes
+ * may be shared between roots or within one, those with a memo index (one-based, memo[node] != 0)
+ * are computed at most once per execution and loaded from there by any later use
+ */
+[[nodiscard]] Program compile(const ExpressionTree &tree, std::span<const uint32_t> roots,
+                              std::span<const uint32_t> memo);
+
+/**
+ * resolve the slots of a program, throws if a value doesn't match the declared type of its slot
+ */
+[[nodiscard]] std::vector<Token> bindSlots(const Program &program,
+                                           const std::function<Token(const std::string &)> &resolve);
+
+/**
+ * run a program using the stack and string arena of the workspace. A string result references
+ * the workspace and is only valid until the next execution with it
+ */
+[[nodiscard]] Token execute(const Program &program, std::span<const Token> slots, Workspace &workspace);
+
+[[nodiscard]] Token execute(const ProgramView &program, std::span<const Token> slots, Workspace &workspace);
+
+/**
+ * run a program compiled from several roots. The results reference the workspace and are only
+ * valid until its next use
+ */
+[[nodiscard]] std::span<const Token> executeAll(const Program &program, std::span<const Token> slots,
+                                                Workspace &workspace);
+
+/**
+ * run a program compiled from several roots with memoized values kept by the caller. Values in
+ * there are used as they are, Token() marks one that still has to be computed. A memoized string
+ * references the workspace like a result does
+ */
+[[nodiscard]] std::span<const Token> executeAll(const Program &program, std::span<const Token> slots,
+                                                std::span<Token> memo, Workspace &workspace);
+
+}
@@ -0,0 +1,36 @@
+#include "compiled_expression.h"
+
+#include <algorithm>
+#include <format>
+#include <stdexcept>
+
+namespace SYP {
+
+CompiledExpression::CompiledExpression(const TokenQueue &tokens, const VariableTypes &types)
+  : m_Program(compile(tokens, types)) {
+}
+
+size_t CompiledExpression::slotOf(std::string_view name) const {
+  auto iter = std::find(m_Program.slots.begin(), m_Program.slots.end(), name);
+  return iter != m_Program.slots.end() ? static_cast<size_t>(iter - m_Program.slots.begin()) : npos;
+}
+
+std::vector<Token> CompiledExpression::bind(const std::function<Token(const std::string &)> &resolve) const {
+  return bindSlots(m_Program, resolve);
+}
+
+Result CompiledExpression::evaluate(std::span<const Token> slots) const {
+  auto &workspace = Workspace::local();
+  workspace.reset();
+  return evaluate(slots, workspace);
+}
+
+Result CompiledExpression::evaluate(std::span<const Token> slots, Workspace &workspace) const {
+  if (slots.size() < m_Program.slots.size()) {
+    throw std::runtime_error(std::format("expected {} bound slots, got {}", m_Program.slots.size(), slots.size()));
+  }
+
+  return toResult(execute(m_Program, slots, workspace));
+}
+
+}
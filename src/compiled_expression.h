@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "bytecode.h"
+#include "evaluate.h"
+#include "token.h"
+#include "workspace.h"
+
+namespace SYP {
+
+/**
+ * expression prepared for repeated evaluation. Every variable (and function name) referenced by
+ * the term is assigned a slot index at construction, evaluation then reads values from a flat
+ * array of tokens indexed by slot instead of resolving names through a callback.
+ * The expression is immutable after construction, any number of threads can evaluate it at the
+ * same time. All mutable state of an evaluation lives in the Workspace, which must not be shared
+ * between concurrent evaluations (the overloads without one use a workspace per thread).
+ * Evaluating bound slots takes no locks and touches no shared atomics
+ */
+class CompiledExpression {
+public:
+  static constexpr size_t npos = std::numeric_limits<size_t>::max();
+
+public:
+  /**
+   * compile the expression, variables with declared types get type checked at this point and
+   * operations on them don't need to check types during evaluation
+   */
+  explicit CompiledExpression(const TokenQueue &tokens, const VariableTypes &types = {});
+
+  /**
+   * names of the distinct symbols referenced by the expression, the index in this list is the slot
+   */
+  [[nodiscard]] const std::vector<std::string> &variables() const { return m_Program.slots; }
+
+  [[nodiscard]] size_t slotCount() const { return m_Program.slots.size(); }
+
+  /**
+   * get the slot assigned to a variable, npos if the expression doesn't reference it
+   */
+  [[nodiscard]] size_t slotOf(std::string_view name) const;
+
+  /**
+   * true if the slot refers to a function name rather than a variable
+   */
+  [[nodiscard]] bool isFunctionSlot(size_t slot) const { return m_Program.functionSlots[slot]; }
+
+  [[nodiscard]] TokenType slotType(size_t slot) const { return m_Program.slotTypes[slot]; }
+
+  /**
+   * type of the result, Undefined if it can only be determined during evaluation
+   */
+  [[nodiscard]] TokenType resultType() const { return m_Program.resultType; }
+
+  /**
+   * resolve all slots once, the result can be passed to evaluate as often as required.
+   * Throws if a resolved value doesn't match the declared type of its slot
+   */
+  [[nodiscard]] std::vector<Token> bind(const std::function<Token(const std::string &)> &resolve) const;
+
+  /**
+   * evaluate with the specified slot values. Values of slots with a declared type are not
+   * checked here, they have to be of that type
+   */
+  [[nodiscard]] Result evaluate(std::span<const Token> slots) const;
+
+  /**
+   * evaluate using the scratch memory of the specified workspace
+   */
+  [[nodiscard]] Result evaluate(std::span<const Token> slots, Workspace &workspace) const;
+
+  [[nodiscard]] const Program &program() const { return m_Program; }
+
+private:
+  Program m_Program;
+};
+
+}
@@ -1,4 +1,6 @@
 #include "evaluate.h"
+#include "trace.h"
+#include "workspace.h"
 #include <vector>
 #include <stdexcept>
 #include <format>
@@ -55,19 +57,24 @@ inline void push(TokenStack &stack, Token &&token) {
 }
 
 Result evaluate(const TokenQueue &tokens, const std::function<Token(const std::string&)> &resolve, const std::function<void(const std::string&, const Token&)> &assign) {
-  thread_local static TokenStack stack = TokenStack{ std::make_pair(std::vector<Token>{}, 0) };
-
-  if (tokens.size() > stack.first.size()) {
-    stack.first.resize(tokens.size());
-  }
+  auto &workspace = Workspace::local();
+  workspace.reset();
+  return evaluate(tokens, workspace, resolve, assign);
+}
 
-  stack.second = 0;
+Result evaluate(const TokenQueue &tokens, Workspace &workspace, const std::function<Token(const std::string&)> &resolve, const std::function<void(const std::string&, const Token&)> &assign) {
+  auto &stack = workspace.stack(tokens.size());
+  workspace.strings().reset();
 
   for (size_t i = 0; i < tokens.size(); ++i) {
     const auto& cur = tokens[i];
 
     if (cur.type == TokenType::Operator) {
-      push(stack, cur.evaluate(stack, resolve, assign));
+      auto top = stack.second;
+      auto result = cur.evaluate(stack, resolve, assign, workspace);
+      // popped operands are still in place until the result gets pushed
+      PAGAN_TRACE_OPERATION(cur.op, std::span<const Token>(stack.first.data() + stack.second, top - stack.second), result);
+      push(stack, std::move(result));
     } else if (cur.type == TokenType::FunctionName) {
       /*
       auto function = cur.getFunction();
@@ -13,9 +13,16 @@ using Result = std::variant<int64_t, uint64_t, double, bool, std::string>;
 Token noVariables(const std::string&);
 void noAssign(const std::string&, const Token&);
 
+Result toResult(const Token &token);
+
 std::string toString(const Result& result);
 std::string toString(const Token& token);
 
 Result evaluate(const TokenQueue &tokens, const std::function<Token(const std::string&)> &resolve = noVariables, const std::function<void(const std::string&, const Token&)> &assign = noAssign);
 
+/**
+ * evaluate using the scratch memory of the specified workspace instead of the one local to the thread
+ */
+Result evaluate(const TokenQueue &tokens, Workspace &workspace, const std::function<Token(const std::string&)> &resolve = noVariables, const std::function<void(const std::string&, const Token&)> &assign = noAssign);
+
 }
@@ -0,0 +1,302 @@
+#include "expression_cache.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "shunting_yard.h"
+
+namespace SYP {
+
+namespace {
+
+enum class PieceKind {
+  Identifier,
+  // and, or
+  Keyword,
+  Number,
+  String,
+  // a run of operator characters, kept as written since splitting or joining them changes the
+  // operators
+  Operator,
+  Open,
+  Close,
+  Other,
+};
+
+struct Piece {
+  PieceKind kind;
+  std::string_view text;
+  // separated from the previous piece by whitespace
+  bool gapBefore{false};
+  // that whitespace only consists of spaces, which still allows a function call
+  bool spacesOnly{true};
+  bool removed{false};
+  // index of the matching bracket
+  size_t match{0};
+  // brackets containing two operands next to each other, like the arguments of a call. Removing
+  // those could turn their content into arguments of an outer call
+  bool list{false};
+};
+
+bool isSpace(char ch) {
+  return (ch == ' ') || (ch == '\t') || (ch == '\r') || (ch == '\n') || (ch == ',');
+}
+
+bool isWordCharacter(char ch) {
+  return ((ch >= 'a') && (ch <= 'z')) || ((ch >= 'A') && (ch <= 'Z')) || ((ch >= '0') && (ch <= '9')) ||
+         (ch == '_') || (ch == '.');
+}
+
+bool isOperatorCharacter(char ch) {
+  return std::string_view("+-*/%^<>=!&|?:").find(ch) != std::string_view::npos;
+}
+
+bool isWord(PieceKind kind) {
+  return (kind == PieceKind::Identifier) || (kind == PieceKind::Keyword) || (kind == PieceKind::Number);
+}
+
+bool isOperand(PieceKind kind) {
+  return (kind == PieceKind::Identifier) || (kind == PieceKind::Number) || (kind == PieceKind::String);
+}
+
+void split(std::string_view text, std::vector<Piece> &pieces) {
+  pieces.clear();
+  bool gap = false;
+  bool spacesOnly = true;
+  size_t pos = 0;
+  while (pos < text.size()) {
+    char ch = text[pos];
+    if (isSpace(ch)) {
+      gap = true;
+      spacesOnly = spacesOnly && (ch == ' ');
+      ++pos;
+      continue;
+    }
+
+    size_t end = pos + 1;
+    PieceKind kind = PieceKind::Other;
+    if (ch == '"') {
+      // an unterminated string takes the rest of the text, tokenize reports it
+      end = text.find('"', pos + 1);
+      end = (end == std::string_view::npos) ? text.size() : end + 1;
+      kind = PieceKind::String;
+    } else if (isWordCharacter(ch)) {
+      while ((end < text.size()) && isWordCharacter(text[end])) {
+        ++end;
+      }
+      std::string_view word = text.substr(pos, end - pos);
+      kind = ((ch >= '0') && (ch <= '9')) ? PieceKind::Number
+             : ((word == "and") || (word == "or")) ? PieceKind::Keyword
+                                                    : PieceKind::Identifier;
+    } else if (isOperatorCharacter(ch)) {
+      while ((end < text.size()) && isOperatorCharacter(text[end])) {
+        ++end;
+      }
+      kind = PieceKind::Operator;
+    } else if (ch == '(') {
+      kind = PieceKind::Open;
+    } else if (ch == ')') {
+      kind = PieceKind::Close;
+    }
+
+    pieces.push_back({ kind, text.substr(pos, end - pos), gap, spacesOnly });
+    gap = false;
+    spacesOnly = true;
+    pos = end;
+  }
+}
+
+/**
+ * the tokenizer treats an identifier followed by a bracket, with nothing but spaces in between,
+ * as a function call
+ */
+bool isCallBracket(const std::vector<Piece> &pieces, size_t index) {
+  return (index > 0) && (pieces[index - 1].kind == PieceKind::Identifier) && pieces[index].spacesOnly;
+}
+
+void removeRedundantBrackets(std::vector<Piece> &pieces, std::vector<size_t> &open) {
+  open.clear();
+  for (size_t i = 0; i < pieces.size(); ++i) {
+    if ((i > 0) && !open.empty()) {
+      const auto &prev = pieces[i - 1];
+      bool prevEnds = isOperand(prev.kind) || (prev.kind == PieceKind::Close);
+      bool starts = isOperand(pieces[i].kind) ||
+                    ((pieces[i].kind == PieceKind::Open) && !isCallBracket(pieces, i));
+      if (prevEnds && starts) {
+        pieces[open.back()].list = true;
+      }
+    }
+    if (pieces[i].kind == PieceKind::Open) {
+      open.push_back(i);
+    } else if (pieces[i].kind == PieceKind::Close) {
+      if (open.empty()) {
+        return;
+      }
+      pieces[open.back()].match = i;
+      pieces[i].match = open.back();
+      open.pop_back();
+    }
+  }
+  if (!open.empty()) {
+    // unbalanced, leave it to tokenize to complain
+    return;
+  }
+
+  for (size_t i = 0; i < pieces.size(); ++i) {
+    if ((pieces[i].kind != PieceKind::Open) || isCallBracket(pieces, i) || pieces[i].list) {
+      continue;
+    }
+    size_t close = pieces[i].match;
+    bool wholeTerm = (i == 0) && (close == pieces.size() - 1);
+    bool nested = (i > 0) && (pieces[i - 1].kind == PieceKind::Open) && (pieces[i - 1].match == close + 1);
+    bool singleOperand = (close == i + 2) && isOperand(pieces[i + 1].kind);
+    if (wholeTerm || nested || singleOperand) {
+      pieces[i].removed = true;
+      pieces[close].removed = true;
+    }
+  }
+}
+
+/**
+ * what needs to go between two pieces that were apart in the source so the tokenizer still reads
+ * them the same way
+ */
+std::string_view separator(const Piece &prev, const Piece &next, bool spacesOnly) {
+  if ((isWord(prev.kind) && isWord(next.kind)) ||
+      ((prev.kind == PieceKind::Operator) && (next.kind == PieceKind::Operator)) ||
+      (prev.kind == PieceKind::Other) || (next.kind == PieceKind::Other)) {
+    return " ";
+  }
+  // "- 2" is the operator, "-2" the literal
+  if ((prev.kind == PieceKind::Operator) && (prev.text.back() == '-') && (next.kind == PieceKind::Number)) {
+    return " ";
+  }
+  // "1e -2" must not turn into an exponent
+  if ((prev.kind == PieceKind::Number) && ((prev.text.back() == 'e') || (prev.text.back() == 'E')) &&
+      (next.kind == PieceKind::Operator) && ((next.text.front() == '+') || (next.text.front() == '-'))) {
+    return " ";
+  }
+  if ((prev.kind == PieceKind::Identifier) && (next.kind == PieceKind::Open)) {
+    // a comma separates like whitespace without making the bracket a call
+    return spacesOnly ? "" : ",";
+  }
+  return "";
+}
+
+}
+
+ExpressionCache::ExpressionCache(size_t capacity, SymbolTable &symbols, size_t shards)
+  : m_Symbols(symbols) {
+  capacity = std::max<size_t>(capacity, 1);
+  shards = std::clamp<size_t>(shards, 1, capacity);
+  m_ShardCapacity = (capacity + shards - 1) / shards;
+  for (size_t i = 0; i < shards; ++i) {
+    m_Shards.push_back(std::make_unique<Shard>());
+  }
+}
+
+std::shared_ptr<const CompiledExpression> ExpressionCache::get(std::string_view text, const VariableTypes &types) {
+  std::string key = makeKey(text, types);
+  Shard &shard = *m_Shards[KeyHash{}(key) % m_Shards.size()];
+
+  {
+    std::lock_guard lock(shard.mutex);
+    auto iter = shard.index.find(key);
+    if (iter != shard.index.end()) {
+      shard.entries.splice(shard.entries.begin(), shard.entries, iter->second);
+      m_Hits.fetch_add(1, std::memory_order_relaxed);
+      return iter->second->expression;
+    }
+  }
+
+  m_Misses.fetch_add(1, std::memory_order_relaxed);
+  // compile without holding the lock, other expressions of this shard stay available meanwhile
+  auto expression = std::make_shared<const CompiledExpression>(tokenize(text, m_Symbols), types);
+
+  std::lock_guard lock(shard.mutex);
+  auto iter = shard.index.find(key);
+  if (iter != shard.index.end()) {
+    // another thread compiled the same expression in the meantime, share its result
+    shard.entries.splice(shard.entries.begin(), shard.entries, iter->second);
+    return iter->second->expression;
+  }
+
+  shard.entries.push_front({ std::move(key), expression });
+  shard.index.emplace(shard.entries.front().key, shard.entries.begin());
+  while (shard.entries.size() > m_ShardCapacity) {
+    shard.index.erase(shard.entries.back().key);
+    shard.entries.pop_back();
+    m_Evictions.fetch_add(1, std::memory_order_relaxed);
+  }
+  return expression;
+}
+
+CacheStatistics ExpressionCache::statistics() const {
+  CacheStatistics result;
+  result.hits = m_Hits.load(std::memory_order_relaxed);
+  result.misses = m_Misses.load(std::memory_order_relaxed);
+  result.evictions = m_Evictions.load(std::memory_order_relaxed);
+  for (const auto &shard : m_Shards) {
+    std::lock_guard lock(shard->mutex);
+    result.size += shard->entries.size();
+  }
+  return result;
+}
+
+void ExpressionCache::clear() {
+  for (auto &shard : m_Shards) {
+    std::lock_guard lock(shard->mutex);
+    shard->index.clear();
+    shard->entries.clear();
+  }
+}
+
+std::string ExpressionCache::normalize(std::string_view text) {
+  // keys get normalized on every lookup, reuse the buffers
+  thread_local std::vector<Piece> pieces;
+  thread_local std::vector<size_t> open;
+  split(text, pieces);
+  removeRedundantBrackets(pieces, open);
+
+  std::string result;
+  result.reserve(text.size());
+  const Piece *prev = nullptr;
+  bool separated = false;
+  bool spacesOnly = true;
+  for (const auto &piece : pieces) {
+    separated = separated || piece.gapBefore;
+    spacesOnly = spacesOnly && piece.spacesOnly;
+    if (piece.removed) {
+      // a removed bracket still separates its neighbours
+      separated = true;
+      spacesOnly = false;
+      continue;
+    }
+    if ((prev != nullptr) && separated) {
+      result += separator(*prev, piece, spacesOnly);
+    }
+    result += piece.text;
+    prev = &piece;
+    separated = false;
+    spacesOnly = true;
+  }
+  return result;
+}
+
+std::string ExpressionCache::makeKey(std::string_view text, const VariableTypes &types) {
+  std::string key = normalize(text);
+  if (!types.empty()) {
+    // the same term compiles differently depending on declared types
+    std::vector<std::pair<std::string_view, TokenType>> sorted(types.begin(), types.end());
+    std::sort(sorted.begin(), sorted.end());
+    for (const auto &[name, type] : sorted) {
+      key += '\0';
+      key += name;
+      key += '=';
+      key += std::to_string(static_cast<int>(type));
+    }
+  }
+  return key;
+}
+
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "compiled_expression.h"
+#include "symbol_table.h"
+#include "type_check.h"
+
+namespace SYP {
+
+struct CacheStatistics {
+  uint64_t hits{0};
+  uint64_t misses{0};
+  uint64_t evictions{0};
+  size_t size{0};
+};
+
+/**
+ * bounded cache of compiled expressions keyed on their normalized source text, so expressions
+ * that differ only in formatting share one entry.
+ * The cache is split into shards with their own lock and least recently used list, lookups of
+ * different expressions rarely contend. Compiling on a miss happens without holding a lock.
+ * Entries are immutable and shared, they stay valid after eviction for as long as they are
+ * referenced. The symbol table has to outlive the cache and all entries
+ */
+class ExpressionCache {
+public:
+  static constexpr size_t s_DefaultShards = 16;
+
+public:
+  /**
+   * @param capacity maximum number of cached expressions, split evenly among the shards
+   */
+  explicit ExpressionCache(size_t capacity, SymbolTable &symbols = SymbolTable::defaultTable(),
+                           size_t shards = s_DefaultShards);
+
+  ExpressionCache(const ExpressionCache &) = delete;
+  ExpressionCache &operator=(const ExpressionCache &) = delete;
+
+  /**
+   * get the compiled expression for a term, compiling and caching it if necessary. Declared
+   * types are part of the key. Throws like CompiledExpression if the term is invalid, failures
+   * are not cached
+   */
+  [[nodiscard]] std::shared_ptr<const CompiledExpression> get(std::string_view text, const VariableTypes &types = {});
+
+  [[nodiscard]] CacheStatistics statistics() const;
+
+  void clear();
+
+  /**
+   * the form of a term used as key: whitespace is dropped unless it separates two words or two
+   * operators and parentheses that can't affect the meaning are removed, namely those around
+   * the whole term, those directly around another pair and those around a single operand.
+   * String literals are kept as they are
+   */
+  [[nodiscard]] static std::string normalize(std::string_view text);
+
+private:
+  struct KeyHash {
+    using is_transparent = void;
+    size_t operator()(std::string_view key) const { return std::hash<std::string_view>{}(key); }
+  };
+
+  struct Entry {
+    std::string key;
+    std::shared_ptr<const CompiledExpression> expression;
+  };
+
+  struct Shard {
+    std::mutex mutex;
+    // most recently used at the front
+    std::list<Entry> entries;
+    std::unordered_map<std::string_view, std::list<Entry>::iterator, KeyHash, std::equal_to<>> index;
+  };
+
+private:
+  [[nodiscard]] static std::string makeKey(std::string_view text, const VariableTypes &types);
+
+private:
+  SymbolTable &m_Symbols;
+  size_t m_ShardCapacity;
+  std::vector<std::unique_ptr<Shard>> m_Shards;
+  std::atomic<uint64_t> m_Hits{0};
+  std::atomic<uint64_t> m_Misses{0};
+  std::atomic<uint64_t> m_Evictions{0};
+};
+
+}
@@ -0,0 +1,206 @@
+#include "expression_set.h"
+
+#include "optimizer.h"
+#include "type_check.h"
+
+#include <algorithm>
+#include <bit>
+#include <format>
+#include <limits>
+#include <map>
+#include <stdexcept>
+
+namespace SYP {
+
+namespace {
+
+constexpr uint32_t s_Unmapped = std::numeric_limits<uint32_t>::max();
+
+bool sameConstant(const Token &lhs, const Token &rhs) {
+  if (lhs.type != rhs.type) {
+    return false;
+  }
+  switch (lhs.type) {
+  case TokenType::Signed:
+  case TokenType::Unsigned: return lhs.unsignedValue == rhs.unsignedValue;
+  // bitwise so 0.0 and -0.0 stay apart
+  case TokenType::Float: return std::bit_cast<uint64_t>(lhs.floatValue) == std::bit_cast<uint64_t>(rhs.floatValue);
+  case TokenType::Boolean: return lhs.boolValue == rhs.boolValue;
+  case TokenType::String: return lhs.getVariableName() == rhs.getVariableName();
+  default: return false;
+  }
+}
+
+/**
+ * merges expression trees into one graph, pure nodes with the same content become one
+ */
+class Merger {
+public:
+  explicit Merger(ExpressionTree &graph) : m_Graph(graph) {}
+
+  uint32_t add(const ExpressionTree &tree) {
+    m_Mapped.assign(tree.nodes.size(), s_Unmapped);
+    m_SlotMap.assign(tree.slots.size(), s_Unmapped);
+    return node(tree, tree.root);
+  }
+
+  [[nodiscard]] bool isPure(uint32_t idx) const { return m_Pure[idx]; }
+
+private:
+  uint32_t node(const ExpressionTree &tree, uint32_t idx) {
+    if (m_Mapped[idx] != s_Unmapped) {
+      return m_Mapped[idx];
+    }
+
+    const auto &source = tree.nodes[idx];
+    Node merged{ source.kind, source.op, source.type, source.index, {} };
+    if (source.kind == NodeKind::Constant) {
+      merged.index = constant(tree.constants[source.index]);
+    } else if ((source.kind == NodeKind::Slot) || (source.kind == NodeKind::Call)) {
+      merged.index = slot(tree, source.index);
+    }
+
+    bool pure = (source.kind != NodeKind::Call) ||
+                ((m_Graph.functions[merged.index] != nullptr) && m_Graph.functions[merged.index]->pure);
+    for (auto operand : source.operands) {
+      merged.operands.push_back(node(tree, operand));
+      pure = pure && m_Pure[merged.operands.back()];
+    }
+
+    std::vector<uint64_t> key{ static_cast<uint64_t>(merged.kind), static_cast<uint64_t>(merged.op),
+                               static_cast<uint64_t>(merged.type), merged.index };
+    key.insert(key.end(), merged.operands.begin(), merged.operands.end());
+    if (pure) {
+      auto iter = m_Nodes.find(key);
+      if (iter != m_Nodes.end()) {
+        return m_Mapped[idx] = iter->second;
+      }
+    }
+
+    auto result = m_Graph.add(std::move(merged));
+    m_Pure.push_back(pure);
+    if (pure) {
+      m_Nodes.emplace(std::move(key), result);
+    }
+    return m_Mapped[idx] = result;
+  }
+
+  uint32_t constant(const Token &value) {
+    auto iter = std::find_if(m_Graph.constants.begin(), m_Graph.constants.end(),
+                             [&value](const Token &existing) { return sameConstant(existing, value); });
+    if (iter != m_Graph.constants.end()) {
+      return static_cast<uint32_t>(iter - m_Graph.constants.begin());
+    }
+    m_Graph.constants.push_back(value);
+    return static_cast<uint32_t>(m_Graph.constants.size() - 1);
+  }
+
+  uint32_t slot(const ExpressionTree &tree, uint32_t idx) {
+    if (m_SlotMap[idx] != s_Unmapped) {
+      return m_SlotMap[idx];
+    }
+    const auto &name = tree.slots[idx];
+    auto iter = std::find(m_Graph.slots.begin(), m_Graph.slots.end(), name);
+    if (iter == m_Graph.slots.end()) {
+      m_Graph.slots.push_back(name);
+      m_Graph.functionSlots.push_back(tree.functionSlots[idx]);
+      m_Graph.functions.push_back(tree.functions[idx]);
+      m_Graph.slotTypes.push_back(tree.slotTypes[idx]);
+      iter = m_Graph.slots.end() - 1;
+    } else if (m_Graph.functionSlots[iter - m_Graph.slots.begin()] != tree.functionSlots[idx]) {
+      throw std::runtime_error(std::format("{} used both as variable and function", name));
+    }
+    return m_SlotMap[idx] = static_cast<uint32_t>(iter - m_Graph.slots.begin());
+  }
+
+private:
+  ExpressionTree &m_Graph;
+  std::vector<bool> m_Pure;
+  std::map<std::vector<uint64_t>, uint32_t> m_Nodes;
+  // node and slot indices of the tree being added in the graph
+  std::vector<uint32_t> m_Mapped;
+  std::vector<uint32_t> m_SlotMap;
+};
+
+}
+
+ExpressionGraph mergeExpressions(std::span<const TokenQueue> expressions, const VariableTypes &types) {
+  ExpressionGraph graph;
+  Merger merger(graph.tree);
+  for (const auto &tokens : expressions) {
+    auto tree = buildTree(tokens);
+    typeCheck(tree, types);
+    optimize(tree);
+    graph.roots.push_back(merger.add(tree));
+  }
+
+  graph.uses.assign(graph.tree.nodes.size(), 0);
+  for (const auto &node : graph.tree.nodes) {
+    for (auto operand : node.operands) {
+      ++graph.uses[operand];
+    }
+  }
+  for (auto root : graph.roots) {
+    ++graph.uses[root];
+  }
+  for (uint32_t i = 0; i < graph.tree.nodes.size(); ++i) {
+    graph.pure.push_back(merger.isPure(i));
+  }
+  return graph;
+}
+
+ExpressionSet::ExpressionSet(std::span<const TokenQueue> expressions, const VariableTypes &types) {
+  auto graph = mergeExpressions(expressions, types);
+
+  // loading a constant or slot is as cheap as loading the memoized value
+  std::vector<uint32_t> memo(graph.tree.nodes.size(), 0);
+  uint32_t memoCount = 0;
+  for (uint32_t i = 0; i < graph.tree.nodes.size(); ++i) {
+    auto kind = graph.tree.nodes[i].kind;
+    if ((graph.uses[i] > 1) && graph.pure[i] && (kind != NodeKind::Constant) && (kind != NodeKind::Slot)) {
+      memo[i] = ++memoCount;
+    }
+  }
+
+  m_Program = compile(graph.tree, graph.roots, memo);
+  for (auto root : graph.roots) {
+    m_ResultTypes.push_back(graph.tree.nodes[root].type);
+  }
+}
+
+size_t ExpressionSet::slotOf(std::string_view name) const {
+  auto iter = std::find(m_Program.slots.begin(), m_Program.slots.end(), name);
+  return iter != m_Program.slots.end() ? static_cast<size_t>(iter - m_Program.slots.begin()) : npos;
+}
+
+std::vector<Token> ExpressionSet::bind(const std::function<Token(const std::string &)> &resolve) const {
+  return bindSlots(m_Program, resolve);
+}
+
+void ExpressionSet::evaluate(std::span<const Token> slots, std::span<Result> results) const {
+  auto &workspace = Workspace::local();
+  workspace.reset();
+  evaluate(slots, results, workspace);
+}
+
+void ExpressionSet::evaluate(std::span<const Token> slots, std::span<Result> results, Workspace &workspace) const {
+  if (slots.size() < m_Program.slots.size()) {
+    throw std::runtime_error(std::format("expected {} bound slots, got {}", m_Program.slots.size(), slots.size()));
+  }
+  if (results.size() < size()) {
+    throw std::runtime_error(std::format("expected room for {} results, got {}", size(), results.size()));
+  }
+
+  auto values = executeAll(m_Program, slots, workspace);
+  for (size_t i = 0; i < values.size(); ++i) {
+    results[i] = toResult(values[i]);
+  }
+}
+
+std::vector<Result> ExpressionSet::evaluate(std::span<const Token> slots) const {
+  std::vector<Result> results(size());
+  evaluate(slots, results);
+  return results;
+}
+
+}
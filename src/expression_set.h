@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "bytecode.h"
+#include "evaluate.h"
+#include "expression_tree.h"
+#include "token.h"
+#include "workspace.h"
+
+namespace SYP {
+
+/**
+ * expressions merged into one graph in which identical pure sub-expressions are a single node
+ */
+struct ExpressionGraph {
+  ExpressionTree tree;
+  // node of every expression
+  std::vector<uint32_t> roots;
+  // per node, true if it only depends on its operands
+  std::vector<bool> pure;
+  // per node, how often it's referenced as operand or root
+  std::vector<uint32_t> uses;
+};
+
+/**
+ * build, type check and optimize the tree of every expression and merge them
+ */
+[[nodiscard]] ExpressionGraph mergeExpressions(std::span<const TokenQueue> expressions, const VariableTypes &types);
+
+/**
+ * several expressions compiled together so sub-expressions they have in common are computed only
+ * once per evaluation. The expressions are merged into one graph in which identical pure
+ * sub-expressions, like (price * qty) in several rules, are a single node. Operators are pure,
+ * function calls only if the function was registered as pure.
+ * A shared node is evaluated on its first use and its value reused by any later one, so it isn't
+ * computed at all if all uses are in branches that don't get taken.
+ * Slots are shared too, every variable has one slot for the whole set.
+ * Like CompiledExpression the set is immutable and can be evaluated by any number of threads
+ */
+class ExpressionSet {
+public:
+  static constexpr size_t npos = std::numeric_limits<size_t>::max();
+
+public:
+  explicit ExpressionSet(std::span<const TokenQueue> expressions, const VariableTypes &types = {});
+
+  /**
+   * number of expressions
+   */
+  [[nodiscard]] size_t size() const { return m_ResultTypes.size(); }
+
+  /**
+   * names of the distinct symbols referenced by any of the expressions, the index is the slot
+   */
+  [[nodiscard]] const std::vector<std::string> &variables() const { return m_Program.slots; }
+
+  [[nodiscard]] size_t slotOf(std::string_view name) const;
+
+  [[nodiscard]] TokenType resultType(size_t expression) const { return m_ResultTypes[expression]; }
+
+  /**
+   * number of sub-expressions used more than once that get computed only once
+   */
+  [[nodiscard]] size_t sharedCount() const { return m_Program.memoCount; }
+
+  /**
+   * resolve all slots once, see CompiledExpression::bind
+   */
+  [[nodiscard]] std::vector<Token> bind(const std::function<Token(const std::string &)> &resolve) const;
+
+  /**
+   * evaluate all expressions, results[i] receives the result of expression i
+   */
+  void evaluate(std::span<const Token> slots, std::span<Result> results) const;
+
+  void evaluate(std::span<const Token> slots, std::span<Result> results, Workspace &workspace) const;
+
+  [[nodiscard]] std::vector<Result> evaluate(std::span<const Token> slots) const;
+
+  [[nodiscard]] const Program &program() const { return m_Program; }
+
+private:
+  Program m_Program;
+  std::vector<TokenType> m_ResultTypes;
+};
+
+}
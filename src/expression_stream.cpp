@@ -0,0 +1,42 @@
+#include "expression_stream.h"
+
+#include <algorithm>
+#include <string>
+#include <utility>
+
+namespace SYP {
+
+ExpressionStream::ExpressionStream(ExpressionCallback onExpression, VariableTypes types, SymbolTable &symbols)
+  : m_Tokenizer(symbols), m_Types(std::move(types)), m_OnExpression(std::move(onExpression)),
+    m_OnStatement([this](const TokenQueue &tokens) { compileStatement(tokens); }) {
+}
+
+void ExpressionStream::feed(std::string_view chunk) {
+  m_Tokenizer.feed(chunk, m_OnStatement);
+}
+
+void ExpressionStream::finish() {
+  m_Tokenizer.finish(m_OnStatement);
+}
+
+void ExpressionStream::read(std::istream &in, size_t chunkSize) {
+  // an empty buffer would never reach the end of the stream
+  std::string buffer(std::max<size_t>(chunkSize, 1), '\0');
+  while (in) {
+    in.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    feed(std::string_view(buffer.data(), static_cast<size_t>(in.gcount())));
+  }
+  finish();
+}
+
+void ExpressionStream::reset() {
+  m_Tokenizer.reset();
+  m_Compiled = 0;
+}
+
+void ExpressionStream::compileStatement(const TokenQueue &tokens) {
+  m_OnExpression(CompiledExpression(tokens, m_Types));
+  ++m_Compiled;
+}
+
+}
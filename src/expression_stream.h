@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <istream>
+#include <string_view>
+
+#include "compiled_expression.h"
+#include "shunting_yard.h"
+#include "symbol_table.h"
+#include "type_check.h"
+
+namespace SYP {
+
+/**
+ * compiles a script of statements separated by ';' that is read in chunks, each expression is
+ * passed on as soon as its statement ends. Meant for generated bundles too large to be held in
+ * memory next to the compiled expressions.
+ * If compiling a statement throws, statementCount is the index of that statement. The stream has
+ * to be reset before it can be used again
+ */
+class ExpressionStream {
+public:
+  static constexpr size_t s_DefaultChunkSize = 64 * 1024;
+
+  using ExpressionCallback = std::function<void(CompiledExpression &&expression)>;
+
+public:
+  explicit ExpressionStream(ExpressionCallback onExpression, VariableTypes types = {},
+                            SymbolTable &symbols = SymbolTable::defaultTable());
+
+  ExpressionStream(const ExpressionStream &) = delete;
+  ExpressionStream &operator=(const ExpressionStream &) = delete;
+
+  void feed(std::string_view chunk);
+
+  /**
+   * end of the script, compiles the last statement if it isn't terminated
+   */
+  void finish();
+
+  /**
+   * feed everything read from the stream and finish. A chunk size of 0 reads one byte at a time
+   */
+  void read(std::istream &in, size_t chunkSize = s_DefaultChunkSize);
+
+  /**
+   * drop the partially read statement and start counting statements from zero
+   */
+  void reset();
+
+  /**
+   * number of statements compiled since construction or the last reset
+   */
+  [[nodiscard]] size_t statementCount() const { return m_Compiled; }
+
+private:
+  void compileStatement(const TokenQueue &tokens);
+
+private:
+  StreamTokenizer m_Tokenizer;
+  VariableTypes m_Types;
+  ExpressionCallback m_OnExpression;
+  StreamTokenizer::StatementCallback m_OnStatement;
+  size_t m_Compiled{0};
+};
+
+}
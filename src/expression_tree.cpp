@@ -0,0 +1,115 @@
+#include "expression_tree.h"
+
+#include <algorithm>
+#include <format>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace SYP {
+
+ExpressionTree buildTree(const TokenQueue &tokens) {
+  ExpressionTree tree;
+
+  std::unordered_map<std::string_view, uint32_t> slotIds;
+  std::vector<uint32_t> stack;
+  // stack depths at which function names were pushed, an argument list consumes everything
+  // above the most recent one
+  std::vector<size_t> functionDepths;
+  size_t openTernaries = 0;
+
+  auto pop = [&stack]() {
+    if (stack.empty()) {
+      throw std::runtime_error("failed to compile term");
+    }
+    auto res = stack.back();
+    stack.pop_back();
+    return res;
+  };
+
+  for (const auto &tok : tokens) {
+    switch (tok.type) {
+    case TokenType::Variable:
+    case TokenType::FunctionName: {
+      const auto &name = tok.getVariableName();
+      bool isFunction = tok.type == TokenType::FunctionName;
+      auto [iter, added] = slotIds.emplace(name, static_cast<uint32_t>(tree.slots.size()));
+      if (added) {
+        tree.slots.push_back(name);
+        tree.functionSlots.push_back(isFunction);
+        tree.functions.push_back(isFunction ? tok.function : nullptr);
+        tree.slotTypes.push_back(TokenType::Undefined);
+      } else if (tree.functionSlots[iter->second] != isFunction) {
+        throw std::runtime_error(std::format("{} used both as variable and function", name));
+      }
+      if (isFunction) {
+        functionDepths.push_back(stack.size());
+        stack.push_back(tree.add(Node{ NodeKind::Call, OperatorType::ArgumentList, TokenType::Undefined, iter->second, {} }));
+      } else {
+        stack.push_back(tree.add(Node{ NodeKind::Slot, OperatorType::Invalid, TokenType::Undefined, iter->second, {} }));
+      }
+      break;
+    }
+    case TokenType::Operator: {
+      switch (tok.op) {
+      case OperatorType::Assign:
+        throw std::runtime_error("assignment not supported in compiled expressions");
+      case OperatorType::ArgumentList: {
+        if (functionDepths.empty()) {
+          throw std::runtime_error("argument list without function");
+        }
+        auto depth = functionDepths.back();
+        functionDepths.pop_back();
+        tree.nodes[stack[depth]].operands.assign(stack.begin() + depth + 1, stack.end());
+        stack.resize(depth + 1);
+        break;
+      }
+      case OperatorType::LogicalNot: {
+        auto operand = pop();
+        stack.push_back(tree.add(Node{ NodeKind::Operator, tok.op, TokenType::Undefined, 0, { operand } }));
+        break;
+      }
+      case OperatorType::TernaryE: {
+        auto rhs = pop();
+        auto lhs = pop();
+        auto &cond = tree.nodes[lhs];
+        if ((cond.kind != NodeKind::Operator) || (cond.op != OperatorType::TernaryQ)) {
+          throw std::runtime_error("':' without matching '?'");
+        }
+        cond.kind = NodeKind::Conditional;
+        cond.operands.push_back(rhs);
+        --openTernaries;
+        stack.push_back(lhs);
+        break;
+      }
+      default: {
+        if (tok.op == OperatorType::TernaryQ) {
+          ++openTernaries;
+        }
+        auto rhs = pop();
+        auto lhs = pop();
+        stack.push_back(tree.add(Node{ NodeKind::Operator, tok.op, TokenType::Undefined, 0, { lhs, rhs } }));
+        break;
+      }
+      }
+      break;
+    }
+    default:
+      stack.push_back(tree.add(Node{ NodeKind::Constant, OperatorType::Invalid, tok.type,
+                                     static_cast<uint32_t>(tree.constants.size()), {} }));
+      tree.constants.push_back(tok);
+      break;
+    }
+  }
+
+  if ((stack.size() != 1) || !functionDepths.empty()) {
+    throw std::runtime_error("failed to compile term");
+  }
+  if (openTernaries != 0) {
+    throw std::runtime_error("'?' without matching ':'");
+  }
+
+  tree.root = stack.back();
+  return tree;
+}
+
+}
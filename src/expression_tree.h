@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "token.h"
+
+namespace SYP {
+
+enum class NodeKind : uint8_t {
+  Constant,
+  Slot,
+  Operator,
+  // function call, index is the slot of the function, operands are the arguments
+  Call,
+  // conversion of the single operand to the node type
+  Convert,
+  // ternary, operands are condition, value if true, value if false
+  Conditional,
+};
+
+struct Node {
+  NodeKind kind;
+  OperatorType op{OperatorType::Invalid};
+  // type of the value produced by the node, Undefined if it's only known at runtime
+  TokenType type{TokenType::Undefined};
+  // constant index for Constant, slot index for Slot and Call
+  uint32_t index{0};
+  std::vector<uint32_t> operands;
+};
+
+/**
+ * tree representation of a token queue, nodes refer to their operands by index
+ */
+struct ExpressionTree {
+  std::vector<Node> nodes;
+  std::vector<Token> constants;
+  // names of the referenced symbols, index is the slot
+  std::vector<std::string> slots;
+  std::vector<bool> functionSlots;
+  // symbol table entry for function slots, nullptr for variables
+  std::vector<const FunctionEntry *> functions;
+  // declared type of each slot, Undefined if not known before evaluation
+  std::vector<TokenType> slotTypes;
+  uint32_t root{0};
+
+  uint32_t add(Node node) {
+    nodes.push_back(std::move(node));
+    return static_cast<uint32_t>(nodes.size() - 1);
+  }
+};
+
+/**
+ * build the tree for a token queue in RPN as produced by tokenize
+ */
+[[nodiscard]] ExpressionTree buildTree(const TokenQueue &tokens);
+
+}
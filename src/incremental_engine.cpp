@@ -0,0 +1,171 @@
+#include "incremental_engine.h"
+
+#include "expression_set.h"
+
+#include <algorithm>
+#include <format>
+#include <iterator>
+#include <stdexcept>
+
+namespace SYP {
+
+IncrementalEngine::IncrementalEngine(std::span<const TokenQueue> rules, const VariableTypes &types) {
+  auto graph = mergeExpressions(rules, types);
+  const auto &tree = graph.tree;
+
+  // variables every node reads, operands come before the nodes using them
+  std::vector<std::vector<uint32_t>> reads(tree.nodes.size());
+  for (uint32_t i = 0; i < tree.nodes.size(); ++i) {
+    const auto &node = tree.nodes[i];
+    if ((node.kind == NodeKind::Slot) && !tree.functionSlots[node.index]) {
+      reads[i].push_back(node.index);
+    }
+    for (auto operand : node.operands) {
+      std::vector<uint32_t> merged;
+      std::set_union(reads[i].begin(), reads[i].end(), reads[operand].begin(), reads[operand].end(),
+                     std::back_inserter(merged));
+      reads[i] = std::move(merged);
+    }
+  }
+
+  // a value is worth keeping if it survives changes that invalidate an expression using it
+  std::vector<bool> outlivesUser(tree.nodes.size(), false);
+  for (const auto &node : tree.nodes) {
+    for (auto operand : node.operands) {
+      if (reads[operand].size() != reads[&node - tree.nodes.data()].size()) {
+        outlivesUser[operand] = true;
+      }
+    }
+  }
+
+  m_Slots.names = tree.slots;
+  m_Slots.types = tree.slotTypes;
+  m_Slots.assigned.assign(tree.slots.size(), false);
+  m_Slots.values.resize(tree.slots.size());
+  m_Slots.memos.resize(tree.slots.size());
+  m_Slots.rules.resize(tree.slots.size());
+  for (size_t slot = 0; slot < tree.slots.size(); ++slot) {
+    if (tree.functionSlots[slot]) {
+      m_Slots.values[slot].type = TokenType::Function;
+      m_Slots.values[slot].function = tree.functions[slot];
+      m_Slots.assigned[slot] = true;
+    }
+  }
+
+  std::vector<uint32_t> memo(tree.nodes.size(), 0);
+  for (uint32_t i = 0; i < tree.nodes.size(); ++i) {
+    const auto &node = tree.nodes[i];
+    if (!graph.pure[i] || (node.kind == NodeKind::Constant) || (node.kind == NodeKind::Slot) ||
+        ((graph.uses[i] < 2) && !outlivesUser[i])) {
+      continue;
+    }
+    memo[i] = static_cast<uint32_t>(m_Memo.size() + 1);
+    if ((node.type == TokenType::String) || (node.type == TokenType::Undefined)) {
+      m_StringMemos.push_back(memo[i] - 1);
+    }
+    for (auto slot : reads[i]) {
+      m_Slots.memos[slot].push_back(memo[i] - 1);
+    }
+    m_Memo.emplace_back();
+  }
+
+  for (size_t rule = 0; rule < graph.roots.size(); ++rule) {
+    auto root = graph.roots[rule];
+    auto &entry = m_Rules.emplace_back();
+    entry.program = compile(tree, std::span<const uint32_t>(&root, 1), memo);
+    entry.missing = reads[root].size();
+    for (auto slot : reads[root]) {
+      m_Slots.rules[slot].push_back(rule);
+    }
+    m_Pending.push_back(rule);
+  }
+}
+
+size_t IncrementalEngine::slotOf(std::string_view name) const {
+  auto iter = std::find(m_Slots.names.begin(), m_Slots.names.end(), name);
+  return iter != m_Slots.names.end() ? static_cast<size_t>(iter - m_Slots.names.begin()) : npos;
+}
+
+bool IncrementalEngine::set(std::string_view name, const Token &value) {
+  auto slot = slotOf(name);
+  if (slot == npos) {
+    return false;
+  }
+  set(slot, value);
+  return true;
+}
+
+void IncrementalEngine::set(size_t slot, const Token &value) {
+  if (m_Slots.values[slot].type == TokenType::Function) {
+    throw std::runtime_error(std::format("{} is a function", m_Slots.names[slot]));
+  }
+  if ((m_Slots.types[slot] != TokenType::Undefined) && (value.type != m_Slots.types[slot])) {
+    throw std::runtime_error(std::format("{} declared as {} but set to {}", m_Slots.names[slot],
+                                         getTypeName(m_Slots.types[slot]), getTypeName(value.type)));
+  }
+
+  m_Slots.values[slot] = value;
+  bool first = !m_Slots.assigned[slot];
+  m_Slots.assigned[slot] = true;
+  for (auto memo : m_Slots.memos[slot]) {
+    m_Memo[memo] = Token();
+  }
+  for (auto index : m_Slots.rules[slot]) {
+    auto &rule = m_Rules[index];
+    if (first) {
+      --rule.missing;
+    }
+    if (!rule.pending) {
+      rule.pending = true;
+      m_Pending.push_back(index);
+    }
+  }
+}
+
+const std::vector<size_t> &IncrementalEngine::update() {
+  m_Changed.clear();
+  std::sort(m_Pending.begin(), m_Pending.end());
+
+  size_t done = 0;
+  std::vector<size_t> waiting;
+  try {
+    for (; done < m_Pending.size(); ++done) {
+      auto &rule = m_Rules[m_Pending[done]];
+      if (rule.missing > 0) {
+        waiting.push_back(m_Pending[done]);
+        continue;
+      }
+
+      m_Workspace.reset();
+      auto result = toResult(executeAll(rule.program, m_Slots.values, m_Memo, m_Workspace)[0]);
+      for (auto memo : m_StringMemos) {
+        if (m_Memo[memo].type == TokenType::String) {
+          m_Memo[memo] = Token();
+        }
+      }
+
+      rule.pending = false;
+      if (!rule.evaluated || (result != rule.result)) {
+        rule.result = std::move(result);
+        rule.evaluated = true;
+        m_Changed.push_back(m_Pending[done]);
+      }
+    }
+  } catch (const std::exception &) {
+    // a failed evaluation may have left strings behind
+    for (auto memo : m_StringMemos) {
+      m_Memo[memo] = Token();
+    }
+    waiting.insert(waiting.end(), m_Pending.begin() + done, m_Pending.end());
+    m_Pending = std::move(waiting);
+    throw;
+  }
+  m_Pending = std::move(waiting);
+  return m_Changed;
+}
+
+const Result *IncrementalEngine::result(size_t rule) const {
+  return m_Rules[rule].evaluated ? &m_Rules[rule].result : nullptr;
+}
+
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstddef>
+#include <limits>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "bytecode.h"
+#include "evaluate.h"
+#include "token.h"
+#include "workspace.h"
+
+namespace SYP {
+
+/**
+ * keeps the results of a set of rules up to date while variables change one at a time.
+ * The rules are merged like in ExpressionSet and the engine records which variables every rule
+ * and every sub-expression reads. Sub-expressions that read fewer variables than the expression
+ * using them, or that are shared, keep their value between updates, so after a change only the
+ * rules and sub-expressions reading the changed variable get evaluated again.
+ * Calls to functions that aren't registered as pure are repeated whenever their rule is
+ * evaluated but don't cause a rule to be evaluated on their own.
+ * Not thread safe
+ */
+class IncrementalEngine {
+public:
+  static constexpr size_t npos = std::numeric_limits<size_t>::max();
+
+public:
+  explicit IncrementalEngine(std::span<const TokenQueue> rules, const VariableTypes &types = {});
+
+  IncrementalEngine(const IncrementalEngine &) = delete;
+  IncrementalEngine &operator=(const IncrementalEngine &) = delete;
+
+  /**
+   * number of rules
+   */
+  [[nodiscard]] size_t size() const { return m_Rules.size(); }
+
+  /**
+   * names of the symbols referenced by any rule, the index is the slot
+   */
+  [[nodiscard]] const std::vector<std::string> &variables() const { return m_Slots.names; }
+
+  [[nodiscard]] size_t slotOf(std::string_view name) const;
+
+  /**
+   * change the value of a variable, returns false if no rule reads it. Throws if the value doesn't
+   * match the declared type. A string value has to stay valid as long as it's set
+   */
+  bool set(std::string_view name, const Token &value);
+
+  void set(size_t slot, const Token &value);
+
+  /**
+   * evaluate the rules affected by the changes since the last update. Rules get their first
+   * result once all variables they read are set.
+   * Returns the rules whose result changed, in order, valid until the next update. If a rule
+   * throws, it and the rules after it are evaluated again by the next update
+   */
+  const std::vector<size_t> &update();
+
+  /**
+   * last result of a rule, nullptr if it wasn't evaluated yet
+   */
+  [[nodiscard]] const Result *result(size_t rule) const;
+
+  /**
+   * number of sub-expressions whose values are kept between updates
+   */
+  [[nodiscard]] size_t memoCount() const { return m_Memo.size(); }
+
+private:
+  struct Rule {
+    Program program;
+    // number of variables read by the rule that are not set yet
+    size_t missing{0};
+    bool pending{true};
+    bool evaluated{false};
+    Result result;
+  };
+
+  struct Slots {
+    std::vector<std::string> names;
+    std::vector<TokenType> types;
+    std::vector<bool> assigned;
+    std::vector<Token> values;
+    // memoized sub-expressions and rules reading each slot
+    std::vector<std::vector<uint32_t>> memos;
+    std::vector<std::vector<size_t>> rules;
+  };
+
+private:
+  Slots m_Slots;
+  std::vector<Rule> m_Rules;
+  std::vector<Token> m_Memo;
+  // memo values that may be strings, those reference the workspace and don't survive an evaluation
+  std::vector<uint32_t> m_StringMemos;
+  std::vector<size_t> m_Pending;
+  std::vector<size_t> m_Changed;
+  Workspace m_Workspace;
+};
+
+}
@@ -0,0 +1,450 @@
+#include "jit.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <format>
+#include <stdexcept>
+
+#ifdef PAGAN_JIT
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace SYP {
+
+namespace {
+
+bool isNativeType(TokenType type) {
+  return (type == TokenType::Signed) || (type == TokenType::Unsigned) || (type == TokenType::Float) ||
+         (type == TokenType::Boolean);
+}
+
+bool isNativeInstruction(const Program &program, const Instruction &instruction) {
+  switch (instruction.code()) {
+  case OpCode::Return:
+  case OpCode::LoadSlot:
+  case OpCode::AddI64: case OpCode::AddU64: case OpCode::AddF64:
+  case OpCode::SubI64: case OpCode::SubU64: case OpCode::SubF64:
+  case OpCode::MulI64: case OpCode::MulU64: case OpCode::MulF64:
+  case OpCode::DivF64:
+  case OpCode::ShlI64: case OpCode::ShlU64: case OpCode::ShrU64:
+  case OpCode::XorU64: case OpCode::AndU64: case OpCode::OrU64:
+  case OpCode::LtI64: case OpCode::LtU64: case OpCode::LtF64:
+  case OpCode::LeI64: case OpCode::LeU64: case OpCode::LeF64:
+  case OpCode::GtI64: case OpCode::GtU64: case OpCode::GtF64:
+  case OpCode::GeI64: case OpCode::GeU64: case OpCode::GeF64:
+  case OpCode::EqI64: case OpCode::EqU64: case OpCode::EqF64:
+  case OpCode::NeI64: case OpCode::NeU64: case OpCode::NeF64:
+  case OpCode::EqBool: case OpCode::NeBool:
+  case OpCode::AndBool: case OpCode::OrBool: case OpCode::NotBool:
+  case OpCode::ConvI64ToF64: case OpCode::ConvI64ToU64: case OpCode::ConvU64ToI64:
+  case OpCode::ConvIntToBool:
+  case OpCode::Jump: case OpCode::JumpIfFalse:
+  case OpCode::JumpIfFalseOrPop: case OpCode::JumpIfTrueOrPop:
+    return true;
+  case OpCode::LoadConst:
+    return isNativeType(program.constants[instruction.operand()].type);
+  default:
+    // integer division traps and unsigned conversion to float needs more than one instruction,
+    // both stay in the interpreter like everything dynamic
+    return false;
+  }
+}
+
+#ifdef PAGAN_JIT
+
+// registers as encoded in ModRM
+constexpr uint8_t RAX = 0;
+constexpr uint8_t RCX = 1;
+// the function receives the slots in rdi and the stack buffer in rsi
+constexpr uint8_t SLOTS = 7;
+constexpr uint8_t STACK = 6;
+
+size_t valueOffset() {
+  Token tok(int64_t(0));
+  return static_cast<size_t>(reinterpret_cast<const char *>(&tok.signedValue) - reinterpret_cast<const char *>(&tok));
+}
+
+/**
+ * emits the few x86-64 instruction forms needed, all memory operands are base + disp32
+ */
+class Assembler {
+public:
+  [[nodiscard]] const std::vector<uint8_t> &code() const { return m_Code; }
+
+  void bytes(std::initializer_list<uint8_t> values) { m_Code.insert(m_Code.end(), values); }
+
+  void imm32(uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+      m_Code.push_back(static_cast<uint8_t>(value >> (i * 8)));
+    }
+  }
+
+  void imm64(uint64_t value) {
+    imm32(static_cast<uint32_t>(value));
+    imm32(static_cast<uint32_t>(value >> 32));
+  }
+
+  /**
+   * ModRM and displacement of a memory operand
+   */
+  void memory(uint8_t reg, uint8_t base, uint32_t disp) {
+    m_Code.push_back(static_cast<uint8_t>(0x80 | (reg << 3) | base));
+    imm32(disp);
+  }
+
+  // REX.W opcode reg, [base + disp]
+  void op64(std::initializer_list<uint8_t> opcode, uint8_t reg, uint8_t base, uint32_t disp) {
+    m_Code.push_back(0x48);
+    bytes(opcode);
+    memory(reg, base, disp);
+  }
+
+  // prefix 0F opcode xmm0, [base + disp] for scalar double operations
+  void sse(uint8_t prefix, uint8_t opcode, uint8_t base, uint32_t disp) {
+    bytes({ prefix, 0x0F, opcode });
+    memory(0, base, disp);
+  }
+
+  /**
+   * setcc al with the specified condition code, zero extended to rax
+   */
+  void setAl(uint8_t condition) {
+    bytes({ 0x0F, condition, 0xC0 });
+  }
+
+  void zeroExtendAl() { bytes({ 0x0F, 0xB6, 0xC0 }); }
+
+  /**
+   * jump with a 32 bit displacement, returns the position to patch
+   */
+  size_t jump(std::initializer_list<uint8_t> opcode) {
+    bytes(opcode);
+    imm32(0);
+    return m_Code.size() - 4;
+  }
+
+  void patch(size_t position, size_t target) {
+    auto rel = static_cast<uint32_t>(static_cast<int64_t>(target) - static_cast<int64_t>(position + 4));
+    std::memcpy(m_Code.data() + position, &rel, 4);
+  }
+
+  [[nodiscard]] size_t size() const { return m_Code.size(); }
+
+private:
+  std::vector<uint8_t> m_Code;
+};
+
+class Translator {
+public:
+  explicit Translator(const Program &program)
+    : m_Program(program), m_Depths(program.code.size() + 1, -1), m_Offsets(program.code.size() + 1, 0) {}
+
+  std::vector<uint8_t> translate() {
+    static const size_t s_ValueOffset = valueOffset();
+
+    int depth = 0;
+    for (size_t i = 0; i < m_Program.code.size(); ++i) {
+      // after an unconditional jump the depth is the one recorded by the jump targeting this
+      if (m_Depths[i] >= 0) {
+        depth = m_Depths[i];
+      }
+      m_Offsets[i] = m_Asm.size();
+
+      const auto &instruction = m_Program.code[i];
+      auto top = slot(depth - 1);
+      auto second = slot(depth - 2);
+      switch (instruction.code()) {
+      case OpCode::Return:
+        m_Asm.op64({ 0x8B }, RAX, STACK, top);
+        m_Asm.bytes({ 0xC3 });
+        break;
+      case OpCode::LoadConst: {
+        const auto &tok = m_Program.constants[instruction.operand()];
+        uint64_t bits = tok.type == TokenType::Boolean ? (tok.boolValue ? 1 : 0) : tok.unsignedValue;
+        m_Asm.bytes({ 0x48, 0xB8 });
+        m_Asm.imm64(bits);
+        m_Asm.op64({ 0x89 }, RAX, STACK, slot(depth));
+        ++depth;
+        break;
+      }
+      case OpCode::LoadSlot: {
+        auto disp = static_cast<uint32_t>(instruction.operand() * sizeof(Token) + s_ValueOffset);
+        if (m_Program.slotTypes[instruction.operand()] == TokenType::Boolean) {
+          // only the first byte of the value is set for booleans
+          m_Asm.bytes({ 0x0F, 0xB6 });
+          m_Asm.memory(RAX, SLOTS, disp);
+        } else {
+          m_Asm.op64({ 0x8B }, RAX, SLOTS, disp);
+        }
+        m_Asm.op64({ 0x89 }, RAX, STACK, slot(depth));
+        ++depth;
+        break;
+      }
+      case OpCode::AddI64: case OpCode::AddU64: integer({ 0x03 }, second, top); --depth; break;
+      case OpCode::SubI64: case OpCode::SubU64: integer({ 0x2B }, second, top); --depth; break;
+      case OpCode::MulI64: case OpCode::MulU64: integer({ 0x0F, 0xAF }, second, top); --depth; break;
+      case OpCode::AndU64: case OpCode::AndBool: integer({ 0x23 }, second, top); --depth; break;
+      case OpCode::OrU64: case OpCode::OrBool: integer({ 0x0B }, second, top); --depth; break;
+      case OpCode::XorU64: integer({ 0x33 }, second, top); --depth; break;
+      case OpCode::ShlI64: case OpCode::ShlU64: shift(0xE0, second, top); --depth; break;
+      case OpCode::ShrU64: shift(0xE8, second, top); --depth; break;
+      case OpCode::AddF64: floating(0x58, second, top); --depth; break;
+      case OpCode::SubF64: floating(0x5C, second, top); --depth; break;
+      case OpCode::MulF64: floating(0x59, second, top); --depth; break;
+      case OpCode::DivF64: floating(0x5E, second, top); --depth; break;
+      // condition codes of setcc
+      case OpCode::LtI64: compare(0x9C, second, top); --depth; break;
+      case OpCode::LeI64: compare(0x9E, second, top); --depth; break;
+      case OpCode::GtI64: compare(0x9F, second, top); --depth; break;
+      case OpCode::GeI64: compare(0x9D, second, top); --depth; break;
+      case OpCode::LtU64: compare(0x92, second, top); --depth; break;
+      case OpCode::LeU64: compare(0x96, second, top); --depth; break;
+      case OpCode::GtU64: compare(0x97, second, top); --depth; break;
+      case OpCode::GeU64: compare(0x93, second, top); --depth; break;
+      case OpCode::EqI64: case OpCode::EqU64: case OpCode::EqBool: compare(0x94, second, top); --depth; break;
+      case OpCode::NeI64: case OpCode::NeU64: case OpCode::NeBool: compare(0x95, second, top); --depth; break;
+      // ucomisd sets the flags like an unsigned compare, with all of them set if either is NaN.
+      // a < b is computed as b > a so NaN compares false
+      case OpCode::LtF64: compareFloat(0x97, top, second, second); --depth; break;
+      case OpCode::LeF64: compareFloat(0x93, top, second, second); --depth; break;
+      case OpCode::GtF64: compareFloat(0x97, second, top, second); --depth; break;
+      case OpCode::GeF64: compareFloat(0x93, second, top, second); --depth; break;
+      case OpCode::EqF64:
+      case OpCode::NeF64: {
+        bool equal = instruction.code() == OpCode::EqF64;
+        m_Asm.sse(0xF2, 0x10, STACK, second);
+        m_Asm.bytes({ 0x66, 0x0F, 0x2E });
+        m_Asm.memory(0, STACK, top);
+        // equal: ZF set and PF clear, not equal: ZF clear or PF set
+        m_Asm.setAl(equal ? 0x94 : 0x95);
+        m_Asm.bytes({ 0x0F, static_cast<uint8_t>(equal ? 0x9B : 0x9A), 0xC1 });
+        m_Asm.bytes({ static_cast<uint8_t>(equal ? 0x20 : 0x08), 0xC8 });
+        m_Asm.zeroExtendAl();
+        m_Asm.op64({ 0x89 }, RAX, STACK, second);
+        --depth;
+        break;
+      }
+      case OpCode::NotBool:
+        // xor qword [top], 1
+        m_Asm.op64({ 0x83 }, 6, STACK, top);
+        m_Asm.bytes({ 0x01 });
+        break;
+      case OpCode::ConvI64ToF64:
+        // cvtsi2sd xmm0, qword [top]
+        m_Asm.bytes({ 0xF2, 0x48, 0x0F, 0x2A });
+        m_Asm.memory(0, STACK, top);
+        m_Asm.sse(0xF2, 0x11, STACK, top);
+        break;
+      case OpCode::ConvI64ToU64:
+      case OpCode::ConvU64ToI64:
+        // same representation
+        break;
+      case OpCode::ConvIntToBool:
+        isZero(top);
+        m_Asm.setAl(0x95);
+        m_Asm.zeroExtendAl();
+        m_Asm.op64({ 0x89 }, RAX, STACK, top);
+        break;
+      case OpCode::Jump:
+        jumpTo(m_Asm.jump({ 0xE9 }), instruction.operand(), depth);
+        break;
+      case OpCode::JumpIfFalse:
+        --depth;
+        isZero(top);
+        jumpTo(m_Asm.jump({ 0x0F, 0x84 }), instruction.operand(), depth);
+        break;
+      case OpCode::JumpIfFalseOrPop:
+        // a false condition stays as the result, its representation is already that of false
+        isZero(top);
+        jumpTo(m_Asm.jump({ 0x0F, 0x84 }), instruction.operand(), depth);
+        --depth;
+        break;
+      case OpCode::JumpIfTrueOrPop: {
+        isZero(top);
+        auto skip = m_Asm.jump({ 0x0F, 0x84 });
+        // mov qword [top], 1 so an integer condition becomes true
+        m_Asm.op64({ 0xC7 }, 0, STACK, top);
+        m_Asm.imm32(1);
+        jumpTo(m_Asm.jump({ 0xE9 }), instruction.operand(), depth);
+        m_Asm.patch(skip, m_Asm.size());
+        --depth;
+        break;
+      }
+      default:
+        throw std::runtime_error(std::format("opcode {} not supported by the jit", static_cast<int>(instruction.code())));
+      }
+    }
+    m_Offsets[m_Program.code.size()] = m_Asm.size();
+
+    for (const auto &[position, target] : m_Jumps) {
+      m_Asm.patch(position, m_Offsets[target]);
+    }
+    return m_Asm.code();
+  }
+
+private:
+  static uint32_t slot(int depth) { return static_cast<uint32_t>(depth) * 8; }
+
+  void jumpTo(size_t position, uint32_t target, int depth) {
+    // jumps only go forward, the code at the target hasn't been generated yet
+    m_Depths[target] = depth;
+    m_Jumps.emplace_back(position, target);
+  }
+
+  // cmp qword [operand], 0
+  void isZero(uint32_t operand) {
+    m_Asm.op64({ 0x83 }, 7, STACK, operand);
+    m_Asm.bytes({ 0x00 });
+  }
+
+  void integer(std::initializer_list<uint8_t> opcode, uint32_t lhs, uint32_t rhs) {
+    m_Asm.op64({ 0x8B }, RAX, STACK, lhs);
+    m_Asm.op64(opcode, RAX, STACK, rhs);
+    m_Asm.op64({ 0x89 }, RAX, STACK, lhs);
+  }
+
+  void shift(uint8_t modrm, uint32_t lhs, uint32_t rhs) {
+    m_Asm.op64({ 0x8B }, RAX, STACK, lhs);
+    m_Asm.op64({ 0x8B }, RCX, STACK, rhs);
+    m_Asm.bytes({ 0x48, 0xD3, modrm });
+    m_Asm.op64({ 0x89 }, RAX, STACK, lhs);
+  }
+
+  void floating(uint8_t opcode, uint32_t lhs, uint32_t rhs) {
+    m_Asm.sse(0xF2, 0x10, STACK, lhs);
+    m_Asm.sse(0xF2, opcode, STACK, rhs);
+    m_Asm.sse(0xF2, 0x11, STACK, lhs);
+  }
+
+  void compare(uint8_t condition, uint32_t lhs, uint32_t rhs) {
+    m_Asm.op64({ 0x8B }, RAX, STACK, lhs);
+    m_Asm.op64({ 0x3B }, RAX, STACK, rhs);
+    m_Asm.setAl(condition);
+    m_Asm.zeroExtendAl();
+    m_Asm.op64({ 0x89 }, RAX, STACK, lhs);
+  }
+
+  void compareFloat(uint8_t condition, uint32_t lhs, uint32_t rhs, uint32_t result) {
+    m_Asm.sse(0xF2, 0x10, STACK, lhs);
+    m_Asm.bytes({ 0x66, 0x0F, 0x2E });
+    m_Asm.memory(0, STACK, rhs);
+    m_Asm.setAl(condition);
+    m_Asm.zeroExtendAl();
+    m_Asm.op64({ 0x89 }, RAX, STACK, result);
+  }
+
+private:
+  const Program &m_Program;
+  Assembler m_Asm;
+  // stack depth at instructions targeted by jumps, -1 for the others
+  std::vector<int> m_Depths;
+  // offset of the code generated for each instruction
+  std::vector<size_t> m_Offsets;
+  std::vector<std::pair<size_t, uint32_t>> m_Jumps;
+};
+
+#endif
+
+}
+
+NativeProgram::NativeProgram(void *memory, size_t size, size_t codeSize, TokenType resultType)
+  : m_Memory(memory), m_Size(size), m_CodeSize(codeSize), m_Function(reinterpret_cast<Function>(memory)),
+    m_ResultType(resultType) {
+}
+
+NativeProgram::~NativeProgram() {
+#ifdef PAGAN_JIT
+  munmap(m_Memory, m_Size);
+#endif
+}
+
+bool NativeProgram::isSupported(const Program &program) {
+#ifdef PAGAN_JIT
+  if (!isNativeType(program.resultType) || (program.stackSize > s_MaxStack) || (program.memoCount > 0) ||
+      (program.yieldCount > 0)) {
+    return false;
+  }
+  for (size_t i = 0; i < program.slots.size(); ++i) {
+    if (program.functionSlots[i] || !isNativeType(program.slotTypes[i])) {
+      return false;
+    }
+  }
+  return std::all_of(program.code.begin(), program.code.end(),
+                     [&program](const Instruction &instruction) { return isNativeInstruction(program, instruction); });
+#else
+  (void)program;
+  (void)isNativeInstruction;
+  return false;
+#endif
+}
+
+std::unique_ptr<NativeProgram> NativeProgram::compile(const Program &program) {
+#ifdef PAGAN_JIT
+  if (!isSupported(program)) {
+    return nullptr;
+  }
+  auto code = Translator(program).translate();
+
+  // written while writable, executable afterwards but never both
+  auto page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  size_t size = (code.size() + page - 1) / page * page;
+  void *memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (memory == MAP_FAILED) {
+    throw std::runtime_error("failed to allocate memory for native code");
+  }
+  std::memcpy(memory, code.data(), code.size());
+  if (mprotect(memory, size, PROT_READ | PROT_EXEC) != 0) {
+    munmap(memory, size);
+    throw std::runtime_error("failed to make native code executable");
+  }
+  return std::unique_ptr<NativeProgram>(new NativeProgram(memory, size, code.size(), program.resultType));
+#else
+  (void)program;
+  return nullptr;
+#endif
+}
+
+Token NativeProgram::execute(std::span<const Token> slots) const {
+  uint64_t stack[s_MaxStack];
+  uint64_t bits = m_Function(slots.data(), stack);
+  switch (m_ResultType) {
+  case TokenType::Signed: return Token(static_cast<int64_t>(bits));
+  case TokenType::Unsigned: return Token(bits);
+  case TokenType::Float: return Token(std::bit_cast<double>(bits));
+  default: return Token(bits != 0);
+  }
+}
+
+JitExpression::JitExpression(const TokenQueue &tokens, const VariableTypes &types, uint32_t threshold)
+  : m_Expression(tokens, types), m_Threshold(threshold) {
+  if (threshold == 0) {
+    promote();
+  }
+}
+
+Result JitExpression::evaluate(std::span<const Token> slots) const {
+  if (const auto *native = m_Native.load(std::memory_order_acquire); native != nullptr) {
+    if (slots.size() < m_Expression.slotCount()) {
+      throw std::runtime_error(std::format("expected {} bound slots, got {}", m_Expression.slotCount(), slots.size()));
+    }
+    return toResult(native->execute(slots));
+  }
+  if (!m_Promoted.load(std::memory_order_relaxed) &&
+      (m_Calls.fetch_add(1, std::memory_order_relaxed) + 1 > m_Threshold)) {
+    promote();
+    return evaluate(slots);
+  }
+  return m_Expression.evaluate(slots);
+}
+
+void JitExpression::promote() const {
+  std::call_once(m_Compile, [this]() {
+    m_Code = NativeProgram::compile(m_Expression.program());
+    m_Native.store(m_Code.get(), std::memory_order_release);
+    m_Promoted.store(true, std::memory_order_relaxed);
+  });
+}
+
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "bytecode.h"
+#include "compiled_expression.h"
+
+#if (defined(__x86_64__) || defined(_M_X64)) && defined(__linux__) && !defined(PAGAN_EXPR_TRACE)
+// native code isn't traced, with tracing enabled everything stays in the interpreter
+#define PAGAN_JIT
+#endif
+
+namespace SYP {
+
+/**
+ * machine code generated from a program. Only programs that are fully typed can be compiled:
+ * all slots and the result need a declared numeric or boolean type and the program may only
+ * use typed instructions, no strings, calls, integer division or dynamic operators.
+ * Every position of the evaluation stack is a fixed location in a buffer on the native stack,
+ * slots are loaded straight from the value of the token
+ */
+class NativeProgram {
+public:
+  using Function = uint64_t (*)(const Token *slots, uint64_t *stack);
+
+  static constexpr size_t s_MaxStack = 64;
+
+public:
+  ~NativeProgram();
+
+  NativeProgram(const NativeProgram &) = delete;
+  NativeProgram &operator=(const NativeProgram &) = delete;
+
+  /**
+   * true if the program can be compiled to native code on this platform
+   */
+  [[nodiscard]] static bool isSupported(const Program &program);
+
+  /**
+   * compile to native code, nullptr if that's not supported for the program
+   */
+  [[nodiscard]] static std::unique_ptr<NativeProgram> compile(const Program &program);
+
+  /**
+   * run the code, slots have to contain values of the declared types
+   */
+  [[nodiscard]] Token execute(std::span<const Token> slots) const;
+
+  [[nodiscard]] size_t codeSize() const { return m_CodeSize; }
+
+private:
+  NativeProgram(void *memory, size_t size, size_t codeSize, TokenType resultType);
+
+private:
+  void *m_Memory;
+  size_t m_Size;
+  size_t m_CodeSize;
+  Function m_Function;
+  TokenType m_ResultType;
+};
+
+/**
+ * compiled expression that gets translated to native code once it was evaluated often enough.
+ * Evaluations before that, and all evaluations of expressions that can't be compiled to native
+ * code (see NativeProgram), run in the interpreter with the same results.
+ * Thread safe like CompiledExpression, though evaluations before the promotion count calls on a
+ * shared atomic
+ */
+class JitExpression {
+public:
+  static constexpr uint32_t s_DefaultThreshold = 1000;
+
+public:
+  /**
+   * @param threshold number of interpreted evaluations before the expression gets compiled to
+   *                  native code, 0 to compile right away
+   */
+  explicit JitExpression(const TokenQueue &tokens, const VariableTypes &types = {},
+                         uint32_t threshold = s_DefaultThreshold);
+
+  [[nodiscard]] const CompiledExpression &expression() const { return m_Expression; }
+
+  [[nodiscard]] std::vector<Token> bind(const std::function<Token(const std::string &)> &resolve) const {
+    return m_Expression.bind(resolve);
+  }
+
+  /**
+   * evaluate with the specified slot values, see CompiledExpression::evaluate
+   */
+  [[nodiscard]] Result evaluate(std::span<const Token> slots) const;
+
+  /**
+   * true once evaluations run native code
+   */
+  [[nodiscard]] bool isNative() const { return m_Native.load(std::memory_order_acquire) != nullptr; }
+
+private:
+  void promote() const;
+
+private:
+  CompiledExpression m_Expression;
+  uint32_t m_Threshold;
+  mutable std::atomic<uint32_t> m_Calls{0};
+  // set once compiling was attempted, whether it succeeded or not
+  mutable std::atomic<bool> m_Promoted{false};
+  mutable std::atomic<const NativeProgram *> m_Native{nullptr};
+  mutable std::once_flag m_Compile;
+  mutable std::unique_ptr<NativeProgram> m_Code;
+};
+
+}
@@ -0,0 +1,19 @@
+#include "native_function.h"
+
+#include "type_check.h"
+
+#include <format>
+#include <stdexcept>
+
+namespace SYP {
+
+void throwArityError(size_t expected, size_t actual) {
+  throw std::runtime_error(std::format("function expects {} arguments, got {}", expected, actual));
+}
+
+void throwArgumentTypeError(size_t index, TokenType expected, TokenType actual) {
+  throw std::runtime_error(std::format("type error: argument {} has to be {}, got {}", index + 1,
+                                       getTypeName(expected), getTypeName(actual)));
+}
+
+}
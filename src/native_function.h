@@ -0,0 +1,127 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#include "symbol_table.h"
+#include "token.h"
+
+namespace SYP {
+
+/**
+ * parameter and result types of a function registered with a native signature. The result is
+ * Undefined for functions returning a Token
+ */
+struct FunctionSignature {
+  TokenType result;
+  std::span<const TokenType> parameters;
+};
+
+[[noreturn]] void throwArityError(size_t expected, size_t actual);
+[[noreturn]] void throwArgumentTypeError(size_t index, TokenType expected, TokenType actual);
+
+namespace detail {
+
+template <typename T>
+constexpr TokenType nativeType() {
+  if constexpr (std::is_same_v<T, bool>) {
+    return TokenType::Boolean;
+  } else if constexpr (std::is_floating_point_v<T>) {
+    return TokenType::Float;
+  } else if constexpr (std::is_signed_v<T> && std::is_integral_v<T>) {
+    return TokenType::Signed;
+  } else if constexpr (std::is_unsigned_v<T> && std::is_integral_v<T>) {
+    return TokenType::Unsigned;
+  } else if constexpr (std::is_same_v<T, std::string_view>) {
+    return TokenType::String;
+  } else {
+    return TokenType::Undefined;
+  }
+}
+
+template <typename R, typename... Args>
+inline constexpr std::array<TokenType, sizeof...(Args)> s_ParameterTypes{ nativeType<std::remove_cvref_t<Args>>()... };
+
+template <typename R, typename... Args>
+inline constexpr FunctionSignature s_Signature{ nativeType<R>(), s_ParameterTypes<R, Args...> };
+
+/**
+ * read an argument as the parameter type. Arguments of the declared type are read directly,
+ * dynamically typed ones get the same conversions the type checker would insert
+ */
+template <typename T>
+T unbox(const Token &tok, size_t index) {
+  constexpr auto expected = nativeType<T>();
+  if (tok.type == expected) [[likely]] {
+    if constexpr (expected == TokenType::Boolean) {
+      return tok.boolValue;
+    } else if constexpr (expected == TokenType::Float) {
+      return static_cast<T>(tok.floatValue);
+    } else if constexpr (expected == TokenType::Signed) {
+      return static_cast<T>(tok.signedValue);
+    } else if constexpr (expected == TokenType::Unsigned) {
+      return static_cast<T>(tok.unsignedValue);
+    } else {
+      return std::string_view(*tok.name);
+    }
+  }
+  if constexpr ((expected == TokenType::Float) || (expected == TokenType::Signed) || (expected == TokenType::Unsigned)) {
+    if (tok.type == TokenType::Signed) {
+      return static_cast<T>(tok.signedValue);
+    } else if (tok.type == TokenType::Unsigned) {
+      return static_cast<T>(tok.unsignedValue);
+    }
+  }
+  throwArgumentTypeError(index, expected, tok.type);
+}
+
+template <typename R>
+Token box(R value) {
+  if constexpr (std::is_same_v<R, Token> || std::is_same_v<R, bool>) {
+    return Token(value);
+  } else if constexpr (std::is_floating_point_v<R>) {
+    return Token(static_cast<double>(value));
+  } else if constexpr (std::is_signed_v<R>) {
+    return Token(static_cast<int64_t>(value));
+  } else {
+    return Token(static_cast<uint64_t>(value));
+  }
+}
+
+template <typename R, typename... Args>
+Token callNative(R (*function)(Args...), FunctionArgs args) {
+  if (args.size() != sizeof...(Args)) [[unlikely]] {
+    throwArityError(sizeof...(Args), args.size());
+  }
+  return [&]<size_t... I>(std::index_sequence<I...>) {
+    return box(function(unbox<std::remove_cvref_t<Args>>(args[I], I)...));
+  }(std::index_sequence_for<Args...>{});
+}
+
+template <typename R, typename... Args>
+constexpr const FunctionSignature *signatureOf(R (*)(Args...)) {
+  return &s_Signature<R, Args...>;
+}
+
+}
+
+template <typename R, typename... Args>
+  requires NativeSignature<R, Args...>
+const FunctionEntry *SymbolTable::registerFunction(std::string_view name, R (*function)(Args...), bool pure) {
+  return registerEntry(name, [function](FunctionArgs args) { return detail::callNative(function, args); }, nullptr,
+                       pure, detail::signatureOf(function));
+}
+
+template <auto function>
+  requires IsNativeFunction<decltype(function)>::value
+const FunctionEntry *SymbolTable::registerFunction(std::string_view name, bool pure) {
+  return registerEntry(name, nullptr, [](FunctionArgs args) { return detail::callNative(function, args); }, pure,
+                       detail::signatureOf(function));
+}
+
+}
@@ -0,0 +1,278 @@
+#include "optimizer.h"
+
+#include "bytecode.h"
+
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+
+namespace SYP {
+
+namespace {
+
+bool isInteger(TokenType type) {
+  return (type == TokenType::Signed) || (type == TokenType::Unsigned);
+}
+
+bool isNumeric(TokenType type) {
+  return isInteger(type) || (type == TokenType::Float);
+}
+
+class Optimizer {
+public:
+  explicit Optimizer(ExpressionTree &tree) : m_Tree(tree) {}
+
+  void simplify(uint32_t idx) {
+    for (size_t i = 0; i < m_Tree.nodes[idx].operands.size(); ++i) {
+      simplify(m_Tree.nodes[idx].operands[i]);
+    }
+
+    switch (m_Tree.nodes[idx].kind) {
+    case NodeKind::Constant:
+    case NodeKind::Slot:
+      break;
+    case NodeKind::Convert:
+      if (allConstant(idx)) {
+        fold(idx);
+      }
+      break;
+    case NodeKind::Call:
+      foldCall(idx);
+      break;
+    case NodeKind::Conditional: {
+      const auto &node = m_Tree.nodes[idx];
+      if (isConstant(node.operands[0]) && (typeOf(node.operands[0]) == TokenType::Boolean)) {
+        replaceWith(idx, constant(node.operands[0]).boolValue ? node.operands[1] : node.operands[2]);
+      }
+      break;
+    }
+    case NodeKind::Operator:
+      if (!allConstant(idx) || !fold(idx)) {
+        simplifyOperator(idx);
+      }
+      break;
+    }
+  }
+
+private:
+  [[nodiscard]] TokenType typeOf(uint32_t idx) const { return m_Tree.nodes[idx].type; }
+
+  [[nodiscard]] bool isConstant(uint32_t idx) const { return m_Tree.nodes[idx].kind == NodeKind::Constant; }
+
+  [[nodiscard]] const Token &constant(uint32_t idx) const { return m_Tree.constants[m_Tree.nodes[idx].index]; }
+
+  [[nodiscard]] bool allConstant(uint32_t idx) const {
+    const auto &operands = m_Tree.nodes[idx].operands;
+    return std::all_of(operands.begin(), operands.end(), [this](uint32_t operand) { return isConstant(operand); });
+  }
+
+  [[nodiscard]] bool isConstantValue(uint32_t idx, int64_t value) const {
+    if (!isConstant(idx)) {
+      return false;
+    }
+    const auto &tok = constant(idx);
+    switch (typeOf(idx)) {
+    case TokenType::Signed: return tok.signedValue == value;
+    case TokenType::Unsigned: return tok.unsignedValue == static_cast<uint64_t>(value);
+    case TokenType::Float: return tok.floatValue == static_cast<double>(value);
+    case TokenType::Boolean: return tok.boolValue == (value != 0);
+    default: return false;
+    }
+  }
+
+  /**
+   * true if evaluating the node can't have side effects, so it can be dropped
+   */
+  [[nodiscard]] bool isPure(uint32_t idx) const {
+    const auto &node = m_Tree.nodes[idx];
+    if (node.kind == NodeKind::Call) {
+      const auto *entry = m_Tree.functions[node.index];
+      if ((entry == nullptr) || !entry->pure) {
+        return false;
+      }
+    }
+    return std::all_of(node.operands.begin(), node.operands.end(), [this](uint32_t operand) { return isPure(operand); });
+  }
+
+  /**
+   * power of two exponent of an integer constant, 0 if it's not a power of two greater than one
+   */
+  [[nodiscard]] int powerOfTwo(uint32_t idx) const {
+    if (!isConstant(idx) || !isInteger(typeOf(idx))) {
+      return 0;
+    }
+    const auto &tok = constant(idx);
+    if ((typeOf(idx) == TokenType::Signed) && (tok.signedValue <= 0)) {
+      return 0;
+    }
+    return ((tok.unsignedValue > 1) && std::has_single_bit(tok.unsignedValue)) ? std::countr_zero(tok.unsignedValue) : 0;
+  }
+
+  void replaceWith(uint32_t idx, uint32_t replacement) {
+    m_Tree.nodes[idx] = Node(m_Tree.nodes[replacement]);
+  }
+
+  void replaceWithConstant(uint32_t idx, const Token &value) {
+    m_Tree.nodes[idx] = Node{ NodeKind::Constant, OperatorType::Invalid, value.type,
+                              static_cast<uint32_t>(m_Tree.constants.size()), {} };
+    m_Tree.constants.push_back(value);
+  }
+
+  void setConstant(uint32_t idx, const Token &value) {
+    m_Tree.nodes[idx].index = static_cast<uint32_t>(m_Tree.constants.size());
+    m_Tree.nodes[idx].type = value.type;
+    m_Tree.constants.push_back(value);
+  }
+
+  [[nodiscard]] Token integerConstant(TokenType type, uint64_t value) const {
+    return type == TokenType::Signed ? Token(static_cast<int64_t>(value)) : Token(value);
+  }
+
+  bool fold(uint32_t idx) {
+    const auto &node = m_Tree.nodes[idx];
+    // string results would live in the arena of the folding evaluation
+    if (node.type == TokenType::String) {
+      return false;
+    }
+    try {
+      auto program = compile(m_Tree, idx);
+      Workspace workspace;
+      auto result = execute(program, {}, workspace);
+      if (result.type == TokenType::String) {
+        return false;
+      }
+      replaceWithConstant(idx, result);
+      return true;
+    } catch (const std::exception &) {
+      // invalid operations are reported when evaluating, as they would be without folding
+      return false;
+    }
+  }
+
+  void foldCall(uint32_t idx) {
+    const auto &node = m_Tree.nodes[idx];
+    const auto *entry = m_Tree.functions[node.index];
+    if ((entry == nullptr) || !entry->pure || !entry->defined() || !allConstant(idx)) {
+      return;
+    }
+
+    std::vector<Token> args;
+    for (auto operand : node.operands) {
+      args.push_back(constant(operand));
+    }
+
+    try {
+      auto result = entry->call(args);
+      if ((result.type == TokenType::Boolean) || isNumeric(result.type)) {
+        replaceWithConstant(idx, result);
+      }
+    } catch (const std::exception &) {
+    }
+  }
+
+  void simplifyOperator(uint32_t idx) {
+    auto &node = m_Tree.nodes[idx];
+
+    if (node.op == OperatorType::LogicalNot) {
+      const auto &inner = m_Tree.nodes[node.operands[0]];
+      if ((inner.kind == NodeKind::Operator) && (inner.op == OperatorType::LogicalNot) &&
+          (typeOf(inner.operands[0]) == TokenType::Boolean)) {
+        replaceWith(idx, inner.operands[0]);
+      }
+      return;
+    }
+
+    if (node.operands.size() != 2) {
+      return;
+    }
+
+    auto lhs = node.operands[0];
+    auto rhs = node.operands[1];
+    auto type = node.type;
+
+    if ((node.op == OperatorType::LogicalAnd) || (node.op == OperatorType::LogicalOr)) {
+      if ((typeOf(lhs) != TokenType::Boolean) || (typeOf(rhs) != TokenType::Boolean)) {
+        return;
+      }
+      // the neutral value drops out, the absorbing one decides the result
+      int64_t neutral = node.op == OperatorType::LogicalAnd ? 1 : 0;
+      if (isConstantValue(lhs, neutral)) {
+        replaceWith(idx, rhs);
+      } else if (isConstantValue(rhs, neutral)) {
+        replaceWith(idx, lhs);
+      } else if (isConstantValue(lhs, 1 - neutral)) {
+        replaceWith(idx, lhs);
+      } else if (isConstantValue(rhs, 1 - neutral) && isPure(lhs)) {
+        replaceWith(idx, rhs);
+      }
+      return;
+    }
+
+    if (!isNumeric(type) || (typeOf(lhs) != type) || (typeOf(rhs) != type)) {
+      return;
+    }
+
+    switch (node.op) {
+    case OperatorType::Add:
+      // x + 0 isn't an identity for floats, -0.0 + 0.0 is 0.0
+      if (isInteger(type) && isConstantValue(rhs, 0)) {
+        replaceWith(idx, lhs);
+      } else if (isInteger(type) && isConstantValue(lhs, 0)) {
+        replaceWith(idx, rhs);
+      }
+      break;
+    case OperatorType::Subtract:
+      if (isConstantValue(rhs, 0)) {
+        replaceWith(idx, lhs);
+      }
+      break;
+    case OperatorType::Multiply:
+      if (isConstantValue(rhs, 1)) {
+        replaceWith(idx, lhs);
+      } else if (isConstantValue(lhs, 1)) {
+        replaceWith(idx, rhs);
+      } else if (isInteger(type) && isConstantValue(rhs, 0) && isPure(lhs)) {
+        replaceWith(idx, rhs);
+      } else if (isInteger(type) && isConstantValue(lhs, 0) && isPure(rhs)) {
+        replaceWith(idx, lhs);
+      } else if (isInteger(type)) {
+        if (powerOfTwo(lhs) != 0) {
+          std::swap(node.operands[0], node.operands[1]);
+          std::swap(lhs, rhs);
+        }
+        if (auto shift = powerOfTwo(rhs); shift != 0) {
+          node.op = OperatorType::ShiftLeft;
+          setConstant(rhs, integerConstant(type, shift));
+        }
+      }
+      break;
+    case OperatorType::Divide:
+      if (isConstantValue(rhs, 1)) {
+        replaceWith(idx, lhs);
+      } else if (auto shift = powerOfTwo(rhs); (type == TokenType::Unsigned) && (shift != 0)) {
+        node.op = OperatorType::ShiftRight;
+        setConstant(rhs, integerConstant(type, shift));
+      }
+      break;
+    case OperatorType::Modulo:
+      if (auto shift = powerOfTwo(rhs); (type == TokenType::Unsigned) && (shift != 0)) {
+        node.op = OperatorType::BitwiseAnd;
+        setConstant(rhs, integerConstant(type, (uint64_t(1) << shift) - 1));
+      }
+      break;
+    default:
+      break;
+    }
+  }
+
+private:
+  ExpressionTree &m_Tree;
+};
+
+}
+
+void optimize(ExpressionTree &tree) {
+  Optimizer(tree).simplify(tree.root);
+}
+
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "expression_tree.h"
+
+namespace SYP {
+
+/**
+ * simplify a type checked tree in place:
+ * - sub-expressions with only constant operands are evaluated, this includes calls to functions
+ *   registered as pure and conditionals with a constant condition
+ * - identities like x * 1, x + 0, true && x or false || x are reduced to x
+ * - integer multiplication (and unsigned division/modulo) by powers of two become shifts/masks
+ */
+void optimize(ExpressionTree &tree);
+
+}
@@ -0,0 +1,165 @@
+#include "parallel_evaluator.h"
+
+#include <algorithm>
+#include <format>
+#include <stdexcept>
+
+namespace SYP {
+
+ParallelEvaluator::ParallelEvaluator(size_t threads, size_t chunkRows)
+  : m_ChunkRows(std::max<size_t>(chunkRows, 1)) {
+  if (threads == 0) {
+    threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+  }
+  for (size_t i = 0; i < threads; ++i) {
+    m_Workers.push_back(std::make_unique<Worker>());
+  }
+  // the thread calling evaluate is the first worker
+  for (size_t i = 1; i < threads; ++i) {
+    m_Threads.emplace_back([this, i]() { workerLoop(i); });
+  }
+}
+
+ParallelEvaluator::~ParallelEvaluator() {
+  {
+    std::lock_guard lock(m_Mutex);
+    m_Stop = true;
+  }
+  m_Start.notify_all();
+  for (auto &thread : m_Threads) {
+    thread.join();
+  }
+}
+
+void ParallelEvaluator::evaluate(std::span<const CompiledExpression> expressions, const RowSet &rows,
+                                 std::span<const OutputColumn> outputs) {
+  std::lock_guard evaluateLock(m_EvaluateMutex);
+
+  if (outputs.size() != expressions.size()) {
+    throw std::runtime_error(std::format("expected {} output columns, got {}", expressions.size(), outputs.size()));
+  }
+
+  m_Job.expressions = expressions;
+  m_Job.outputs = outputs;
+  m_Job.rows = rows.size();
+  m_Job.columns.resize(expressions.size());
+  for (size_t i = 0; i < expressions.size(); ++i) {
+    auto &columns = m_Job.columns[i];
+    columns.clear();
+    for (const auto &name : expressions[i].variables()) {
+      const auto *column = rows.find(name);
+      if (column == nullptr) {
+        throw std::runtime_error(std::format("no column for {}", name));
+      }
+      columns.push_back(*column);
+    }
+  }
+
+  size_t chunks = (rows.size() + m_ChunkRows - 1) / m_ChunkRows;
+  size_t tasks = chunks * expressions.size();
+  if (tasks == 0) {
+    return;
+  }
+
+  m_Error = nullptr;
+  {
+    std::lock_guard lock(m_Mutex);
+    for (size_t i = 0; i < m_Workers.size(); ++i) {
+      m_Workers[i]->begin = tasks * i / m_Workers.size();
+      m_Workers[i]->end = tasks * (i + 1) / m_Workers.size();
+    }
+    m_Running = m_Threads.size();
+    ++m_Generation;
+  }
+  m_Start.notify_all();
+
+  work(0);
+
+  {
+    std::unique_lock lock(m_Mutex);
+    m_Done.wait(lock, [this]() { return m_Running == 0; });
+  }
+
+  if (m_Error) {
+    std::rethrow_exception(m_Error);
+  }
+}
+
+void ParallelEvaluator::workerLoop(size_t worker) {
+  size_t generation = 0;
+  for (;;) {
+    {
+      std::unique_lock lock(m_Mutex);
+      m_Start.wait(lock, [this, generation]() { return m_Stop || (m_Generation != generation); });
+      if (m_Stop) {
+        return;
+      }
+      generation = m_Generation;
+    }
+
+    work(worker);
+
+    std::lock_guard lock(m_Mutex);
+    if (--m_Running == 0) {
+      m_Done.notify_all();
+    }
+  }
+}
+
+void ParallelEvaluator::work(size_t worker) {
+  size_t task;
+  while (next(worker, task)) {
+    try {
+      runTask(*m_Workers[worker], task);
+    } catch (const std::exception &) {
+      {
+        std::lock_guard lock(m_Mutex);
+        if (!m_Error) {
+          m_Error = std::current_exception();
+        }
+      }
+      // no point in continuing, drop everything that hasn't been started yet
+      for (auto &other : m_Workers) {
+        std::lock_guard lock(other->mutex);
+        other->begin = other->end;
+      }
+    }
+  }
+}
+
+bool ParallelEvaluator::next(size_t worker, size_t &task) {
+  {
+    auto &own = *m_Workers[worker];
+    std::lock_guard lock(own.mutex);
+    if (own.begin < own.end) {
+      task = own.begin++;
+      return true;
+    }
+  }
+
+  for (size_t i = 1; i < m_Workers.size(); ++i) {
+    auto &victim = *m_Workers[(worker + i) % m_Workers.size()];
+    std::lock_guard lock(victim.mutex);
+    if (victim.begin < victim.end) {
+      task = --victim.end;
+      return true;
+    }
+  }
+  return false;
+}
+
+void ParallelEvaluator::runTask(Worker &worker, size_t task) {
+  // neighbouring tasks are the expressions of one chunk so the rows stay in cache
+  size_t expression = task % m_Job.expressions.size();
+  size_t offset = (task / m_Job.expressions.size()) * m_ChunkRows;
+  size_t count = std::min(m_ChunkRows, m_Job.rows - offset);
+
+  worker.columns.clear();
+  for (const auto &column : m_Job.columns[expression]) {
+    worker.columns.push_back(column.from(offset));
+  }
+  evaluateBatch(m_Job.expressions[expression], worker.columns, count, m_Job.outputs[expression].from(offset),
+                worker.workspace);
+}
+
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "batch.h"
+#include "compiled_expression.h"
+
+namespace SYP {
+
+/**
+ * named columns of equal length that a set of expressions gets evaluated over
+ */
+class RowSet {
+public:
+  explicit RowSet(size_t rows) : m_Rows(rows) {}
+
+  RowSet &add(std::string name, Column column) {
+    m_Columns.insert_or_assign(std::move(name), column);
+    return *this;
+  }
+
+  [[nodiscard]] size_t size() const { return m_Rows; }
+
+  /**
+   * column for a variable, nullptr if there is none
+   */
+  [[nodiscard]] const Column *find(const std::string &name) const {
+    auto iter = m_Columns.find(name);
+    return iter != m_Columns.end() ? &iter->second : nullptr;
+  }
+
+private:
+  size_t m_Rows;
+  std::unordered_map<std::string, Column> m_Columns;
+};
+
+/**
+ * evaluates many compiled expressions over many rows on a pool of worker threads.
+ * The rows get split into chunks and every (chunk, expression) pair is a task. Each worker starts
+ * with an equal share of the tasks and steals from the others once it runs out, so expressions of
+ * very different cost still keep all threads busy. Every worker has its own Workspace.
+ * Results are written to the output columns at the position of their row so they are in order
+ * without any merging.
+ * One evaluation runs at a time, concurrent calls to evaluate are serialized
+ */
+class ParallelEvaluator {
+public:
+  static constexpr size_t s_DefaultChunkRows = 4096;
+
+public:
+  /**
+   * @param threads number of threads evaluating, including the one calling evaluate. 0 to use
+   *                one per available core
+   * @param chunkRows number of rows evaluated by one task
+   */
+  explicit ParallelEvaluator(size_t threads = 0, size_t chunkRows = s_DefaultChunkRows);
+  ~ParallelEvaluator();
+
+  ParallelEvaluator(const ParallelEvaluator &) = delete;
+  ParallelEvaluator &operator=(const ParallelEvaluator &) = delete;
+
+  [[nodiscard]] size_t threadCount() const { return m_Workers.size(); }
+
+  /**
+   * evaluate every expression for all rows, outputs[i] receives the results of expressions[i] and
+   * needs room for rows.size() values. Throws if a column is missing, for the reasons
+   * evaluateBatch throws or if any evaluation fails, in which case the content of the outputs is
+   * undefined
+   */
+  void evaluate(std::span<const CompiledExpression> expressions, const RowSet &rows,
+                std::span<const OutputColumn> outputs);
+
+private:
+  struct Worker {
+    // range of task indices that haven't been started yet, the worker takes from the front,
+    // others steal from the back
+    std::mutex mutex;
+    size_t begin{0};
+    size_t end{0};
+    Workspace workspace;
+    // columns of the current task, offset to its first row
+    std::vector<Column> columns;
+  };
+
+  struct Job {
+    std::span<const CompiledExpression> expressions;
+    std::span<const OutputColumn> outputs;
+    // columns of every expression in slot order
+    std::vector<std::vector<Column>> columns;
+    size_t rows{0};
+  };
+
+private:
+  void workerLoop(size_t worker);
+  void work(size_t worker);
+  bool next(size_t worker, size_t &task);
+  void runTask(Worker &worker, size_t task);
+
+private:
+  size_t m_ChunkRows;
+  std::vector<std::unique_ptr<Worker>> m_Workers;
+  std::vector<std::thread> m_Threads;
+
+  std::mutex m_EvaluateMutex;
+  std::mutex m_Mutex;
+  std::condition_variable m_Start;
+  std::condition_variable m_Done;
+  // incremented for every job so workers can tell a new job from a spurious wakeup
+  size_t m_Generation{0};
+  size_t m_Running{0};
+  bool m_Stop{false};
+
+  Job m_Job;
+  std::exception_ptr m_Error;
+};
+
+}
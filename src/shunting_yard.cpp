@@ -1,262 +1,274 @@
 #include "shunting_yard.h"
+#include "workspace.h"
+#include <algorithm>
+#include <array>
 #include <charconv>
+#include <cstdint>
 #include <format>
 #include <stdexcept>
-#include <unordered_map>
-#include <iostream>
 
 namespace SYP {
 
-template <typename T, bool isHex>
-auto strToNum(const std::string_view& view, T& value)
+template <typename T>
+[[nodiscard]] Token numericalFromString(std::string_view view, int base = 10)
 {
-  if constexpr (std::is_same_v<T, float> || std::is_same_v<T, double>) {
-    std::size_t idx = 0;
-    value = std::stod(std::string(view), &idx);
-    return std::from_chars_result{ view.data() + idx, std::errc{} };
-  }
-  else if constexpr (isHex) {
-    return std::from_chars(view.data(), view.data() + view.size(), value, 16);
+  T value;
+  std::from_chars_result result;
+  if constexpr (std::is_floating_point_v<T>) {
+    // from_chars is locale independent and doesn't allocate, unlike stod
+    result = std::from_chars(view.data(), view.data() + view.size(), value);
   }
   else {
-    return std::from_chars(view.data(), view.data() + view.size(), value);
+    result = std::from_chars(view.data(), view.data() + view.size(), value, base);
   }
-}
-
-template <typename T, bool isHex>
-[[nodiscard]] Token numericalFromString(std::string_view& view, bool isNegative)
-{
-  T value;
-  auto [ptr, ec] = strToNum<T, isHex>(view, value);
-  if (ec != std::errc{}) {
-    throw std::runtime_error(
-      std::format("failed to parse number: {}", static_cast<int>(ec)));
+  if (result.ec == std::errc::result_out_of_range) {
+    throw std::runtime_error(std::format("number out of range: {}", view));
   }
-  if (isNegative) {
-    value = -value;
+  if ((result.ec != std::errc{}) || (result.ptr != view.data() + view.size())) {
+    throw std::runtime_error(std::format("failed to parse number: {}", view));
   }
   return Token(value);
 }
 
+enum class CharClass : uint8_t {
+  Invalid,
+  // whitespace and the comma separating function arguments
+  Space,
+  Digit,
+  Identifier,
+  Operator,
+  Quote,
+  BracketOpen,
+  BracketClose,
+};
+
+constexpr std::array<CharClass, 256> makeCharClasses() {
+  std::array<CharClass, 256> result{};
+  for (unsigned ch = 0; ch < 256; ++ch) {
+    if ((ch == ' ') || (ch == '\t') || (ch == '\r') || (ch == '\n') || (ch == ',')) {
+      result[ch] = CharClass::Space;
+    } else if ((ch >= '0') && (ch <= '9')) {
+      result[ch] = CharClass::Digit;
+    } else if (((ch >= 'a') && (ch <= 'z')) || ((ch >= 'A') && (ch <= 'Z')) || (ch == '_') || (ch == '.')) {
+      result[ch] = CharClass::Identifier;
+    } else if (std::string_view("+-*/%^<>=!&|?:").find(static_cast<char>(ch)) != std::string_view::npos) {
+      result[ch] = CharClass::Operator;
+    } else if (ch == '"') {
+      result[ch] = CharClass::Quote;
+    } else if (ch == '(') {
+      result[ch] = CharClass::BracketOpen;
+    } else if (ch == ')') {
+      result[ch] = CharClass::BracketClose;
+    }
+  }
+  return result;
+}
+
+constexpr std::array<CharClass, 256> s_CharClasses = makeCharClasses();
+
+inline CharClass classify(char ch) {
+  return s_CharClasses[static_cast<unsigned char>(ch)];
+}
+
 inline bool isNumDigit(char ch)
 {
-  return (ch >= '0') && (ch <= '9');
+  return classify(ch) == CharClass::Digit;
 }
 
 inline bool isHexDigit(char ch)
 {
-  return ((ch >= 'A') && (ch <= 'F')) || ((ch >= 'a') && (ch <= 'f'));
+  return isNumDigit(ch) || ((ch >= 'A') && (ch <= 'F')) || ((ch >= 'a') && (ch <= 'f'));
 }
 
+inline bool isIdentifierCharacter(char ch) {
+  auto cls = classify(ch);
+  return (cls == CharClass::Identifier) || (cls == CharClass::Digit);
+}
+
+inline bool isBinDigit(char ch)
+{
+  return (ch == '0') || (ch == '1');
+}
+
+/**
+ * read a number literal. Decimal numbers are signed unless they have a fraction or exponent,
+ * 0x (hexadecimal) and 0b (binary) numbers are unsigned
+ */
 [[nodiscard]] Token readNumberToken(std::string_view::const_iterator& pos,
   std::string_view::const_iterator end) {
-  bool isFloat = false;
-  bool isNegative = false;
-  bool isHex = false;
-
-  if (*pos == '-') {
-    isNegative = true;
+  // the sign stays part of the literal so the most negative integer can be parsed
+  auto beg = pos;
+  bool isNegative = *pos == '-';
+  if (isNegative) {
     ++pos;
   }
-  if ((*pos == '0') && ((pos + 1) != end) && (*(pos + 1) == 'x')) {
-    isHex = true;
-    pos += 2;
-  }
 
-  std::string_view::const_iterator beg = pos++;
+  auto skip = [&pos, end](auto predicate) {
+    while ((pos != end) && predicate(*pos)) {
+      ++pos;
+    }
+  };
 
-  while ((pos != end) && (isNumDigit(*pos) || (*pos == '.') || (isHex && isHexDigit(*pos)))) {
-    if (*pos == '.') {
-      if (isFloat) {
+  if ((*pos == '0') && ((pos + 1) != end)) {
+    char prefix = *(pos + 1);
+    int base = ((prefix == 'x') || (prefix == 'X')) ? 16 : ((prefix == 'b') || (prefix == 'B')) ? 2 : 0;
+    if (base != 0) {
+      if (isNegative) {
         throw std::runtime_error("invalid number format");
       }
-      isFloat = true;
+      pos += 2;
+      auto digits = pos;
+      skip(base == 16 ? isHexDigit : isBinDigit);
+      if ((pos == digits) || ((pos != end) && isIdentifierCharacter(*pos))) {
+        throw std::runtime_error("invalid number format");
+      }
+      return numericalFromString<uint64_t>(std::string_view(digits, pos), base);
     }
-    ++pos;
   }
 
-  if ((isFloat && isHex) || (isNegative && isHex)) {
+  bool isFloat = false;
+  skip(isNumDigit);
+  if ((pos != end) && (*pos == '.')) {
+    isFloat = true;
+    ++pos;
+    skip(isNumDigit);
+  }
+  if ((pos != end) && ((*pos == 'e') || (*pos == 'E'))) {
+    isFloat = true;
+    ++pos;
+    if ((pos != end) && ((*pos == '+') || (*pos == '-'))) {
+      ++pos;
+    }
+    auto exponent = pos;
+    skip(isNumDigit);
+    if (pos == exponent) {
+      throw std::runtime_error("invalid number format");
+    }
+  }
+  if ((pos != end) && isIdentifierCharacter(*pos)) {
+    // things like 1.2.3 or 12abc
     throw std::runtime_error("invalid number format");
   }
 
   std::string_view view(beg, pos);
   if (isFloat) {
-    return numericalFromString<double, false>(view, isNegative);
-  }
-  else if (isHex) {
-    return numericalFromString<uint64_t, true>(view, isNegative);
+    return numericalFromString<double>(view);
   }
   else {
-    return numericalFromString<int64_t, false>(view, isNegative);
+    return numericalFromString<int64_t>(view);
   }
 }
 
-inline bool isIdentifierCharacter(char ch) {
-  return ((ch >= '0') && (ch <= '9')) || ((ch >= 'a') && (ch <= 'z')) ||
-         ((ch >= 'A') && (ch <= 'Z')) || (ch == '_') || (ch == '.');
-}
-
 [[nodiscard]] Token readIdentifierToken(std::string_view::const_iterator &pos,
-                                        std::string_view::const_iterator end) {
+                                        std::string_view::const_iterator end,
+                                        SymbolTable &symbols) {
   std::string_view::const_iterator beg = pos++;
 
   while ((pos != end) && isIdentifierCharacter(*pos)) {
     ++pos;
   }
 
+  std::string_view name(beg, pos);
+  // word operators only count as such if they aren't part of a longer identifier
+  if (name == "and") {
+    return Token(OperatorType::LogicalAnd);
+  } else if (name == "or") {
+    return Token(OperatorType::LogicalOr);
+  }
+
   auto peek = pos;
   while ((peek != end) && (*peek == ' ')) {
     ++peek;
   }
   if ((peek != end) && (*peek == '(')) {
     // identifier followed by bracket => function
-    return Token(std::string(beg, pos), TokenType::FunctionName);
+    return Token(name, TokenType::FunctionName, symbols);
   }
-  return Token(std::string(beg, pos), TokenType::Variable);
+  return Token(name, TokenType::Variable, symbols);
 }
 
 [[nodiscard]] Token readStringToken(std::string_view::const_iterator &pos,
-                                    std::string_view::const_iterator end) {
+                                    std::string_view::const_iterator end,
+                                    SymbolTable &symbols) {
   std::string_view::const_iterator beg = ++pos;
 
   while ((pos != end) && (*pos != '"')) {
     ++pos;
   }
+  if (pos == end) {
+    throw std::runtime_error("unterminated string");
+  }
 
-  return Token(std::string(beg, pos++), TokenType::String);
+  return Token(std::string_view(beg, pos++), TokenType::String, symbols);
 }
 
 [[nodiscard]] Token readOperatorToken(std::string_view::const_iterator &pos,
                                       std::string_view::const_iterator end) {
-  static std::unordered_map<char, unsigned> OPERATORS_1 = {
-      {'+', static_cast<unsigned>(OperatorType::Add)},
-      {'-', static_cast<unsigned>(OperatorType::Subtract)},
-      {'*', static_cast<unsigned>(OperatorType::Multiply)},
-      {'/', static_cast<unsigned>(OperatorType::Divide)},
-      {'%', static_cast<unsigned>(OperatorType::Modulo)},
-      {'^', static_cast<unsigned>(OperatorType::Xor)},
-      {'<', static_cast<unsigned>(OperatorType::Incomplete) + '<'},
-      {'>', static_cast<unsigned>(OperatorType::Incomplete) + '>'},
-      {'=', static_cast<unsigned>(OperatorType::Incomplete) + '='},
-      {'!', static_cast<unsigned>(OperatorType::Incomplete) + '!'},
-      {'&', static_cast<unsigned>(OperatorType::Incomplete) + '&'},
-      {'|', static_cast<unsigned>(OperatorType::Incomplete) + '|'},
-      {'a', static_cast<unsigned>(OperatorType::Incomplete) + 'a'},
-      {'o', static_cast<unsigned>(OperatorType::Incomplete) + 'o'},
-      {'?', static_cast<unsigned>(OperatorType::TernaryQ)},
-      {':', static_cast<unsigned>(OperatorType::TernaryE)}};
-
-  static std::unordered_map<char, std::unordered_map<char, unsigned>>
-      OPERATORS_2 = {
-          {'>',
-           {
-               {'>', static_cast<unsigned>(OperatorType::ShiftRight)},
-               {'=', static_cast<unsigned>(OperatorType::GreaterOrEqual)},
-               {'_', static_cast<unsigned>(OperatorType::GreaterThan)},
-           }},
-          {'<',
-           {
-               {'<', static_cast<unsigned>(OperatorType::ShiftLeft)},
-               {'=', static_cast<unsigned>(OperatorType::LessOrEqual)},
-               {'_', static_cast<unsigned>(OperatorType::LessThan)},
-           }},
-          {'!',
-           {
-               {'=', static_cast<unsigned>(OperatorType::NotEqual)},
-               {'_', static_cast<unsigned>(OperatorType::LogicalNot)},
-           }},
-          {'=',
-           {
-               {'=', static_cast<unsigned>(OperatorType::Equal)},
-               {'_', static_cast<unsigned>(OperatorType::Assign)},
-           }},
-          {'&',
-           {
-               {'&', static_cast<unsigned>(OperatorType::LogicalAnd)},
-               {'_', static_cast<unsigned>(OperatorType::BitwiseAnd)},
-           }},
-          {'|',
-           {
-               {'|', static_cast<unsigned>(OperatorType::LogicalOr)},
-               {'_', static_cast<unsigned>(OperatorType::BitwiseOr)},
-           }},
-          {'o',
-           {
-               {'r', static_cast<unsigned>(OperatorType::LogicalOr)},
-           }}};
-
-  auto oldPos = pos;
-
-  unsigned result = 0;
-
-  if (auto iter = OPERATORS_1.find(*pos++); iter != OPERATORS_1.end()) {
-    result = iter->second;
-    if (result > static_cast<unsigned>(OperatorType::Incomplete)) {
-      // in cases like <, the single character could be the operator or it could be << or <= so we
-      // peek at the next character(s) - if it is part of a sequence, that is the operator and we consume
-      // the next character as well, otherwise we use _ in the map to denote the "single character case"
-
-      auto firstChar = result - static_cast<unsigned>(OperatorType::Incomplete);
-      if ((firstChar == 'a') && (*pos == 'n') && (*(pos + 1) == 'd')) {
-        // and is currently handled as an exception as it's the only three
-        // character operator we support
-        result = static_cast<unsigned>(OperatorType::LogicalAnd);
-        pos += 2;
-      } else {
-        auto iter_2 = OPERATORS_2.find(firstChar);
-        result = 0;
-        if (iter_2 != OPERATORS_2.end()) {
-          const auto &nextDict = *iter_2;
-          char nextChar = *pos;
-          auto iter = nextDict.second.find(nextChar);
-          if (iter != nextDict.second.end()) {
-            result = iter->second;
-            ++pos;
-          } else {
-            auto iter_3 = nextDict.second.find('_');
-            if (iter_3 != nextDict.second.end()) {
-              result = iter_3->second;
-            }
-          }
-        }
-      }
-
-      // throw std::runtime_error(std::format("operator not supported: {}",
-      // *pos));
+  char ch = *pos++;
+  // consumes the next character if it's the expected one, for two character operators
+  auto follows = [&pos, end](char expected) {
+    if ((pos != end) && (*pos == expected)) {
+      ++pos;
+      return true;
     }
+    return false;
+  };
+
+  switch (ch) {
+  case '+': return Token(OperatorType::Add);
+  case '-': return Token(OperatorType::Subtract);
+  case '*': return Token(OperatorType::Multiply);
+  case '/': return Token(OperatorType::Divide);
+  case '%': return Token(OperatorType::Modulo);
+  case '^': return Token(OperatorType::Xor);
+  case '?': return Token(OperatorType::TernaryQ);
+  case ':': return Token(OperatorType::TernaryE);
+  case '<':
+    return Token(follows('<') ? OperatorType::ShiftLeft
+                 : follows('=') ? OperatorType::LessOrEqual
+                                : OperatorType::LessThan);
+  case '>':
+    return Token(follows('>') ? OperatorType::ShiftRight
+                 : follows('=') ? OperatorType::GreaterOrEqual
+                                : OperatorType::GreaterThan);
+  case '!': return Token(follows('=') ? OperatorType::NotEqual : OperatorType::LogicalNot);
+  case '=': return Token(follows('=') ? OperatorType::Equal : OperatorType::Assign);
+  case '&': return Token(follows('&') ? OperatorType::LogicalAnd : OperatorType::BitwiseAnd);
+  case '|': return Token(follows('|') ? OperatorType::LogicalOr : OperatorType::BitwiseOr);
+  default: throw std::runtime_error(std::format("operator not supported: {}", ch));
   }
-
-  if (result == 0) {
-    // not an operator, revert parse position
-    pos = oldPos;
-  }
-
-  return Token(static_cast<OperatorType>(result));
 }
 
+/**
+ * read the token starting at pos, which must not be whitespace. afterOperand tells whether the
+ * previous token was a value, in which case '-' is the subtraction operator rather than a sign
+ */
 [[nodiscard]] Token nextToken(std::string_view::const_iterator &pos,
-                              std::string_view::const_iterator end) {
-  while ((*pos == ' ') || (*pos == '\r') || (*pos == '\n') || (*pos == ',')) {
-    ++pos;
-  }
+                              std::string_view::const_iterator end,
+                              bool afterOperand,
+                              SymbolTable &symbols) {
   char ch = *pos;
-  if (((ch >= '0') && (ch <= '9')) || (ch == '-')) {
+  switch (classify(ch)) {
+  case CharClass::Digit:
     return readNumberToken(pos, end);
-  } else if (auto tok = readOperatorToken(pos, end); tok.op != OperatorType::Invalid) {
-    return tok;
-  } else if (isIdentifierCharacter(ch)) {
-    return readIdentifierToken(pos, end);
-  } else if (ch == '"') {
-    return readStringToken(pos, end);
-  } else if (ch == '(') {
+  case CharClass::Operator:
+    if ((ch == '-') && !afterOperand && ((pos + 1) != end) && isNumDigit(*(pos + 1))) {
+      return readNumberToken(pos, end);
+    }
+    return readOperatorToken(pos, end);
+  case CharClass::Identifier:
+    return readIdentifierToken(pos, end, symbols);
+  case CharClass::Quote:
+    return readStringToken(pos, end, symbols);
+  case CharClass::BracketOpen:
     ++pos;
     return Token(OperatorType::BracketOpen);
-  } else if (ch == ')') {
+  case CharClass::BracketClose:
     ++pos;
     return Token(OperatorType::BracketClose);
+  default:
+    throw std::runtime_error(std::format("failed to parse token {}", ch));
   }
-  std::cout << "failed to parse token " << ch << std::endl;
-  throw std::runtime_error("failed to parse token");
 }
 
 void pushBracketClose(std::vector<Token> &output_stack,
@@ -282,7 +294,10 @@ void pushOperator(std::vector<Token> &output_stack,
   OperatorType opType = token.op;
   if (opType == OperatorType::BracketClose) {
     return pushBracketClose(output_stack, operator_stack);
-  } else if (opType == OperatorType::BracketOpen) {
+  } else if ((opType == OperatorType::BracketOpen) ||
+             (opType == OperatorType::ArgumentList) ||
+             (opType == OperatorType::LogicalNot)) {
+    // a prefix operator has no operand yet, so nothing before it can be complete
     operator_stack.emplace_back(token);
     return;
   }
@@ -310,34 +325,189 @@ void pushToStack(std::vector<Token> &output_stack,
   }
 }
 
+/**
+ * push the next token read, turning the bracket after a function name into an argument list
+ */
+void pushToken(Token token, bool &expectArgumentList, bool &afterOperand,
+               std::vector<Token> &output_stack, std::vector<Token> &operator_stack) {
+  if (expectArgumentList) {
+    if ((token.type == TokenType::Operator) &&
+        (token.op == OperatorType::BracketOpen)) {
+      token.op = OperatorType::ArgumentList;
+    } else {
+      throw std::runtime_error("expected argument list for function");
+    }
+  }
+  pushToStack(output_stack, operator_stack, token);
+  expectArgumentList = token.type == TokenType::FunctionName;
+  afterOperand = (token.type != TokenType::Operator) || (token.op == OperatorType::BracketClose);
+}
+
+void flushOperators(std::vector<Token> &output_stack, std::vector<Token> &operator_stack) {
+  for (auto iter = operator_stack.rbegin(); iter != operator_stack.rend();
+       ++iter) {
+    output_stack.push_back(*iter);
+  }
+  operator_stack.clear();
+}
+
+/**
+ * true if the number starting at pos is followed by a character that can't be part of it.
+ * Conservative, the extent of hexadecimal numbers is overestimated
+ */
+bool isNumberComplete(std::string_view::const_iterator pos, std::string_view::const_iterator end) {
+  for (auto prev = pos; pos != end; prev = pos++) {
+    bool sign = ((*pos == '+') || (*pos == '-')) && ((*prev == 'e') || (*prev == 'E'));
+    if (!isIdentifierCharacter(*pos) && !sign) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * true if the token starting at pos can be read without looking past end, including the
+ * character nextToken looks at after it
+ */
+bool isTokenComplete(std::string_view::const_iterator pos, std::string_view::const_iterator end,
+                     bool afterOperand) {
+  switch (classify(*pos)) {
+  case CharClass::Digit:
+    return isNumberComplete(pos, end);
+  case CharClass::Operator:
+    // two character operators and the sign of a number
+    if ((pos + 1) == end) {
+      return false;
+    }
+    if ((*pos == '-') && !afterOperand && isNumDigit(*(pos + 1))) {
+      return isNumberComplete(pos + 1, end);
+    }
+    return true;
+  case CharClass::Identifier:
+    // whether it's a function depends on the next character after spaces
+    while ((pos != end) && isIdentifierCharacter(*pos)) {
+      ++pos;
+    }
+    while ((pos != end) && (*pos == ' ')) {
+      ++pos;
+    }
+    return pos != end;
+  case CharClass::Quote:
+    return std::find(pos + 1, end, '"') != end;
+  default:
+    return true;
+  }
+}
+
 std::vector<SYP::Token> tokenize(std::string_view input) {
-  std::vector<Token> output_stack;
-  std::vector<Token> operator_stack;
+  return tokenize(input, SymbolTable::defaultTable());
+}
+
+void tokenize(std::string_view input, SymbolTable &symbols, std::vector<Token> &output_stack,
+              std::vector<Token> &operator_stack) {
+  // a token takes at least one character, usually more
+  output_stack.reserve(input.size() / 2 + 1);
+  operator_stack.clear();
 
   std::string_view::const_iterator iter = input.cbegin();
 
   bool expectArgumentList = false;
+  bool afterOperand = false;
 
-  while (iter != input.cend()) {
-    Token token = nextToken(iter, input.cend());
-    if (expectArgumentList) {
-      if ((token.type == TokenType::Operator) &&
-          (token.op == OperatorType::BracketOpen)) {
-        token.op = OperatorType::ArgumentList;
-      } else {
-        throw std::runtime_error("expected argument list for function");
-      }
+  while (true) {
+    while ((iter != input.cend()) && (classify(*iter) == CharClass::Space)) {
+      ++iter;
+    }
+    if (iter == input.cend()) {
+      break;
     }
-    pushToStack(output_stack, operator_stack, token);
-    expectArgumentList = token.type == TokenType::FunctionName;
-  }
 
-  for (auto iter = operator_stack.rbegin(); iter != operator_stack.rend();
-       ++iter) {
-    output_stack.push_back(*iter);
+    pushToken(nextToken(iter, input.cend(), afterOperand, symbols), expectArgumentList, afterOperand,
+              output_stack, operator_stack);
   }
 
+  flushOperators(output_stack, operator_stack);
+}
+
+std::vector<SYP::Token> tokenize(std::string_view input, SymbolTable &symbols) {
+  std::vector<Token> output_stack;
+  tokenize(input, symbols, output_stack, Workspace::local().operators());
+  return output_stack;
+}
+
+const TokenQueue &tokenize(std::string_view input, SymbolTable &symbols, Workspace &workspace) {
+  auto &output_stack = workspace.output();
+  output_stack.clear();
+  tokenize(input, symbols, output_stack, workspace.operators());
   return output_stack;
 }
 
+void StreamTokenizer::feed(std::string_view chunk, const StatementCallback &onStatement) {
+  while (!chunk.empty()) {
+    if (m_Pending.empty()) {
+      auto consumed = consume(chunk, false, onStatement);
+      m_Pending.assign(chunk.substr(consumed));
+      return;
+    }
+    // complete the cut off token with as little of the chunk as possible, growing the piece
+    // geometrically so long tokens don't get scanned over and over
+    auto piece = std::min(chunk.size(), std::max<size_t>(m_Pending.size(), 64));
+    m_Pending.append(chunk.substr(0, piece));
+    chunk.remove_prefix(piece);
+    m_Pending.erase(0, consume(m_Pending, false, onStatement));
+  }
+}
+
+void StreamTokenizer::finish(const StatementCallback &onStatement) {
+  consume(m_Pending, true, onStatement);
+  m_Pending.clear();
+  endStatement(onStatement);
+}
+
+void StreamTokenizer::reset() {
+  m_Output.clear();
+  m_Operators.clear();
+  m_Pending.clear();
+  m_ExpectArgumentList = false;
+  m_AfterOperand = false;
+  m_StatementCount = 0;
+}
+
+size_t StreamTokenizer::consume(std::string_view text, bool final, const StatementCallback &onStatement) {
+  auto iter = text.cbegin();
+  while (true) {
+    while ((iter != text.cend()) && (classify(*iter) == CharClass::Space)) {
+      ++iter;
+    }
+    if (iter == text.cend()) {
+      break;
+    }
+    if (*iter == ';') {
+      ++iter;
+      endStatement(onStatement);
+      continue;
+    }
+    if (!final && !isTokenComplete(iter, text.cend(), m_AfterOperand)) {
+      break;
+    }
+    pushToken(nextToken(iter, text.cend(), m_AfterOperand, *m_Symbols), m_ExpectArgumentList, m_AfterOperand,
+              m_Output, m_Operators);
+  }
+  return static_cast<size_t>(iter - text.cbegin());
+}
+
+void StreamTokenizer::endStatement(const StatementCallback &onStatement) {
+  if (m_ExpectArgumentList) {
+    throw std::runtime_error("expected argument list for function");
+  }
+  flushOperators(m_Output, m_Operators);
+  // empty statements are skipped
+  if (!m_Output.empty()) {
+    ++m_StatementCount;
+    onStatement(m_Output);
+  }
+  m_Output.clear();
+  m_AfterOperand = false;
+}
+
 }
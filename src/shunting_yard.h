@@ -1,5 +1,7 @@
 #pragma once
 
+#include <functional>
+#include <string>
 #include <vector>
 #include <string_view>
 #include "token.h"
@@ -8,6 +10,74 @@ namespace SYP {
 
 [[nodiscard]] std::vector<Token> tokenize(std::string_view input);
 
+/**
+ * tokenize using the specified symbol table for interning identifiers and string literals.
+ * The resulting tokens reference the table so it has to be kept alive as long as they are in use
+ */
+[[nodiscard]] std::vector<Token> tokenize(std::string_view input, SymbolTable &symbols);
+
+/**
+ * tokenize into the output queue of the workspace, the result is only valid until the workspace
+ * gets used to tokenize again or reset
+ */
+[[nodiscard]] const TokenQueue &tokenize(std::string_view input, SymbolTable &symbols, Workspace &workspace);
+
+/**
+ * tokenizer fed with a script in chunks of any size, e.g. as they arrive from a socket. Statements
+ * in the script are separated by ';', the token queue of each statement is passed on as soon as
+ * its end has been read.
+ * Between chunks only the queue and operator stack of the current statement and the characters of
+ * a token cut off by the end of the chunk are kept, never the script itself.
+ * After an exception the state is undefined until reset is called
+ */
+class StreamTokenizer {
+public:
+  using StatementCallback = std::function<void(const TokenQueue &tokens)>;
+
+public:
+  explicit StreamTokenizer(SymbolTable &symbols = SymbolTable::defaultTable()) : m_Symbols(&symbols) {}
+
+  /**
+   * tokenize the next chunk, calls onStatement for every statement ending in it. The queue passed
+   * is only valid during the call
+   */
+  void feed(std::string_view chunk, const StatementCallback &onStatement);
+
+  /**
+   * end of the script, passes on the last statement if it isn't terminated by ';'. The tokenizer
+   * can be fed the next script afterwards
+   */
+  void finish(const StatementCallback &onStatement);
+
+  /**
+   * drop the partially read statement and start counting statements from zero
+   */
+  void reset();
+
+  /**
+   * number of statements passed on since construction or the last reset
+   */
+  [[nodiscard]] size_t statementCount() const { return m_StatementCount; }
+
+private:
+  /**
+   * tokenize as much of the text as possible, returns the number of characters consumed. Unless
+   * final a token reaching the end of the text is left for the next call
+   */
+  size_t consume(std::string_view text, bool final, const StatementCallback &onStatement);
+
+  void endStatement(const StatementCallback &onStatement);
+
+private:
+  SymbolTable *m_Symbols;
+  std::vector<Token> m_Output;
+  std::vector<Token> m_Operators;
+  std::string m_Pending;
+  bool m_ExpectArgumentList{false};
+  bool m_AfterOperand{false};
+  size_t m_StatementCount{0};
+};
+
 // const Token& numericalFromString(std::string_view& view, double& value, bool isNegative);
 
 }
@@ -0,0 +1,629 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+
+#include "token.h"
+
+namespace SYP {
+
+/**
+ * string literal usable as template argument
+ */
+template <size_t N>
+struct FixedString {
+  char value[N]{};
+
+  constexpr FixedString(const char (&text)[N]) {
+    for (size_t i = 0; i < N; ++i) {
+      value[i] = text[i];
+    }
+  }
+
+  [[nodiscard]] constexpr std::string_view view() const { return std::string_view(value, N - 1); }
+};
+
+namespace detail {
+
+enum class StaticKind : uint8_t {
+  Constant,
+  Variable,
+  Not,
+  Binary,
+  Conditional,
+};
+
+struct StaticNode {
+  StaticKind kind{StaticKind::Constant};
+  OperatorType op{OperatorType::Invalid};
+  // Signed, Unsigned or Float for constants
+  TokenType type{TokenType::Undefined};
+  int64_t signedValue{0};
+  uint64_t unsignedValue{0};
+  double floatValue{0.0};
+  // variable, in order of first appearance
+  uint32_t index{0};
+  std::array<uint32_t, 3> operands{};
+};
+
+struct StaticName {
+  size_t offset{0};
+  size_t length{0};
+};
+
+/**
+ * an expression parsed during compilation, every token produces at most one node so the capacity
+ * is the length of the text
+ */
+template <size_t N>
+struct StaticTree {
+  std::array<StaticNode, N> nodes{};
+  size_t nodeCount{0};
+  std::array<StaticName, N> variables{};
+  size_t variableCount{0};
+  uint32_t root{0};
+};
+
+constexpr bool isStaticSpace(char ch) {
+  return (ch == ' ') || (ch == '\t') || (ch == '\r') || (ch == '\n') || (ch == ',');
+}
+
+constexpr bool isStaticDigit(char ch) { return (ch >= '0') && (ch <= '9'); }
+
+constexpr bool isStaticIdentifierStart(char ch) {
+  return ((ch >= 'a') && (ch <= 'z')) || ((ch >= 'A') && (ch <= 'Z')) || (ch == '_') || (ch == '.');
+}
+
+constexpr bool isStaticIdentifier(char ch) { return isStaticIdentifierStart(ch) || isStaticDigit(ch); }
+
+/**
+ * the tokenizer and tree builder run during compilation with the rules of tokenize and
+ * buildTree. Only numbers, variables and operators are supported, strings, function calls and
+ * assignments are rejected, which fails compilation
+ */
+template <size_t N>
+class StaticParser {
+public:
+  constexpr explicit StaticParser(std::string_view text) : m_Text(text) {}
+
+  constexpr StaticTree<N> parse() {
+    bool afterOperand = false;
+    size_t pos = 0;
+    while (true) {
+      while ((pos < m_Text.size()) && isStaticSpace(m_Text[pos])) {
+        ++pos;
+      }
+      if (pos == m_Text.size()) {
+        break;
+      }
+
+      char ch = m_Text[pos];
+      if (isStaticDigit(ch) ||
+          ((ch == '-') && !afterOperand && (pos + 1 < m_Text.size()) && isStaticDigit(m_Text[pos + 1]))) {
+        output(readNumber(pos));
+        afterOperand = true;
+      } else if (isStaticIdentifierStart(ch)) {
+        auto begin = pos;
+        while ((pos < m_Text.size()) && isStaticIdentifier(m_Text[pos])) {
+          ++pos;
+        }
+        auto name = m_Text.substr(begin, pos - begin);
+        if ((name == "and") || (name == "or")) {
+          pushOperator(name == "and" ? OperatorType::LogicalAnd : OperatorType::LogicalOr);
+          afterOperand = false;
+          continue;
+        }
+        auto peek = pos;
+        while ((peek < m_Text.size()) && (m_Text[peek] == ' ')) {
+          ++peek;
+        }
+        if ((peek < m_Text.size()) && (m_Text[peek] == '(')) {
+          throw std::runtime_error("function calls are not supported in static expressions");
+        }
+        output(variable(begin, pos - begin));
+        afterOperand = true;
+      } else if (ch == '"') {
+        throw std::runtime_error("strings are not supported in static expressions");
+      } else if (ch == '(') {
+        ++pos;
+        m_Operators[m_OperatorCount++] = OperatorType::BracketOpen;
+        afterOperand = false;
+      } else if (ch == ')') {
+        ++pos;
+        closeBracket();
+        afterOperand = true;
+      } else {
+        auto op = readOperator(pos);
+        if (op == OperatorType::Assign) {
+          throw std::runtime_error("assignment not supported in static expressions");
+        }
+        pushOperator(op);
+        afterOperand = false;
+      }
+    }
+
+    while (m_OperatorCount > 0) {
+      auto op = m_Operators[--m_OperatorCount];
+      if (op == OperatorType::BracketOpen) {
+        throw std::runtime_error("unmatched bracket");
+      }
+      output(op);
+    }
+
+    if (m_StackSize != 1) {
+      throw std::runtime_error("failed to compile term");
+    }
+    if (m_OpenTernaries != 0) {
+      throw std::runtime_error("'?' without matching ':'");
+    }
+    m_Tree.root = m_Stack[0];
+    return m_Tree;
+  }
+
+private:
+  constexpr StaticNode readNumber(size_t &pos) {
+    bool isNegative = m_Text[pos] == '-';
+    if (isNegative) {
+      ++pos;
+    }
+
+    StaticNode node;
+    if ((m_Text[pos] == '0') && (pos + 1 < m_Text.size()) &&
+        ((m_Text[pos + 1] == 'x') || (m_Text[pos + 1] == 'X') || (m_Text[pos + 1] == 'b') ||
+         (m_Text[pos + 1] == 'B'))) {
+      if (isNegative) {
+        throw std::runtime_error("invalid number format");
+      }
+      uint64_t base = ((m_Text[pos + 1] == 'x') || (m_Text[pos + 1] == 'X')) ? 16 : 2;
+      pos += 2;
+      auto digits = pos;
+      uint64_t value = 0;
+      for (; pos < m_Text.size(); ++pos) {
+        auto digit = digitValue(m_Text[pos]);
+        if (digit >= base) {
+          break;
+        }
+        if (value > (std::numeric_limits<uint64_t>::max() - digit) / base) {
+          throw std::runtime_error("number out of range");
+        }
+        value = value * base + digit;
+      }
+      if ((pos == digits) || ((pos < m_Text.size()) && isStaticIdentifier(m_Text[pos]))) {
+        throw std::runtime_error("invalid number format");
+      }
+      node.type = TokenType::Unsigned;
+      node.unsignedValue = value;
+      return node;
+    }
+
+    // significant digits and the power of ten they are scaled by
+    uint64_t mantissa = 0;
+    int digitCount = 0;
+    int exponent = 0;
+    bool isFloat = false;
+    bool inexact = false;
+    auto digits = [&](bool fraction) {
+      for (; (pos < m_Text.size()) && isStaticDigit(m_Text[pos]); ++pos) {
+        if ((mantissa == 0) && (m_Text[pos] == '0')) {
+          exponent -= fraction ? 1 : 0;
+          continue;
+        }
+        if (digitCount < 19) {
+          mantissa = mantissa * 10 + static_cast<uint64_t>(m_Text[pos] - '0');
+          ++digitCount;
+          exponent -= fraction ? 1 : 0;
+        } else {
+          inexact = true;
+          exponent += fraction ? 0 : 1;
+        }
+      }
+    };
+
+    auto begin = pos;
+    digits(false);
+    bool integerTooLong = inexact;
+    if ((pos < m_Text.size()) && (m_Text[pos] == '.')) {
+      isFloat = true;
+      ++pos;
+      digits(true);
+    }
+    if ((pos < m_Text.size()) && ((m_Text[pos] == 'e') || (m_Text[pos] == 'E'))) {
+      isFloat = true;
+      ++pos;
+      bool negativeExponent = false;
+      if ((pos < m_Text.size()) && ((m_Text[pos] == '+') || (m_Text[pos] == '-'))) {
+        negativeExponent = m_Text[pos++] == '-';
+      }
+      auto exponentDigits = pos;
+      int value = 0;
+      for (; (pos < m_Text.size()) && isStaticDigit(m_Text[pos]); ++pos) {
+        value = value < 10000 ? value * 10 + (m_Text[pos] - '0') : value;
+      }
+      if (pos == exponentDigits) {
+        throw std::runtime_error("invalid number format");
+      }
+      exponent += negativeExponent ? -value : value;
+    }
+    if ((pos < m_Text.size()) && isStaticIdentifier(m_Text[pos])) {
+      throw std::runtime_error("invalid number format");
+    }
+
+    if (isFloat) {
+      node.type = TokenType::Float;
+      node.floatValue = toDouble(mantissa, exponent, inexact);
+      node.floatValue = isNegative ? -node.floatValue : node.floatValue;
+      return node;
+    }
+
+    uint64_t value = 0;
+    for (auto i = begin; i < pos; ++i) {
+      if (integerTooLong || (value > (std::numeric_limits<uint64_t>::max() - 9) / 10)) {
+        throw std::runtime_error("number out of range");
+      }
+      value = value * 10 + static_cast<uint64_t>(m_Text[i] - '0');
+    }
+    uint64_t limit = static_cast<uint64_t>(std::numeric_limits<int64_t>::max()) + (isNegative ? 1 : 0);
+    if (value > limit) {
+      throw std::runtime_error("number out of range");
+    }
+    node.type = TokenType::Signed;
+    node.signedValue = isNegative ? static_cast<int64_t>(0 - value) : static_cast<int64_t>(value);
+    return node;
+  }
+
+  static constexpr uint64_t digitValue(char ch) {
+    if (isStaticDigit(ch)) {
+      return static_cast<uint64_t>(ch - '0');
+    } else if ((ch >= 'a') && (ch <= 'f')) {
+      return static_cast<uint64_t>(ch - 'a' + 10);
+    } else if ((ch >= 'A') && (ch <= 'F')) {
+      return static_cast<uint64_t>(ch - 'A' + 10);
+    }
+    return 16;
+  }
+
+  /**
+   * exact for up to 15 significant digits with a power of ten up to 22, which are represented
+   * exactly so a single rounding happens. Longer literals may differ from the runtime parser in
+   * the last bit
+   */
+  static constexpr double toDouble(uint64_t mantissa, int exponent, bool inexact) {
+    constexpr double s_Powers[] = { 1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+    auto value = static_cast<double>(mantissa);
+    if (!inexact && (mantissa < (uint64_t(1) << 53)) && (exponent >= -22) && (exponent <= 22)) {
+      return exponent < 0 ? value / s_Powers[-exponent] : value * s_Powers[exponent];
+    }
+    for (; (exponent > 0) && (value != 0.0); --exponent) {
+      value *= 10.0;
+    }
+    for (; (exponent < 0) && (value != 0.0); ++exponent) {
+      value /= 10.0;
+    }
+    return value;
+  }
+
+  constexpr OperatorType readOperator(size_t &pos) {
+    char ch = m_Text[pos++];
+    auto follows = [&](char expected) {
+      if ((pos < m_Text.size()) && (m_Text[pos] == expected)) {
+        ++pos;
+        return true;
+      }
+      return false;
+    };
+
+    switch (ch) {
+    case '+': return OperatorType::Add;
+    case '-': return OperatorType::Subtract;
+    case '*': return OperatorType::Multiply;
+    case '/': return OperatorType::Divide;
+    case '%': return OperatorType::Modulo;
+    case '^': return OperatorType::Xor;
+    case '?': return OperatorType::TernaryQ;
+    case ':': return OperatorType::TernaryE;
+    case '<':
+      return follows('<') ? OperatorType::ShiftLeft : follows('=') ? OperatorType::LessOrEqual : OperatorType::LessThan;
+    case '>':
+      return follows('>')   ? OperatorType::ShiftRight
+             : follows('=') ? OperatorType::GreaterOrEqual
+                            : OperatorType::GreaterThan;
+    case '!': return follows('=') ? OperatorType::NotEqual : OperatorType::LogicalNot;
+    case '=': return follows('=') ? OperatorType::Equal : OperatorType::Assign;
+    case '&': return follows('&') ? OperatorType::LogicalAnd : OperatorType::BitwiseAnd;
+    case '|': return follows('|') ? OperatorType::LogicalOr : OperatorType::BitwiseOr;
+    default: throw std::runtime_error("operator not supported");
+    }
+  }
+
+  constexpr StaticNode variable(size_t offset, size_t length) {
+    StaticNode node;
+    node.kind = StaticKind::Variable;
+    auto name = m_Text.substr(offset, length);
+    for (; node.index < m_Tree.variableCount; ++node.index) {
+      const auto &known = m_Tree.variables[node.index];
+      if (m_Text.substr(known.offset, known.length) == name) {
+        return node;
+      }
+    }
+    m_Tree.variables[m_Tree.variableCount++] = StaticName{ offset, length };
+    return node;
+  }
+
+  constexpr void pushOperator(OperatorType op) {
+    if (op == OperatorType::LogicalNot) {
+      // a prefix operator has no operand yet, so nothing before it can be complete
+      m_Operators[m_OperatorCount++] = op;
+      return;
+    }
+    auto order = getOperatorOrder(op);
+    while ((m_OperatorCount > 0) && (getOperatorOrder(m_Operators[m_OperatorCount - 1]) <= order)) {
+      output(m_Operators[--m_OperatorCount]);
+    }
+    m_Operators[m_OperatorCount++] = op;
+  }
+
+  constexpr void closeBracket() {
+    while ((m_OperatorCount > 0) && (m_Operators[m_OperatorCount - 1] != OperatorType::BracketOpen)) {
+      output(m_Operators[--m_OperatorCount]);
+    }
+    if (m_OperatorCount == 0) {
+      throw std::runtime_error("unmatched bracket");
+    }
+    --m_OperatorCount;
+  }
+
+  constexpr uint32_t add(const StaticNode &node) {
+    m_Tree.nodes[m_Tree.nodeCount] = node;
+    return static_cast<uint32_t>(m_Tree.nodeCount++);
+  }
+
+  constexpr uint32_t pop() {
+    if (m_StackSize == 0) {
+      throw std::runtime_error("failed to compile term");
+    }
+    return m_Stack[--m_StackSize];
+  }
+
+  constexpr void output(const StaticNode &operand) { m_Stack[m_StackSize++] = add(operand); }
+
+  /**
+   * operators are turned into nodes as they leave the operator stack, like buildTree does with
+   * the RPN queue
+   */
+  constexpr void output(OperatorType op) {
+    StaticNode node;
+    node.op = op;
+    if (op == OperatorType::LogicalNot) {
+      node.kind = StaticKind::Not;
+      node.operands[0] = pop();
+    } else if (op == OperatorType::TernaryE) {
+      auto rhs = pop();
+      auto lhs = pop();
+      auto &cond = m_Tree.nodes[lhs];
+      if ((cond.kind != StaticKind::Binary) || (cond.op != OperatorType::TernaryQ)) {
+        throw std::runtime_error("':' without matching '?'");
+      }
+      cond.kind = StaticKind::Conditional;
+      cond.operands[2] = rhs;
+      --m_OpenTernaries;
+      m_Stack[m_StackSize++] = lhs;
+      return;
+    } else {
+      m_OpenTernaries += op == OperatorType::TernaryQ ? 1 : 0;
+      node.kind = StaticKind::Binary;
+      node.operands[1] = pop();
+      node.operands[0] = pop();
+    }
+    m_Stack[m_StackSize++] = add(node);
+  }
+
+private:
+  std::string_view m_Text;
+  StaticTree<N> m_Tree{};
+  std::array<OperatorType, N> m_Operators{};
+  size_t m_OperatorCount{0};
+  std::array<uint32_t, N> m_Stack{};
+  size_t m_StackSize{0};
+  int m_OpenTernaries{0};
+};
+
+template <FixedString Text>
+inline constexpr auto s_StaticTree = StaticParser<sizeof(Text.value)>(Text.view()).parse();
+
+template <typename T>
+inline constexpr bool s_IsStaticInteger = std::is_same_v<T, int64_t> || std::is_same_v<T, uint64_t>;
+
+template <typename T>
+inline constexpr bool s_IsStaticNumeric = s_IsStaticInteger<T> || std::is_same_v<T, double>;
+
+/**
+ * common type of numeric operands, same as the type checker's promotion
+ */
+template <typename L, typename R>
+using StaticPromoted =
+    std::conditional_t<std::is_same_v<L, double> || std::is_same_v<R, double>, double,
+                       std::conditional_t<std::is_same_v<L, int64_t> || std::is_same_v<R, int64_t>, int64_t, uint64_t>>;
+
+/**
+ * arguments are used as the token type they'd be stored as
+ */
+template <typename T>
+constexpr auto staticValue(T value) {
+  if constexpr (std::is_same_v<T, bool>) {
+    return value;
+  } else if constexpr (std::is_floating_point_v<T>) {
+    return static_cast<double>(value);
+  } else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) {
+    return static_cast<int64_t>(value);
+  } else {
+    static_assert(std::is_integral_v<T>, "static expressions only support numbers and booleans");
+    return static_cast<uint64_t>(value);
+  }
+}
+
+template <typename T>
+constexpr bool staticCondition(T value) {
+  static_assert(std::is_same_v<T, bool> || s_IsStaticInteger<T>, "condition has to be boolean or integer");
+  if constexpr (std::is_same_v<T, bool>) {
+    return value;
+  } else {
+    return value != 0;
+  }
+}
+
+template <OperatorType Op, typename L, typename R>
+constexpr auto applyStatic(L lhs, R rhs) {
+  if constexpr ((Op == OperatorType::Add) || (Op == OperatorType::Subtract) || (Op == OperatorType::Multiply) ||
+                (Op == OperatorType::Divide)) {
+    static_assert(s_IsStaticNumeric<L> && s_IsStaticNumeric<R>, "invalid operand types for arithmetic operator");
+    using T = StaticPromoted<L, R>;
+    if constexpr (Op == OperatorType::Add) {
+      return static_cast<T>(lhs) + static_cast<T>(rhs);
+    } else if constexpr (Op == OperatorType::Subtract) {
+      return static_cast<T>(lhs) - static_cast<T>(rhs);
+    } else if constexpr (Op == OperatorType::Multiply) {
+      return static_cast<T>(lhs) * static_cast<T>(rhs);
+    } else {
+      return static_cast<T>(lhs) / static_cast<T>(rhs);
+    }
+  } else if constexpr ((Op == OperatorType::Modulo) || (Op == OperatorType::ShiftLeft) ||
+                       (Op == OperatorType::ShiftRight) || (Op == OperatorType::Xor) ||
+                       (Op == OperatorType::BitwiseAnd) || (Op == OperatorType::BitwiseOr)) {
+    // integer operators work on the unsigned representation
+    static_assert(s_IsStaticInteger<L> && s_IsStaticInteger<R>, "invalid operand types for integer operator");
+    auto l = static_cast<uint64_t>(lhs);
+    auto r = static_cast<uint64_t>(rhs);
+    if constexpr (Op == OperatorType::Modulo) {
+      return l % r;
+    } else if constexpr (Op == OperatorType::ShiftLeft) {
+      return l << r;
+    } else if constexpr (Op == OperatorType::ShiftRight) {
+      return l >> r;
+    } else if constexpr (Op == OperatorType::Xor) {
+      return l ^ r;
+    } else if constexpr (Op == OperatorType::BitwiseAnd) {
+      return l & r;
+    } else {
+      return l | r;
+    }
+  } else if constexpr (((Op == OperatorType::Equal) || (Op == OperatorType::NotEqual)) && std::is_same_v<L, bool> &&
+                       std::is_same_v<R, bool>) {
+    return Op == OperatorType::Equal ? lhs == rhs : lhs != rhs;
+  } else {
+    static_assert((Op == OperatorType::LessThan) || (Op == OperatorType::LessOrEqual) ||
+                      (Op == OperatorType::GreaterThan) || (Op == OperatorType::GreaterOrEqual) ||
+                      (Op == OperatorType::Equal) || (Op == OperatorType::NotEqual),
+                  "operator not supported in static expressions");
+    static_assert(s_IsStaticNumeric<L> && s_IsStaticNumeric<R>, "invalid operand types for comparison");
+    using T = StaticPromoted<L, R>;
+    auto l = static_cast<T>(lhs);
+    auto r = static_cast<T>(rhs);
+    if constexpr (Op == OperatorType::LessThan) {
+      return l < r;
+    } else if constexpr (Op == OperatorType::LessOrEqual) {
+      return l <= r;
+    } else if constexpr (Op == OperatorType::GreaterThan) {
+      return l > r;
+    } else if constexpr (Op == OperatorType::GreaterOrEqual) {
+      return l >= r;
+    } else if constexpr (Op == OperatorType::Equal) {
+      return l == r;
+    } else {
+      return l != r;
+    }
+  }
+}
+
+/**
+ * every node is its own instantiation with the types known statically, so after inlining this is
+ * the code of the equivalent C++ expression
+ */
+template <FixedString Text, uint32_t Index, typename Values>
+constexpr auto evaluateStatic(const Values &values) {
+  constexpr const StaticNode &node = s_StaticTree<Text>.nodes[Index];
+  if constexpr (node.kind == StaticKind::Constant) {
+    if constexpr (node.type == TokenType::Signed) {
+      return node.signedValue;
+    } else if constexpr (node.type == TokenType::Unsigned) {
+      return node.unsignedValue;
+    } else {
+      return node.floatValue;
+    }
+  } else if constexpr (node.kind == StaticKind::Variable) {
+    return std::get<node.index>(values);
+  } else if constexpr (node.kind == StaticKind::Not) {
+    return !staticCondition(evaluateStatic<Text, node.operands[0]>(values));
+  } else if constexpr (node.kind == StaticKind::Conditional) {
+    using L = decltype(evaluateStatic<Text, node.operands[1]>(values));
+    using R = decltype(evaluateStatic<Text, node.operands[2]>(values));
+    static_assert(std::is_same_v<L, R> || (s_IsStaticNumeric<L> && s_IsStaticNumeric<R>),
+                  "branches of conditional have incompatible types");
+    using T = std::conditional_t<std::is_same_v<L, R>, L, StaticPromoted<L, R>>;
+    // only the selected branch is evaluated
+    return staticCondition(evaluateStatic<Text, node.operands[0]>(values))
+               ? static_cast<T>(evaluateStatic<Text, node.operands[1]>(values))
+               : static_cast<T>(evaluateStatic<Text, node.operands[2]>(values));
+  } else if constexpr (node.op == OperatorType::LogicalAnd) {
+    return staticCondition(evaluateStatic<Text, node.operands[0]>(values)) &&
+           staticCondition(evaluateStatic<Text, node.operands[1]>(values));
+  } else if constexpr (node.op == OperatorType::LogicalOr) {
+    return staticCondition(evaluateStatic<Text, node.operands[0]>(values)) ||
+           staticCondition(evaluateStatic<Text, node.operands[1]>(values));
+  } else {
+    static_assert(node.op != OperatorType::TernaryQ, "'?' without matching ':'");
+    return applyStatic<node.op>(evaluateStatic<Text, node.operands[0]>(values),
+                                evaluateStatic<Text, node.operands[1]>(values));
+  }
+}
+
+}
+
+/**
+ * expression parsed during compilation. The operators, precedence and type rules are those of
+ * compiled expressions with declared types, with the argument types as variable types.
+ * Expressions without variables can be evaluated in constant expressions
+ */
+template <FixedString Text>
+struct StaticExpression {
+  static constexpr size_t s_VariableCount = detail::s_StaticTree<Text>.variableCount;
+
+  /**
+   * names of the variables in order of their first appearance, which is the order in which the
+   * call operator takes their values
+   */
+  [[nodiscard]] static constexpr std::array<std::string_view, s_VariableCount> variables() {
+    std::array<std::string_view, s_VariableCount> result{};
+    for (size_t i = 0; i < s_VariableCount; ++i) {
+      const auto &name = detail::s_StaticTree<Text>.variables[i];
+      result[i] = Text.view().substr(name.offset, name.length);
+    }
+    return result;
+  }
+
+  template <typename... Args>
+  [[nodiscard]] constexpr auto operator()(Args... values) const {
+    static_assert(sizeof...(Args) == s_VariableCount, "expected one argument per variable");
+    return detail::evaluateStatic<Text, detail::s_StaticTree<Text>.root>(
+        std::make_tuple(detail::staticValue(values)...));
+  }
+};
+
+namespace literals {
+
+template <FixedString Text>
+constexpr StaticExpression<Text> operator""_expr() {
+  return {};
+}
+
+}
+
+}
+
+#define PAGAN_EXPR(text) (::SYP::StaticExpression<::SYP::FixedString(text)>{})
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <deque>
+#include <string>
+
+namespace SYP {
+
+/**
+ * storage for strings produced while evaluating an expression (e.g. by concatenation).
+ * Tokens reference the strings by pointer so they are only valid until the arena gets reset.
+ * Reset doesn't free the buffers, following evaluations reuse them
+ */
+class StringArena {
+public:
+  /**
+   * get an empty string that stays valid until the next reset
+   */
+  [[nodiscard]] std::string &allocate() {
+    if (m_Used == m_Strings.size()) {
+      m_Strings.emplace_back();
+    } else {
+      m_Strings[m_Used].clear();
+    }
+    return m_Strings[m_Used++];
+  }
+
+  void reset() { m_Used = 0; }
+
+  /**
+   * release all but the first count buffers, only valid directly after a reset
+   */
+  void shrink(size_t count) {
+    if (m_Strings.size() > count) {
+      m_Strings.resize(count);
+      m_Strings.shrink_to_fit();
+    }
+  }
+
+  [[nodiscard]] size_t size() const { return m_Used; }
+
+  /**
+   * number of string buffers kept for reuse
+   */
+  [[nodiscard]] size_t capacity() const { return m_Strings.size(); }
+
+private:
+  std::deque<std::string> m_Strings;
+  size_t m_Used{0};
+};
+
+}
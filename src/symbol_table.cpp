@@ -0,0 +1,109 @@
+#include "symbol_table.h"
+
+#include "token.h"
+
+#include <format>
+#include <mutex>
+#include <stdexcept>
+
+namespace SYP {
+
+SymbolTable &SymbolTable::defaultTable() {
+  static SymbolTable s_Default;
+  return s_Default;
+}
+
+const std::string *SymbolTable::internVariable(std::string_view name) {
+  if (auto existing = findVariable(name); existing != nullptr) {
+    return existing;
+  }
+
+  std::unique_lock lock(m_Mutex);
+  // may have been added between releasing the shared and acquiring the exclusive lock
+  if (auto iter = m_VariableIndex.find(name); iter != m_VariableIndex.end()) {
+    return iter->second;
+  }
+  const auto &entry = m_Variables.emplace_back(name);
+  m_VariableIndex.emplace(entry, &entry);
+  return &entry;
+}
+
+const FunctionEntry *SymbolTable::internFunction(std::string_view name) {
+  if (auto existing = findFunction(name); existing != nullptr) {
+    return existing;
+  }
+
+  std::unique_lock lock(m_Mutex);
+  if (auto iter = m_FunctionIndex.find(name); iter != m_FunctionIndex.end()) {
+    return iter->second;
+  }
+  auto &entry = m_Functions.emplace_back(FunctionEntry{ std::string(name), nullptr });
+  m_FunctionIndex.emplace(entry.name, &entry);
+  return &entry;
+}
+
+Token FunctionEntry::call(FunctionArgs args) const {
+  if (native != nullptr) {
+    return native(args);
+  }
+  if (function == nullptr) {
+    throw std::runtime_error(std::format("function {} not registered", name));
+  }
+  return function(args);
+}
+
+SpanFunction SymbolTable::wrapVectorFunction(DynamicFunction function) {
+  return [function = std::move(function)](FunctionArgs args) {
+    return function(std::vector<Token>(args.begin(), args.end()));
+  };
+}
+
+const FunctionEntry *SymbolTable::registerEntry(std::string_view name, SpanFunction function, NativeFunction native,
+                                                bool pure, const FunctionSignature *signature) {
+  {
+    // resolve callbacks tend to construct function tokens on every evaluation, once the
+    // function is defined that must not serialize the evaluating threads
+    std::shared_lock lock(m_Mutex);
+    if (auto iter = m_FunctionIndex.find(name); (iter != m_FunctionIndex.end()) && iter->second->defined()) {
+      return iter->second;
+    }
+  }
+
+  std::unique_lock lock(m_Mutex);
+  if (auto iter = m_FunctionIndex.find(name); iter != m_FunctionIndex.end()) {
+    if (!iter->second->defined()) {
+      iter->second->function = std::move(function);
+      iter->second->native = native;
+      iter->second->pure = pure;
+      iter->second->signature = signature;
+    }
+    return iter->second;
+  }
+  auto &entry = m_Functions.emplace_back(FunctionEntry{ std::string(name), std::move(function), native, signature, pure });
+  m_FunctionIndex.emplace(entry.name, &entry);
+  return &entry;
+}
+
+const std::string *SymbolTable::findVariable(std::string_view name) const {
+  std::shared_lock lock(m_Mutex);
+  auto iter = m_VariableIndex.find(name);
+  return iter != m_VariableIndex.end() ? iter->second : nullptr;
+}
+
+const FunctionEntry *SymbolTable::findFunction(std::string_view name) const {
+  std::shared_lock lock(m_Mutex);
+  auto iter = m_FunctionIndex.find(name);
+  return iter != m_FunctionIndex.end() ? iter->second : nullptr;
+}
+
+size_t SymbolTable::variableCount() const {
+  std::shared_lock lock(m_Mutex);
+  return m_Variables.size();
+}
+
+size_t SymbolTable::functionCount() const {
+  std::shared_lock lock(m_Mutex);
+  return m_Functions.size();
+}
+
+}
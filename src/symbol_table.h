@@ -0,0 +1,157 @@
+#pragma once
+
+#include <deque>
+#include <functional>
+#include <shared_mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace SYP {
+
+struct Token;
+struct FunctionSignature;
+
+/**
+ * arguments of a function call, a view of the evaluation stack that's only valid during the call.
+ * The function must not evaluate other expressions with the workspace of its caller, see Workspace
+ */
+using FunctionArgs = std::span<const Token>;
+
+using SpanFunction = std::function<Token(FunctionArgs)>;
+using NativeFunction = Token (*)(FunctionArgs);
+// functions taking their arguments as a vector get a copy of the arguments on every call
+using DynamicFunction = std::function<Token(const std::vector<Token>&)>;
+
+template <typename F>
+concept FunctionCallable = std::is_invocable_r_v<Token, F, FunctionArgs> ||
+                           std::is_invocable_r_v<Token, F, const std::vector<Token> &>;
+
+/**
+ * parameter types of functions with a native signature: numbers, bool and string views
+ */
+template <typename T>
+concept NativeArgument = (std::is_arithmetic_v<std::remove_cvref_t<T>> && !std::is_same_v<std::remove_cvref_t<T>, char>) ||
+                         std::is_same_v<std::remove_cvref_t<T>, std::string_view>;
+
+template <typename R, typename... Args>
+concept NativeSignature = (std::is_arithmetic_v<R> || std::is_same_v<R, Token>) && !std::is_same_v<R, char> &&
+                          (NativeArgument<Args> && ...);
+
+template <typename F>
+struct IsNativeFunction : std::false_type {};
+
+template <typename R, typename... Args>
+struct IsNativeFunction<R (*)(Args...)> : std::bool_constant<NativeSignature<R, Args...>> {};
+
+struct FunctionEntry {
+  std::string name;
+  SpanFunction function;
+  // called directly if set, avoids the type erased call through function
+  NativeFunction native{nullptr};
+  // parameter and result types for functions registered with a native signature, nullptr if
+  // they are only known at runtime
+  const FunctionSignature *signature{nullptr};
+  // result depends only on the arguments and calling has no side effects, so calls with
+  // constant arguments can be evaluated when an expression is compiled
+  bool pure{false};
+
+  [[nodiscard]] bool defined() const { return (native != nullptr) || (function != nullptr); }
+
+  /**
+   * call the implementation, throws if the function was never registered
+   */
+  [[nodiscard]] Token call(FunctionArgs args) const;
+};
+
+/**
+ * interned names of variables, string literals and functions. Tokens reference entries in the
+ * table directly so the table has to outlive all token queues produced with it.
+ * Lookups can happen concurrently from any number of threads, interning new names takes an
+ * exclusive lock. Registering a function that is already defined only takes the shared lock.
+ * Entries are read without locking while evaluating, so a function must be registered before
+ * expressions calling it get evaluated concurrently
+ */
+class SymbolTable {
+public:
+  SymbolTable() = default;
+  SymbolTable(const SymbolTable &) = delete;
+  SymbolTable &operator=(const SymbolTable &) = delete;
+
+  /**
+   * table used by the overloads that don't take an explicit one
+   */
+  static SymbolTable &defaultTable();
+
+  [[nodiscard]] const std::string *internVariable(std::string_view name);
+  [[nodiscard]] const FunctionEntry *internFunction(std::string_view name);
+
+  /**
+   * intern a function and set its implementation unless one was set before. Functions should
+   * be registered before expressions using them get compiled or evaluated.
+   * Callables without state that accept the arguments as a span are stored as plain function
+   * pointers, callables taking a vector are supported but pay for a copy of the arguments
+   */
+  template <FunctionCallable F>
+  const FunctionEntry *registerFunction(std::string_view name, F &&function, bool pure = false) {
+    if constexpr (std::is_convertible_v<F, NativeFunction>) {
+      return registerEntry(name, nullptr, static_cast<NativeFunction>(function), pure);
+    } else if constexpr (std::is_invocable_r_v<Token, F, FunctionArgs>) {
+      return registerEntry(name, SpanFunction(std::forward<F>(function)), nullptr, pure);
+    } else {
+      return registerEntry(name, wrapVectorFunction(DynamicFunction(std::forward<F>(function))), nullptr, pure);
+    }
+  }
+
+  /**
+   * register a callable known at compile time, the call gets inlined into the function that is
+   * invoked with the arguments
+   */
+  template <auto function>
+    requires std::is_same_v<std::invoke_result_t<decltype(function), FunctionArgs>, Token>
+  const FunctionEntry *registerFunction(std::string_view name, bool pure = false) {
+    return registerEntry(name, nullptr, [](FunctionArgs args) { return std::invoke(function, args); }, pure);
+  }
+
+  /**
+   * register a function with a native signature, e.g. int64_t(int64_t, int64_t). Unpacking the
+   * arguments and packing the result is generated at compile time and calls get checked for
+   * arity and argument types when an expression is type checked.
+   * Defined in native_function.h
+   */
+  template <typename R, typename... Args>
+    requires NativeSignature<R, Args...>
+  const FunctionEntry *registerFunction(std::string_view name, R (*function)(Args...), bool pure = false);
+
+  /**
+   * register a function with a native signature known at compile time, the call gets inlined
+   * into the generated wrapper
+   */
+  template <auto function>
+    requires IsNativeFunction<decltype(function)>::value
+  const FunctionEntry *registerFunction(std::string_view name, bool pure = false);
+
+  [[nodiscard]] const std::string *findVariable(std::string_view name) const;
+  [[nodiscard]] const FunctionEntry *findFunction(std::string_view name) const;
+
+  [[nodiscard]] size_t variableCount() const;
+  [[nodiscard]] size_t functionCount() const;
+
+private:
+  const FunctionEntry *registerEntry(std::string_view name, SpanFunction function, NativeFunction native, bool pure,
+                                     const FunctionSignature *signature = nullptr);
+  static SpanFunction wrapVectorFunction(DynamicFunction function);
+
+private:
+  mutable std::shared_mutex m_Mutex;
+  // deques keep entries in place when growing, the maps key on views into those entries
+  std::deque<std::string> m_Variables;
+  std::deque<FunctionEntry> m_Functions;
+  std::unordered_map<std::string_view, const std::string *> m_VariableIndex;
+  std::unordered_map<std::string_view, FunctionEntry *> m_FunctionIndex;
+};
+
+}
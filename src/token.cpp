@@ -1,67 +1,46 @@
 #include "token.h"
 
 #include "evaluate.h"
+#include "workspace.h"
 
 #include <cstdint>
 #include <format>
-#include <iostream>
 #include <stdexcept>
 #include <functional>
-#include <array>
 
 using namespace std::string_literals;
 
 namespace SYP {
 
-int getOperatorOrder(const OperatorType &op) {
+const char *getOperatorName(const OperatorType &op) {
   switch (op) {
-  case OperatorType::LogicalNot:
-    return 2;
-  case OperatorType::Multiply:
-  case OperatorType::Divide:
-  case OperatorType::Modulo:
-    return 3;
-  case OperatorType::Add:
-  case OperatorType::Subtract:
-    return 4;
-  case OperatorType::ShiftLeft:
-  case OperatorType::ShiftRight:
-    return 5;
-  case OperatorType::LessThan:
-  case OperatorType::LessOrEqual:
-  case OperatorType::GreaterThan:
-  case OperatorType::GreaterOrEqual:
-    return 6;
-  case OperatorType::Equal:
-  case OperatorType::NotEqual:
-    return 7;
-  case OperatorType::BitwiseAnd:
-    return 8;
-  case OperatorType::Xor:
-    return 9;
-  case OperatorType::BitwiseOr:
-    return 10;
-  case OperatorType::LogicalAnd:
-    return 11;
-  case OperatorType::LogicalOr:
-    return 12;
-  case OperatorType::TernaryQ:
-    return 13;
-  case OperatorType::TernaryE:
-    return 14;
-  case OperatorType::Assign:
-    return 30;
-  case OperatorType::BracketOpen:
-  case OperatorType::BracketClose:
-  case OperatorType::ArgumentList:
-    // brackets are handled separately so this priority should be so high
-    // it never gets removed from operator stack prematurely
-    return 20;
-  default:
-    throw std::out_of_range(
-        std::format("Invalid operator type {}", static_cast<unsigned>(op)));
+  case OperatorType::Assign: return "=";
+  case OperatorType::Add: return "+";
+  case OperatorType::Subtract: return "-";
+  case OperatorType::Multiply: return "*";
+  case OperatorType::Divide: return "/";
+  case OperatorType::Modulo: return "%";
+  case OperatorType::ShiftLeft: return "<<";
+  case OperatorType::ShiftRight: return ">>";
+  case OperatorType::Xor: return "^";
+  case OperatorType::BitwiseAnd: return "&";
+  case OperatorType::BitwiseOr: return "|";
+  case OperatorType::LessThan: return "<";
+  case OperatorType::LessOrEqual: return "<=";
+  case OperatorType::GreaterThan: return ">";
+  case OperatorType::GreaterOrEqual: return ">=";
+  case OperatorType::Equal: return "==";
+  case OperatorType::NotEqual: return "!=";
+  case OperatorType::LogicalAnd: return "&&";
+  case OperatorType::LogicalOr: return "||";
+  case OperatorType::LogicalNot: return "!";
+  case OperatorType::TernaryQ: return "?";
+  case OperatorType::TernaryE: return ":";
+  case OperatorType::BracketOpen: return "(";
+  case OperatorType::BracketClose: return ")";
+  case OperatorType::ArgumentList: return "()";
+  default: return "<invalid>";
   }
-
 }
 
 template<typename T>
@@ -145,8 +124,6 @@ Token resolveTokenImpl(const Token& token, const std::function<Token(const std::
 #define BINARY_STR_OP(op)                                                      \
   auto rhs = resolveToken(args.first[--args.second]);                          \
   auto lhs = resolveToken(args.first[--args.second]);                          \
-  std::cout << "add " << toString(lhs) << " and " << toString(rhs)             \
-            << std::endl;                                                      \
   switch (lhs.type) {                                                          \
   case TokenType::Unsigned:                                                    \
     return tokenTo<uint64_t>(lhs, resolve) op tokenTo<uint64_t>(rhs, resolve); \
@@ -154,10 +131,12 @@ Token resolveTokenImpl(const Token& token, const std::function<Token(const std::
     return tokenTo<int64_t>(lhs, resolve) op tokenTo<int64_t>(rhs, resolve);   \
   case TokenType::Float:                                                       \
     return tokenTo<double>(lhs, resolve) op tokenTo<double>(rhs, resolve);     \
-  case TokenType::String:                                                      \
-    return Token(tokenTo<std::string>(lhs, resolve)                            \
-                     op tokenTo<std::string>(rhs, resolve),                    \
-                 TokenType::String);                                           \
+  case TokenType::String: {                                                    \
+    /* runtime strings live in the evaluation's arena, not the symbol table */ \
+    auto &result = strings.allocate();                                         \
+    result.append(lhs.getVariableName()).append(rhs.getVariableName());        \
+    return Token(&result);                                                     \
+  }                                                                            \
   default:                                                                     \
     throw std::runtime_error("invalid token type for binary op");              \
   }
@@ -175,6 +154,34 @@ Token resolveTokenImpl(const Token& token, const std::function<Token(const std::
     throw std::runtime_error("invalid token type for arithmetic");             \
   }
 
+// integer division and modulo go through the helpers so a zero divisor doesn't trap
+#define BINARY_DIVIDE_OP()                                                     \
+  auto rhs = resolveToken(args.first[--args.second]);                          \
+  auto lhs = resolveToken(args.first[--args.second]);                          \
+  switch (lhs.type) {                                                          \
+  case TokenType::Unsigned:                                                    \
+    return divideInteger(tokenTo<uint64_t>(lhs, resolve), tokenTo<uint64_t>(rhs, resolve)); \
+  case TokenType::Signed:                                                      \
+    return divideInteger(tokenTo<int64_t>(lhs, resolve), tokenTo<int64_t>(rhs, resolve)); \
+  case TokenType::Float:                                                       \
+    return tokenTo<double>(lhs, resolve) / tokenTo<double>(rhs, resolve);      \
+  default:                                                                     \
+    throw std::runtime_error("invalid token type for arithmetic op");          \
+  }
+
+#define BINARY_MODULO_OP()                                                     \
+  auto rhs = resolveToken(args.first[--args.second]);                          \
+  auto lhs = resolveToken(args.first[--args.second]);                          \
+  switch (lhs.type) {                                                          \
+  case TokenType::Unsigned:                                                    \
+    return moduloInteger(tokenTo<uint64_t>(lhs, resolve), tokenTo<uint64_t>(rhs, resolve)); \
+  case TokenType::Signed:                                                      \
+    return moduloInteger(static_cast<uint64_t>(tokenTo<int64_t>(lhs, resolve)), \
+                         static_cast<uint64_t>(tokenTo<int64_t>(rhs, resolve))); \
+  default:                                                                     \
+    throw std::runtime_error("invalid token type for arithmetic");             \
+  }
+
 #define BINARY_LOGICAL_OP(op)                                                  \
   auto rhs = resolveToken(args.first[--args.second]);                          \
   auto lhs = resolveToken(args.first[--args.second]);                          \
@@ -200,107 +207,84 @@ Token resolveTokenImpl(const Token& token, const std::function<Token(const std::
     throw std::runtime_error("invalid token type for logical");                \
   }
 
-static const std::array<std::function<Token(TokenStack &, const std::function<Token(const std::string &)> &resolve)>,
-                        static_cast<unsigned>(OperatorType::OperatorCount)>
-    s_Operations{
-        /*Invalid */
-        [](TokenStack &args, const std::function<Token(const std::string&)> resolve) -> Token { throw std::runtime_error("trying to evaluate invalid operator"); },
-        [](TokenStack &args, const std::function<Token(const std::string&)> resolve) -> Token { throw std::runtime_error("assignment not implemented yet"); },
-        /*Add */
-        [](TokenStack &args, const std::function<Token(const std::string&)> resolve) -> Token { BINARY_STR_OP(+) },
-        /*Subtract */
-        [](TokenStack &args, const std::function<Token(const std::string&)> resolve) -> Token { BINARY_OP(-) },
-        /*Multiply */
-        [](TokenStack &args, const std::function<Token(const std::string&)> resolve) -> Token { BINARY_OP(*) },
-        /*Divide */
-        [](TokenStack &args, const std::function<Token(const std::string&)> resolve) -> Token { BINARY_OP(/) },
-        /*Modulo */
-        [](TokenStack &args, const std::function<Token(const std::string&)> resolve) -> Token { BINARY_UNSIGNED_OP(%) },
-
-        /*ShiftLeft */
-        [](TokenStack &args, const std::function<Token(const std::string&)> resolve) -> Token { BINARY_UNSIGNED_OP(<<) },
-        /*ShiftRight */
-        [](TokenStack &args, const std::function<Token(const std::string&)> resolve) -> Token { BINARY_UNSIGNED_OP(>>) },
-        /*Xor */
-        [](TokenStack &args, const std::function<Token(const std::string&)> resolve) -> Token { BINARY_UNSIGNED_OP(^) },
-        /*BitwiseAnd */
-        [](TokenStack &args, const std::function<Token(const std::string&)> resolve) -> Token { BINARY_UNSIGNED_OP(&) },
-        /*BitwiseOr */
-        [](TokenStack &args, const std::function<Token(const std::string&)> resolve) -> Token { BINARY_UNSIGNED_OP(|) },
+static Token evaluateOperator(OperatorType op, TokenStack &args,
+                              const std::function<Token(const std::string &)> &resolve,
+                              StringArena &strings) {
+  switch (op) {
+  case OperatorType::Add: { BINARY_STR_OP(+) }
+  case OperatorType::Subtract: { BINARY_OP(-) }
+  case OperatorType::Multiply: { BINARY_OP(*) }
+  case OperatorType::Divide: { BINARY_DIVIDE_OP() }
+  case OperatorType::Modulo: { BINARY_MODULO_OP() }
 
-        /*LessThan */
-        [](TokenStack &args, const std::function<Token(const std::string&)> resolve) -> Token { BINARY_OP(<) },
-        /*LessOrEqual */
-        [](TokenStack &args, const std::function<Token(const std::string&)> resolve) -> Token { BINARY_OP(<=) },
-        /*GreaterThan */
-        [](TokenStack &args, const std::function<Token(const std::string&)> resolve) -> Token { BINARY_OP(>) },
-        /*GreaterOrEqual */
-        [](TokenStack &args, const std::function<Token(const std::string&)> resolve) -> Token { BINARY_OP(>=) },
+  case OperatorType::ShiftLeft: { BINARY_UNSIGNED_OP(<<) }
+  case OperatorType::ShiftRight: { BINARY_UNSIGNED_OP(>>) }
+  case OperatorType::Xor: { BINARY_UNSIGNED_OP(^) }
+  case OperatorType::BitwiseAnd: { BINARY_UNSIGNED_OP(&) }
+  case OperatorType::BitwiseOr: { BINARY_UNSIGNED_OP(|) }
 
-       /*Equal */
-        [](TokenStack &args, const std::function<Token(const std::string&)> resolve) -> Token { BINARY_OP(==) },
-        /*NotEqual */
-        [](TokenStack &args, const std::function<Token(const std::string&)> resolve) -> Token { BINARY_OP(!=) },
+  case OperatorType::LessThan: { BINARY_OP(<) }
+  case OperatorType::LessOrEqual: { BINARY_OP(<=) }
+  case OperatorType::GreaterThan: { BINARY_OP(>) }
+  case OperatorType::GreaterOrEqual: { BINARY_OP(>=) }
 
-        /*LogicalAnd */
-        [](TokenStack &args, const std::function<Token(const std::string&)> resolve) -> Token { BINARY_LOGICAL_OP(&&) },
-        /*LogicalOr */
-        [](TokenStack &args, const std::function<Token(const std::string&)> resolve) -> Token { BINARY_LOGICAL_OP(||) },
-        [](TokenStack &args, const std::function<Token(const std::string&)> resolve) -> Token { UNARY_OP(!) },
+  case OperatorType::Equal: { BINARY_OP(==) }
+  case OperatorType::NotEqual: { BINARY_OP(!=) }
 
-        /*TernaryQ */
-        [](TokenStack &args, const std::function<Token(const std::string&)> resolve) -> Token {
-          // x ? y : z
-          // x ? y is evaluated first, we push y on the stack if the condition is true, an invalid operator otherwise
-          const auto &tok = resolveToken(args.first[--args.second]);
-          auto cond = pop<bool>(args);
-          if (cond) {
-            return tok;
-          } else {
-            return Token(OperatorType::Incomplete);
-          }
-        },
-        /*TernaryE */
-        [](TokenStack &args, const std::function<Token(const std::string&)> resolve) -> Token {
-          // x ? y : z
-          // if x was true, we now see y : z and then y "wins".
-          // if x was false, we now see <invalid> : z and then z "wins"
-          const auto &rhs = resolveToken(args.first[--args.second]);
-          const auto &lhs = resolveToken(args.first[--args.second]);
-          if (lhs.type == TokenType::Operator) {
-            return rhs;
-          } else {
-            return lhs;
-          }
-        }};
+  case OperatorType::LogicalAnd: { BINARY_LOGICAL_OP(&&) }
+  case OperatorType::LogicalOr: { BINARY_LOGICAL_OP(||) }
+  case OperatorType::LogicalNot: { UNARY_OP(!) }
 
-KnownVariables Token::s_KnownVariables{};
-KnownFunctions Token::s_KnownFunctions{};
-uint64_t Token::s_NextVariable{1};
+  case OperatorType::TernaryQ: {
+    // x ? y : z
+    // x ? y is evaluated first, we push y on the stack if the condition is true, an invalid operator otherwise
+    const auto &tok = resolveToken(args.first[--args.second]);
+    auto cond = pop<bool>(args);
+    if (cond) {
+      return tok;
+    } else {
+      return Token(OperatorType::Incomplete);
+    }
+  }
+  case OperatorType::TernaryE: {
+    // x ? y : z
+    // if x was true, we now see y : z and then y "wins".
+    // if x was false, we now see <invalid> : z and then z "wins"
+    const auto &rhs = resolveToken(args.first[--args.second]);
+    const auto &lhs = resolveToken(args.first[--args.second]);
+    if (lhs.type == TokenType::Operator) {
+      return rhs;
+    } else {
+      return lhs;
+    }
+  }
+  case OperatorType::Assign:
+    throw std::runtime_error("assignment not implemented yet");
+  default:
+    throw std::runtime_error("trying to evaluate invalid operator");
+  }
+}
 
 Token Token::evaluate(
     TokenStack &args, const std::function<Token(const std::string &)> &resolve,
-    const std::function<void(const std::string &, const Token &)> &assign)
-    const {
+    const std::function<void(const std::string &, const Token &)> &assign,
+    Workspace &workspace) const {
   // } else if (cur.type == TokenType::Variable) {
   //   push(stack, resolve(cur.getVariableName()));
   if (type != TokenType::Operator) {
     throw std::runtime_error("expected operator token");
   }
   if (op == OperatorType::ArgumentList) {
-    std::vector<Token> funcArgs;
+    // the arguments are passed as a view of the stack, variables get resolved in place
+    auto top = args.second;
     while (args.first[--args.second].type != TokenType::Function) {
-      auto name = args.first[args.second].getVariableName();
-      if (args.first[args.second].type == TokenType::Variable)
-      {
-        funcArgs.emplace_back(resolve(name));
+      auto &arg = args.first[args.second];
+      if (arg.type == TokenType::Variable) {
+        arg = resolve(arg.getVariableName());
       }
-      else {
-        funcArgs.emplace_back(args.first[args.second]);
-      }
-   }
-    std::reverse(funcArgs.begin(), funcArgs.end());
-    return args.first[args.second].getFunction()(funcArgs);
+    }
+    const Token *first = args.first.data() + args.second + 1;
+    return args.first[args.second].getFunction().call(FunctionArgs(first, top - args.second - 1));
   } else if (op == OperatorType::Assign) {
     auto rhs = args.first[--args.second];
     if (rhs.type == TokenType::Variable)
@@ -311,6 +295,6 @@ Token Token::evaluate(
     assign(lhs.getVariableName(), rhs);
     return Token(true);
   }
-  return s_Operations[static_cast<unsigned>(op)](args, resolve);
+  return evaluateOperator(op, args, resolve, workspace.strings());
 }
 }
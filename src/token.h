@@ -2,12 +2,19 @@
 
 #include <algorithm>
 #include <cstdint>
+#include <format>
 #include <functional>
+#include <limits>
 #include <memory>
+#include <stdexcept>
 #include <string>
+#include <string_view>
 #include <variant>
 #include <vector>
 
+#include "string_arena.h"
+#include "symbol_table.h"
+
 namespace SYP {
 
 enum class TokenType {
@@ -22,6 +29,8 @@ enum class TokenType {
   String,
   FunctionName,
   Function,
+  // variable reference resolved to a slot index in a compiled expression
+  Slot,
 };
 
 enum class OperatorType : unsigned {
@@ -75,20 +84,91 @@ template <typename T>
 concept arithmetic = std::is_arithmetic_v<T>;
 
 /**
- * get priority value (lower value means higher priority) of an operator
+ * get priority value (lower value means higher priority) of an operator. constexpr so expressions
+ * parsed during compilation use the same precedence
  */
-int getOperatorOrder(const OperatorType &op);
+constexpr int getOperatorOrder(const OperatorType &op) {
+  switch (op) {
+  case OperatorType::LogicalNot:
+    return 2;
+  case OperatorType::Multiply:
+  case OperatorType::Divide:
+  case OperatorType::Modulo:
+    return 3;
+  case OperatorType::Add:
+  case OperatorType::Subtract:
+    return 4;
+  case OperatorType::ShiftLeft:
+  case OperatorType::ShiftRight:
+    return 5;
+  case OperatorType::LessThan:
+  case OperatorType::LessOrEqual:
+  case OperatorType::GreaterThan:
+  case OperatorType::GreaterOrEqual:
+    return 6;
+  case OperatorType::Equal:
+  case OperatorType::NotEqual:
+    return 7;
+  case OperatorType::BitwiseAnd:
+    return 8;
+  case OperatorType::Xor:
+    return 9;
+  case OperatorType::BitwiseOr:
+    return 10;
+  case OperatorType::LogicalAnd:
+    return 11;
+  case OperatorType::LogicalOr:
+    return 12;
+  case OperatorType::TernaryQ:
+    return 13;
+  case OperatorType::TernaryE:
+    return 14;
+  case OperatorType::Assign:
+    return 30;
+  case OperatorType::BracketOpen:
+  case OperatorType::BracketClose:
+  case OperatorType::ArgumentList:
+    // brackets are handled separately so this priority should be so high
+    // it never gets removed from operator stack prematurely
+    return 20;
+  default:
+    throw std::out_of_range(
+        std::format("Invalid operator type {}", static_cast<unsigned>(op)));
+  }
+}
+
+/**
+ * get the symbol of an operator as written in expressions, for use in messages
+ */
+const char *getOperatorName(const OperatorType &op);
 
 inline bool operator<(const OperatorType &lhs, const OperatorType &rhs) {
   return getOperatorOrder(lhs) < getOperatorOrder(rhs);
 }
 
+/**
+ * integer division and modulo never trap: a zero divisor and INT64_MIN / -1 produce 0. The batch
+ * kernels divide every lane, including padding and rows a conditional doesn't select, so all
+ * evaluation paths share this result
+ */
+inline int64_t divideInteger(int64_t lhs, int64_t rhs) {
+  if ((rhs == 0) || ((rhs == -1) && (lhs == std::numeric_limits<int64_t>::min()))) {
+    return 0;
+  }
+  return lhs / rhs;
+}
+
+inline uint64_t divideInteger(uint64_t lhs, uint64_t rhs) {
+  return rhs != 0 ? lhs / rhs : 0;
+}
+
+inline uint64_t moduloInteger(uint64_t lhs, uint64_t rhs) {
+  return rhs != 0 ? lhs % rhs : 0;
+}
+
 struct Token;
+class Workspace;
 
-using VariableId = uint64_t;
-using KnownVariables = std::vector<std::string>;
-using DynamicFunction = std::function<Token(const std::vector<Token>&)>;
-using KnownFunctions = std::vector<std::pair<std::string, DynamicFunction>>;
 using TokenValue = std::variant<OperatorType, uint64_t, int64_t, double, bool>;
 
 using TokenQueue = std::vector<Token>;
@@ -105,20 +185,26 @@ struct Token {
     int64_t signedValue;
     double floatValue;
     bool boolValue;
+    // Variable, String
+    const std::string *name;
+    // FunctionName, Function
+    const FunctionEntry *function;
   };
 
   Token() : type(TokenType::Undefined), op(OperatorType::Invalid) {}
 
-  Token(const std::string &valueIn, TokenType type) : type(type) {
-    if (type == TokenType::FunctionName) {
-      initFunction(valueIn);
+  Token(std::string_view valueIn, TokenType type, SymbolTable &symbols) : type(type) {
+    if ((type == TokenType::FunctionName) || (type == TokenType::Function)) {
+      function = symbols.internFunction(valueIn);
     } else {
-      initVariable(valueIn);
+      name = symbols.internVariable(valueIn);
     }
   }
 
+  Token(const std::string &valueIn, TokenType type) : Token(valueIn, type, SymbolTable::defaultTable()) {}
+
   // need to be able to call with a single argument, otherwise const char* might end up implicitly casted to bool
-  Token(const char* valueIn, TokenType type = TokenType::String) : Token(std::string(valueIn), type) {}
+  Token(const char* valueIn, TokenType type = TokenType::String) : Token(std::string_view(valueIn), type, SymbolTable::defaultTable()) {}
 
   Token(uint64_t valueIn) : type(TokenType::Unsigned), unsignedValue(valueIn) {}
   Token(std::size_t valueIn) : type(TokenType::Unsigned), unsignedValue(valueIn) {}
@@ -126,22 +212,11 @@ struct Token {
   Token(int valueIn) : type(TokenType::Signed), signedValue(valueIn) {}
   Token(double valueIn) : type(TokenType::Float), floatValue(valueIn) {}
   Token(bool valueIn) : type(TokenType::Boolean), boolValue(valueIn) {}
-  Token(const std::string& name, const DynamicFunction& function) : type(TokenType::Function) {
-    auto iter = std::find_if(s_KnownFunctions.begin(), s_KnownFunctions.end(), [&](const std::pair<std::string, DynamicFunction> &iter) -> bool { return iter.first == name; });
-    uint64_t offset;
-    if (iter == s_KnownFunctions.end()) {
-      // unreferenced function, shouldn't happen when coming from a tokenizer but may occur in
-      // synthetic unit tests
-      offset = s_KnownFunctions.size();
-      s_KnownFunctions.emplace_back(name, function);
-    } else {
-      if (iter->second == nullptr)    {
-        iter->second = function;
-      }
-      offset = iter - s_KnownFunctions.begin();
-    }
-    unsignedValue = offset;
-  }
+  // string owned by someone else, usually the StringArena of the running evaluation
+  explicit Token(const std::string *valueIn) : type(TokenType::String), name(valueIn) {}
+  template <FunctionCallable F>
+  Token(const std::string &name, F &&function, SymbolTable &symbols = SymbolTable::defaultTable())
+    : type(TokenType::Function), function(symbols.registerFunction(name, std::forward<F>(function))) {}
 
   Token(OperatorType op) : type(TokenType::Operator), op(op) {}
 
@@ -149,51 +224,23 @@ struct Token {
   evaluate(TokenStack &iter,
            const std::function<Token(const std::string &)> &resolve,
            const std::function<void(const std::string &, const Token &)>
-               &assign) const;
+               &assign,
+           Workspace &workspace) const;
 
   [[nodiscard]] const std::string &getVariableName() const {
-   return type == TokenType::FunctionName
-               ? s_KnownFunctions[unsignedValue].first
-               : s_KnownVariables[unsignedValue];
+    return ((type == TokenType::FunctionName) || (type == TokenType::Function))
+               ? function->name
+               : *name;
   }
 
-  [[nodiscard]] const DynamicFunction &getFunction() const {
-    return s_KnownFunctions[unsignedValue].second;
+  [[nodiscard]] const FunctionEntry &getFunction() const {
+    return *function;
   }
-
-private:
-
-  void initFunction(const std::string& valueIn) {
-    auto iter = std::find_if(s_KnownFunctions.begin(), s_KnownFunctions.end(), [&](const std::pair<std::string, DynamicFunction> &iter) -> bool { return iter.first == valueIn; });
-    uint64_t offset;
-    if (iter == s_KnownFunctions.end()) {
-      offset = s_KnownFunctions.size();
-      s_KnownFunctions.emplace_back(valueIn, nullptr);
-    } else {
-      offset = iter - s_KnownFunctions.begin();
-    }
-    unsignedValue = offset;
-  }
-
-  void initVariable(const std::string& valueIn) {
-    auto iter = std::find_if(s_KnownVariables.begin(), s_KnownVariables.end(), [&](const std::string &iter) -> bool { return iter == valueIn; });
-    uint64_t offset;
-    if (iter == s_KnownVariables.end()) {
-      offset = s_KnownVariables.size();
-      s_KnownVariables.emplace_back(valueIn);
-    } else {
-      offset = iter - s_KnownVariables.begin();
-    }
-    unsignedValue = offset;
-  }
-
-private:
-
-  static KnownVariables s_KnownVariables;
-  static KnownFunctions s_KnownFunctions;
-  static uint64_t s_NextVariable;
 };
 
+// the type and one 8 byte value, stacks and constant pools depend on tokens staying this small
+static_assert(sizeof(Token) == 16);
+
 /*
 class OperatorBase;
 class NumericBase;
@@ -398,3 +445,6 @@ private:
 */
 
 }
+
+// registration of functions with native signatures needs the complete Token
+#include "native_function.h"
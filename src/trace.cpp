@@ -0,0 +1,19 @@
+#include "trace.h"
+
+namespace SYP {
+
+namespace {
+
+thread_local EvalObserver *s_Observer = nullptr;
+
+}
+
+void setEvalObserver(EvalObserver *observer) {
+  s_Observer = observer;
+}
+
+EvalObserver *getEvalObserver() {
+  return s_Observer;
+}
+
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <span>
+
+#include "token.h"
+
+namespace SYP {
+
+/**
+ * receives every operation executed during evaluation. Only called if the library is built with
+ * PAGAN_EXPR_TRACE, otherwise the hooks compile to nothing.
+ * Operands are passed as they were on the evaluation stack, variables may not be resolved yet
+ */
+class EvalObserver {
+public:
+  virtual ~EvalObserver() = default;
+
+  virtual void onOperation(OperatorType op, std::span<const Token> operands, const Token &result) = 0;
+};
+
+/**
+ * set the observer for evaluations on the calling thread, nullptr to disable
+ */
+void setEvalObserver(EvalObserver *observer);
+
+[[nodiscard]] EvalObserver *getEvalObserver();
+
+#ifdef PAGAN_EXPR_TRACE
+#define PAGAN_TRACE_OPERATION(op, operands, result)                            \
+  do {                                                                         \
+    if (auto observer = getEvalObserver(); observer != nullptr) {              \
+      observer->onOperation(op, operands, result);                             \
+    }                                                                          \
+  } while (false)
+#else
+// arguments stay unevaluated but count as used, so locals only computed for the trace don't warn
+#define PAGAN_TRACE_OPERATION(op, operands, result)                            \
+  do {                                                                         \
+    (void)sizeof(op);                                                          \
+    (void)sizeof(operands);                                                    \
+    (void)sizeof(result);                                                      \
+  } while (false)
+#endif
+
+}
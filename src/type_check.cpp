@@ -0,0 +1,292 @@
+#include "type_check.h"
+
+#include "native_function.h"
+
+#include <format>
+#include <stdexcept>
+
+namespace SYP {
+
+namespace {
+
+bool isInteger(TokenType type) {
+  return (type == TokenType::Signed) || (type == TokenType::Unsigned);
+}
+
+bool isNumeric(TokenType type) {
+  return isInteger(type) || (type == TokenType::Float);
+}
+
+TokenType promote(TokenType lhs, TokenType rhs) {
+  if ((lhs == TokenType::Float) || (rhs == TokenType::Float)) {
+    return TokenType::Float;
+  } else if ((lhs == TokenType::Signed) || (rhs == TokenType::Signed)) {
+    return TokenType::Signed;
+  }
+  return TokenType::Unsigned;
+}
+
+/**
+ * result type for operators with at least one operand only known at runtime, mirrors what the
+ * dynamically typed operators in token.cpp produce
+ */
+TokenType dynamicResultType(OperatorType op, TokenType lhs) {
+  switch (op) {
+  case OperatorType::Add:
+  case OperatorType::Subtract:
+  case OperatorType::Multiply:
+  case OperatorType::Divide:
+    return lhs;
+  case OperatorType::Modulo:
+  case OperatorType::ShiftLeft:
+  case OperatorType::ShiftRight:
+  case OperatorType::Xor:
+  case OperatorType::BitwiseAnd:
+  case OperatorType::BitwiseOr:
+    return TokenType::Unsigned;
+  case OperatorType::LessThan:
+  case OperatorType::LessOrEqual:
+  case OperatorType::GreaterThan:
+  case OperatorType::GreaterOrEqual:
+  case OperatorType::Equal:
+  case OperatorType::NotEqual:
+  case OperatorType::LogicalAnd:
+  case OperatorType::LogicalOr:
+  case OperatorType::LogicalNot:
+    return TokenType::Boolean;
+  default:
+    return TokenType::Undefined;
+  }
+}
+
+class TypeChecker {
+public:
+  TypeChecker(ExpressionTree &tree) : m_Tree(tree) {}
+
+  TokenType check(uint32_t idx) {
+    auto &node = m_Tree.nodes[idx];
+    switch (node.kind) {
+    case NodeKind::Constant:
+      break;
+    case NodeKind::Slot:
+      node.type = m_Tree.slotTypes[node.index];
+      break;
+    case NodeKind::Call:
+      checkCall(idx);
+      break;
+    case NodeKind::Convert:
+      check(node.operands[0]);
+      break;
+    case NodeKind::Conditional:
+      checkConditional(idx);
+      break;
+    case NodeKind::Operator:
+      checkOperator(idx);
+      break;
+    }
+    return m_Tree.nodes[idx].type;
+  }
+
+private:
+  [[nodiscard]] TokenType typeOf(uint32_t idx) const { return m_Tree.nodes[idx].type; }
+
+  void convertOperand(uint32_t idx, size_t operand, TokenType type) {
+    auto source = m_Tree.nodes[idx].operands[operand];
+    if (typeOf(source) != type) {
+      // may reallocate the nodes so no references must be held here
+      auto conversion = m_Tree.add(Node{ NodeKind::Convert, OperatorType::Invalid, type, 0, { source } });
+      m_Tree.nodes[idx].operands[operand] = conversion;
+    }
+  }
+
+  void toBoolean(uint32_t idx, size_t operand, OperatorType op) {
+    auto type = typeOf(m_Tree.nodes[idx].operands[operand]);
+    if (isInteger(type)) {
+      convertOperand(idx, operand, TokenType::Boolean);
+    } else if ((type != TokenType::Boolean) && (type != TokenType::Undefined)) {
+      throw std::runtime_error(std::format("type error: {} can't be used as condition for operator {}",
+                                           getTypeName(type), getOperatorName(op)));
+    }
+  }
+
+  void checkCall(uint32_t idx) {
+    // checking may add nodes so the node reference can't be used past this point
+    for (size_t i = 0; i < m_Tree.nodes[idx].operands.size(); ++i) {
+      check(m_Tree.nodes[idx].operands[i]);
+    }
+
+    const auto *entry = m_Tree.functions[m_Tree.nodes[idx].index];
+    if ((entry == nullptr) || (entry->signature == nullptr)) {
+      return;
+    }
+    const auto &parameters = entry->signature->parameters;
+    auto count = m_Tree.nodes[idx].operands.size();
+    if (count != parameters.size()) {
+      throw std::runtime_error(std::format("type error: function {} expects {} arguments, got {}", entry->name,
+                                           parameters.size(), count));
+    }
+    for (size_t i = 0; i < count; ++i) {
+      auto type = typeOf(m_Tree.nodes[idx].operands[i]);
+      if ((type == parameters[i]) || (type == TokenType::Undefined)) {
+        continue;
+      }
+      // integers convert to any numeric parameter, floats are never truncated implicitly
+      if (isInteger(type) && isNumeric(parameters[i])) {
+        convertOperand(idx, i, parameters[i]);
+      } else {
+        throw std::runtime_error(std::format("type error: argument {} of function {} has to be {}, got {}", i + 1,
+                                             entry->name, getTypeName(parameters[i]), getTypeName(type)));
+      }
+    }
+    m_Tree.nodes[idx].type = entry->signature->result;
+  }
+
+  void checkConditional(uint32_t idx) {
+    auto cond = check(m_Tree.nodes[idx].operands[0]);
+    auto lhs = check(m_Tree.nodes[idx].operands[1]);
+    auto rhs = check(m_Tree.nodes[idx].operands[2]);
+    toBoolean(idx, 0, OperatorType::TernaryQ);
+    if ((cond == TokenType::Undefined) || (lhs == TokenType::Undefined) || (rhs == TokenType::Undefined)) {
+      m_Tree.nodes[idx].type = TokenType::Undefined;
+    } else if (lhs == rhs) {
+      m_Tree.nodes[idx].type = lhs;
+    } else if (isNumeric(lhs) && isNumeric(rhs)) {
+      auto common = promote(lhs, rhs);
+      convertOperand(idx, 1, common);
+      convertOperand(idx, 2, common);
+      m_Tree.nodes[idx].type = common;
+    } else {
+      throw std::runtime_error(std::format("type error: branches of conditional have incompatible types {} and {}",
+                                           getTypeName(lhs), getTypeName(rhs)));
+    }
+  }
+
+  void checkOperator(uint32_t idx) {
+    auto op = m_Tree.nodes[idx].op;
+    if (op == OperatorType::LogicalNot) {
+      check(m_Tree.nodes[idx].operands[0]);
+      toBoolean(idx, 0, op);
+      m_Tree.nodes[idx].type = TokenType::Boolean;
+      return;
+    }
+
+    auto lhs = check(m_Tree.nodes[idx].operands[0]);
+    auto rhs = check(m_Tree.nodes[idx].operands[1]);
+
+    if ((lhs == TokenType::Undefined) || (rhs == TokenType::Undefined)) {
+      m_Tree.nodes[idx].type = dynamicResultType(op, lhs);
+      return;
+    }
+
+    auto invalid = [&]() {
+      return std::runtime_error(std::format("type error: invalid operand types {} and {} for operator {}",
+                                            getTypeName(lhs), getTypeName(rhs), getOperatorName(op)));
+    };
+
+    switch (op) {
+    case OperatorType::Add:
+      if ((lhs == TokenType::String) && (rhs == TokenType::String)) {
+        m_Tree.nodes[idx].type = TokenType::String;
+        return;
+      }
+      [[fallthrough]];
+    case OperatorType::Subtract:
+    case OperatorType::Multiply:
+    case OperatorType::Divide: {
+      if (!isNumeric(lhs) || !isNumeric(rhs)) {
+        throw invalid();
+      }
+      auto common = promote(lhs, rhs);
+      convertOperand(idx, 0, common);
+      convertOperand(idx, 1, common);
+      m_Tree.nodes[idx].type = common;
+      return;
+    }
+    case OperatorType::Modulo:
+    case OperatorType::ShiftLeft:
+    case OperatorType::ShiftRight:
+    case OperatorType::Xor:
+    case OperatorType::BitwiseAnd:
+    case OperatorType::BitwiseOr:
+      if (!isInteger(lhs) || !isInteger(rhs)) {
+        throw invalid();
+      }
+      // integer operators work on the unsigned representation
+      convertOperand(idx, 0, TokenType::Unsigned);
+      convertOperand(idx, 1, TokenType::Unsigned);
+      m_Tree.nodes[idx].type = TokenType::Unsigned;
+      return;
+    case OperatorType::Equal:
+    case OperatorType::NotEqual:
+      if ((lhs == rhs) && ((lhs == TokenType::Boolean) || (lhs == TokenType::String))) {
+        m_Tree.nodes[idx].type = TokenType::Boolean;
+        return;
+      }
+      [[fallthrough]];
+    case OperatorType::LessThan:
+    case OperatorType::LessOrEqual:
+    case OperatorType::GreaterThan:
+    case OperatorType::GreaterOrEqual: {
+      if (!isNumeric(lhs) || !isNumeric(rhs)) {
+        throw invalid();
+      }
+      auto common = promote(lhs, rhs);
+      convertOperand(idx, 0, common);
+      convertOperand(idx, 1, common);
+      m_Tree.nodes[idx].type = TokenType::Boolean;
+      return;
+    }
+    case OperatorType::LogicalAnd:
+    case OperatorType::LogicalOr:
+      if (!(isInteger(lhs) || (lhs == TokenType::Boolean)) || !(isInteger(rhs) || (rhs == TokenType::Boolean))) {
+        throw invalid();
+      }
+      toBoolean(idx, 0, op);
+      toBoolean(idx, 1, op);
+      m_Tree.nodes[idx].type = TokenType::Boolean;
+      return;
+    default:
+      throw invalid();
+    }
+  }
+
+private:
+  ExpressionTree &m_Tree;
+};
+
+}
+
+const char *getTypeName(TokenType type) {
+  switch (type) {
+  case TokenType::Signed: return "signed";
+  case TokenType::Unsigned: return "unsigned";
+  case TokenType::Float: return "float";
+  case TokenType::Boolean: return "boolean";
+  case TokenType::String: return "string";
+  case TokenType::Function: return "function";
+  case TokenType::Undefined: return "unknown";
+  default: return "invalid";
+  }
+}
+
+void typeCheck(ExpressionTree &tree, const VariableTypes &declared) {
+  for (size_t i = 0; i < tree.slots.size(); ++i) {
+    if (tree.functionSlots[i]) {
+      continue;
+    }
+    auto iter = declared.find(tree.slots[i]);
+    if (iter != declared.end()) {
+      if ((iter->second != TokenType::Signed) && (iter->second != TokenType::Unsigned) &&
+          (iter->second != TokenType::Float) && (iter->second != TokenType::Boolean) &&
+          (iter->second != TokenType::String)) {
+        throw std::runtime_error(std::format("type error: {} declared with unsupported type {}",
+                                             tree.slots[i], getTypeName(iter->second)));
+      }
+      tree.slotTypes[i] = iter->second;
+    }
+  }
+
+  TypeChecker(tree).check(tree.root);
+}
+
+}
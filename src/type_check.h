@@ -0,0 +1,28 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+
+#include "expression_tree.h"
+#include "token.h"
+
+namespace SYP {
+
+/**
+ * types of variables known before evaluation (Signed, Unsigned, Float, Boolean or String)
+ */
+using VariableTypes = std::unordered_map<std::string, TokenType>;
+
+[[nodiscard]] const char *getTypeName(TokenType type);
+
+/**
+ * infer the type of every node in the tree. Where the operands of an operator have different
+ * types, conversions to a common type get inserted, invalid combinations are reported by throwing
+ * a runtime_error.
+ * Variables not listed in declared, and results of functions registered without a native
+ * signature, are only known at runtime, operators using them keep checking types during evaluation.
+ * Calls to functions with a native signature are checked for arity and argument types
+ */
+void typeCheck(ExpressionTree &tree, const VariableTypes &declared);
+
+}
@@ -0,0 +1,35 @@
+#include "workspace.h"
+
+namespace SYP {
+
+namespace {
+
+void shrink(std::vector<Token> &buffer, size_t threshold) {
+  if ((threshold != 0) && (buffer.capacity() > threshold)) {
+    std::vector<Token>().swap(buffer);
+  }
+}
+
+}
+
+Workspace &Workspace::local() {
+  thread_local Workspace s_Local;
+  return s_Local;
+}
+
+void Workspace::reset() {
+  // tokens are trivially destructible so clearing doesn't touch the elements
+  m_Stack.second = 0;
+  m_Operators.clear();
+  m_Output.clear();
+  m_Strings.reset();
+
+  shrink(m_Stack.first, m_ShrinkThreshold);
+  shrink(m_Operators, m_ShrinkThreshold);
+  shrink(m_Output, m_ShrinkThreshold);
+  if (m_ShrinkThreshold != 0) {
+    m_Strings.shrink(m_ShrinkThreshold);
+  }
+}
+
+}
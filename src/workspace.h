@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "string_arena.h"
+#include "token.h"
+
+namespace SYP {
+
+/**
+ * scratch memory used while parsing and evaluating expressions: operator stack, output queue,
+ * evaluation stack and temporary strings.
+ * Owned by the caller so it can be kept per request, per fiber or per thread as appropriate.
+ * Buffers are reused between operations, a buffer that grew beyond the shrink threshold gets
+ * released on the next reset so a single huge expression doesn't pin its memory forever.
+ * Not thread safe, use one workspace per concurrent evaluation.
+ * Not reentrant either: a function called during an evaluation mustn't evaluate or parse with
+ * the workspace of the running evaluation, including Workspace::local() if that's the one in use.
+ * The nested call would empty and possibly reallocate the stack the function arguments point
+ * into and release the strings of the outer evaluation. Give nested evaluations their own
+ * workspace
+ */
+class Workspace {
+public:
+  static constexpr size_t s_DefaultShrinkThreshold = 4096;
+
+public:
+  /**
+   * @param shrinkThreshold number of elements a buffer may hold across resets, 0 to never shrink
+   */
+  explicit Workspace(size_t shrinkThreshold = s_DefaultShrinkThreshold) : m_ShrinkThreshold(shrinkThreshold) {}
+
+  Workspace(const Workspace &) = delete;
+  Workspace &operator=(const Workspace &) = delete;
+
+  /**
+   * workspace used by the overloads that don't take an explicit one, one per thread. Those
+   * overloads therefore can't be called from a function invoked by one of them
+   */
+  static Workspace &local();
+
+  /**
+   * forget the content of all buffers. Only releases memory of buffers above the shrink threshold
+   */
+  void reset();
+
+  void setShrinkThreshold(size_t threshold) { m_ShrinkThreshold = threshold; }
+  [[nodiscard]] size_t shrinkThreshold() const { return m_ShrinkThreshold; }
+
+  /**
+   * evaluation stack, emptied and able to hold at least size tokens. Invalidates pointers into
+   * the stack handed out before
+   */
+  [[nodiscard]] TokenStack &stack(size_t size) {
+    if (m_Stack.first.size() < size) {
+      m_Stack.first.resize(size);
+    }
+    m_Stack.second = 0;
+    return m_Stack;
+  }
+
+  [[nodiscard]] std::vector<Token> &operators() { return m_Operators; }
+  [[nodiscard]] TokenQueue &output() { return m_Output; }
+  [[nodiscard]] StringArena &strings() { return m_Strings; }
+
+  /**
+   * number of tokens the buffers can currently hold without allocating
+   */
+  [[nodiscard]] size_t capacity() const {
+    return m_Stack.first.capacity() + m_Operators.capacity() + m_Output.capacity();
+  }
+
+private:
+  size_t m_ShrinkThreshold;
+  TokenStack m_Stack{ std::vector<Token>{}, 0 };
+  std::vector<Token> m_Operators;
+  TokenQueue m_Output;
+  StringArena m_Strings;
+};
+
+}
@@ -0,0 +1,198 @@
+#include "archive.h"
+#include "compiled_expression.h"
+#include "shunting_yard.h"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace std::literals;
+using namespace SYP;
+
+namespace {
+
+/**
+ * archive file in the temp directory, removed again at the end of the test
+ */
+class TempArchive {
+public:
+  explicit TempArchive(const char *name)
+    : m_Path((std::filesystem::temp_directory_path() / std::format("pagan_{}.expa", name)).string()) {}
+  ~TempArchive() { std::filesystem::remove(m_Path); }
+
+  [[nodiscard]] const std::string &path() const { return m_Path; }
+
+  [[nodiscard]] std::string read() const {
+    std::ifstream in(m_Path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+  }
+
+  void write(const std::string &data) const {
+    std::ofstream out(m_Path, std::ios::binary | std::ios::trunc);
+    out.write(data.data(), static_cast<std::streamsize>(data.size()));
+  }
+
+private:
+  std::string m_Path;
+};
+
+SymbolTable &archiveSymbols() {
+  static SymbolTable s_Symbols;
+  static bool s_Registered = [] {
+    s_Symbols.registerFunction("twice", [](FunctionArgs args) { return Token(args[0].signedValue * 2); });
+    return true;
+  }();
+  (void)s_Registered;
+  return s_Symbols;
+}
+
+const std::unordered_map<std::string, Token> s_Values{
+  { "a", Token(int64_t(7)) }, { "b", Token(int64_t(-3)) }, { "x", Token(2.5) },
+  { "p", Token(true) },       { "name", Token("pagan") },
+};
+
+Token resolve(const std::string &name) {
+  if (name == "twice") {
+    return Token("twice", TokenType::Function, archiveSymbols());
+  }
+  return s_Values.at(name);
+}
+
+}
+
+TEST_CASE("evaluates archived expressions like compiled ones", "[Archive]") {
+  const std::vector<std::string> terms{
+    "a * 2 + b", "a - b * x", "p && a > b ? x : 0.5", "name + \"!\" == \"pagan!\"", "twice(a) + twice(b)",
+    "\"pagan\" + \"!\"", "1 + 2 * 3",
+  };
+  VariableTypes types{ { "a", TokenType::Signed }, { "x", TokenType::Float }, { "p", TokenType::Boolean },
+                       { "name", TokenType::String } };
+
+  std::vector<CompiledExpression> compiled;
+  std::vector<Program> programs;
+  for (const auto &term : terms) {
+    compiled.emplace_back(tokenize(term, archiveSymbols()), types);
+    programs.push_back(compiled.back().program());
+  }
+  TempArchive file("roundtrip");
+  writeArchive(file.path(), programs);
+
+  ExpressionArchive archive(file.path(), archiveSymbols());
+  archive.verify();
+  REQUIRE(archive.size() == terms.size());
+  for (size_t i = 0; i < terms.size(); ++i) {
+    INFO(terms[i]);
+    auto expr = archive[i];
+    REQUIRE(expr.slotCount() == compiled[i].slotCount());
+    REQUIRE(expr.resultType() == compiled[i].resultType());
+    for (size_t slot = 0; slot < expr.slotCount(); ++slot) {
+      REQUIRE(expr.variable(slot) == compiled[i].variables()[slot]);
+      REQUIRE(expr.slotType(slot) == compiled[i].slotType(slot));
+      REQUIRE(expr.isFunctionSlot(slot) == compiled[i].isFunctionSlot(slot));
+    }
+    REQUIRE(expr.evaluate(expr.bind(resolve)) == compiled[i].evaluate(compiled[i].bind(resolve)));
+  }
+}
+
+TEST_CASE("binds archived slots by name", "[Archive]") {
+  std::vector<Program> programs{ compile(tokenize("b * a + b"), { { "a", TokenType::Signed } }) };
+  TempArchive file("slots");
+  writeArchive(file.path(), programs);
+
+  ExpressionArchive archive(file.path());
+  auto expr = archive[0];
+  REQUIRE(expr.slotOf("a") == 1);
+  REQUIRE(expr.slotOf("c") == ArchivedExpression::npos);
+  REQUIRE(expr.slotType(0) == TokenType::Undefined);
+  REQUIRE(expr.slotType(1) == TokenType::Signed);
+  REQUIRE(expr.evaluate(expr.bind(resolve)) == Result(int64_t(-24)));
+
+  REQUIRE_THROWS(expr.bind([](const std::string &) { return Token(1.0); }));
+  std::vector<Token> slots{ Token(int64_t(1)) };
+  REQUIRE_THROWS(expr.evaluate(slots));
+  REQUIRE_THROWS(archive[1]);
+}
+
+TEST_CASE("rejects programs that can't be archived", "[Archive]") {
+  std::ostringstream out;
+  Program program = compile(tokenize("1 + 2"));
+  program.yieldCount = 2;
+  REQUIRE_THROWS(writeArchive(out, std::span(&program, 1)));
+}
+
+TEST_CASE("rejects damaged archives", "[Archive]") {
+  std::vector<Program> programs{ compile(tokenize("a + \"text\"")), compile(tokenize("a * 2 - b")) };
+  TempArchive file("damaged");
+  writeArchive(file.path(), programs);
+  const auto original = file.read();
+  REQUIRE_NOTHROW(ExpressionArchive(file.path()));
+
+  SECTION("missing") {
+    REQUIRE_THROWS(ExpressionArchive(file.path() + ".missing"));
+  }
+
+  SECTION("not an archive") {
+    file.write("just some text that is long enough to pass for a header of an archive, but isn't one");
+    REQUIRE_THROWS(ExpressionArchive(file.path()));
+  }
+
+  SECTION("other version") {
+    auto data = original;
+    data[8] = static_cast<char>(ExpressionArchive::s_Version + 1);
+    file.write(data);
+    REQUIRE_THROWS(ExpressionArchive(file.path()));
+  }
+
+  SECTION("truncated") {
+    file.write(original.substr(0, original.size() - 8));
+    REQUIRE_THROWS(ExpressionArchive(file.path()));
+  }
+
+  SECTION("invalid instruction") {
+    // the offset of the code section follows the magic, ten counts and the offsets of the
+    // expression and slot sections
+    uint64_t codeOffset = 0;
+    std::memcpy(&codeOffset, original.data() + 64, sizeof(codeOffset));
+    auto data = original;
+    Instruction instruction(OpCode::LoadConst, 1000);
+    std::memcpy(data.data() + codeOffset, &instruction, sizeof(instruction));
+    file.write(data);
+
+    ExpressionArchive archive(file.path());
+    REQUIRE_THROWS(archive.verify());
+  }
+
+  SECTION("stack size below the depth of the code") {
+    // the offset of the expression section follows the magic and ten counts, the stack size
+    // follows six counts in the record
+    uint64_t expressionOffset = 0;
+    std::memcpy(&expressionOffset, original.data() + 48, sizeof(expressionOffset));
+    auto data = original;
+    uint32_t stackSize = 1;
+    std::memcpy(data.data() + expressionOffset + 24, &stackSize, sizeof(stackSize));
+    file.write(data);
+
+    ExpressionArchive archive(file.path());
+    REQUIRE_THROWS(archive.verify());
+  }
+
+  SECTION("memo count beyond the code") {
+    uint64_t expressionOffset = 0;
+    std::memcpy(&expressionOffset, original.data() + 48, sizeof(expressionOffset));
+    auto data = original;
+    uint32_t memoCount = 1u << 30;
+    std::memcpy(data.data() + expressionOffset + 28, &memoCount, sizeof(memoCount));
+    file.write(data);
+
+    ExpressionArchive archive(file.path());
+    REQUIRE_THROWS(archive.verify());
+  }
+}
@@ -0,0 +1,134 @@
+#include "batch.h"
+#include "shunting_yard.h"
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+
+#include <memory>
+#include <vector>
+
+using namespace std::literals;
+using namespace SYP;
+
+namespace {
+
+const VariableTypes s_Types{
+  { "count", TokenType::Signed },
+  { "price", TokenType::Float },
+  { "active", TokenType::Boolean },
+};
+
+// more rows than fit in one block
+constexpr size_t s_Rows = 1000;
+
+struct Table {
+  std::vector<int64_t> count;
+  std::vector<double> price;
+  std::unique_ptr<bool[]> active;
+
+  Table() : active(new bool[s_Rows]) {
+    for (size_t i = 0; i < s_Rows; ++i) {
+      count.push_back(static_cast<int64_t>(i % 7));
+      price.push_back(static_cast<double>(i) * 0.5);
+      active[i] = (i % 3) == 0;
+    }
+  }
+
+  std::vector<Column> columns(const CompiledExpression &expr) const {
+    std::vector<Column> result;
+    for (const auto &name : expr.variables()) {
+      if (name == "count") {
+        result.emplace_back(count.data());
+      } else if (name == "price") {
+        result.emplace_back(price.data());
+      } else {
+        result.emplace_back(active.get());
+      }
+    }
+    return result;
+  }
+
+  std::vector<Token> row(const CompiledExpression &expr, size_t idx) const {
+    std::vector<Token> result;
+    for (const auto &name : expr.variables()) {
+      if (name == "count") {
+        result.emplace_back(count[idx]);
+      } else if (name == "price") {
+        result.emplace_back(price[idx]);
+      } else {
+        result.emplace_back(active[idx]);
+      }
+    }
+    return result;
+  }
+};
+
+template <typename T> void requireRowsMatch(const std::string &term, const VariableTypes &types) {
+  Table table;
+  CompiledExpression expr(tokenize(term), types);
+  std::unique_ptr<T[]> out(new T[s_Rows]);
+  auto columns = table.columns(expr);
+
+  evaluateBatch(expr, columns, s_Rows, out.get());
+
+  for (size_t i = 0; i < s_Rows; ++i) {
+    REQUIRE(Result(out[i]) == expr.evaluate(table.row(expr, i)));
+  }
+}
+
+}
+
+TEST_CASE("evaluates typed expressions column by column", "[Batch]") {
+  SECTION("arithmetic") {
+    auto term = GENERATE("count * price + 1.5", "price / 2.0");
+    requireRowsMatch<double>(term, s_Types);
+  }
+
+  SECTION("integers") {
+    // count is 0 in every seventh row, those divide to 0 on both paths
+    auto term = GENERATE("count * 8 + 3", "100 / (count + 1)", "60 / count");
+    requireRowsMatch<int64_t>(term, s_Types);
+  }
+
+  SECTION("unsigned") {
+    requireRowsMatch<uint64_t>("(count % 4) << 2", s_Types);
+  }
+
+  SECTION("conditions") {
+    auto term = GENERATE("active && count > 2", "active || price < 10.0", "count > 3 ? price > 100.0 : active",
+                         "!active && (count < 2 || price >= 200.0)");
+    requireRowsMatch<bool>(term, s_Types);
+  }
+
+  SECTION("conditional values") {
+    auto term = GENERATE("active ? count * 2 : count", "count > 0 ? 60 / count : 0",
+                         "active ? (count > 3 ? 1 : 2) : 3");
+    requireRowsMatch<int64_t>(term, s_Types);
+  }
+}
+
+TEST_CASE("falls back to row wise evaluation for undeclared variables", "[Batch]") {
+  auto term = GENERATE("count * 3 + 1", "count > 2 ? count : 0", "60 / count");
+  requireRowsMatch<int64_t>(term, {});
+}
+
+TEST_CASE("rejects mismatched columns", "[Batch]") {
+  Table table;
+  CompiledExpression expr(tokenize("count * price"), s_Types);
+  std::vector<double> out(s_Rows);
+
+  SECTION("wrong output type") {
+    std::vector<int64_t> wrong(s_Rows);
+    REQUIRE_THROWS(evaluateBatch(expr, table.columns(expr), s_Rows, wrong.data()));
+  }
+
+  SECTION("wrong column type") {
+    std::vector<Column> columns{ Column(table.price.data()), Column(table.price.data()) };
+    REQUIRE_THROWS(evaluateBatch(expr, columns, s_Rows, out.data()));
+  }
+
+  SECTION("missing column") {
+    std::vector<Column> columns{ Column(table.count.data()) };
+    REQUIRE_THROWS(evaluateBatch(expr, columns, s_Rows, out.data()));
+  }
+}
@@ -0,0 +1,124 @@
+#include "batch_kernels.h"
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+
+#include <bit>
+#include <limits>
+#include <random>
+#include <vector>
+
+using namespace std::literals;
+using namespace SYP;
+
+namespace {
+
+// not a multiple of any vector width so the padded tail gets used
+constexpr size_t s_Count = 61;
+
+enum class Data { Signed, Unsigned, Shift, Float, Mask };
+
+std::vector<uint64_t> generate(Data data, std::mt19937_64 &rng) {
+  std::uniform_int_distribution<int64_t> ints(-1000, 1000);
+  std::uniform_int_distribution<uint64_t> shifts(0, 63);
+  std::uniform_real_distribution<double> floats(-100.0, 100.0);
+  std::vector<uint64_t> result;
+  for (size_t i = 0; i < s_Count; ++i) {
+    switch (data) {
+    case Data::Signed: result.push_back(std::bit_cast<uint64_t>(i % 5 == 0 ? 0 : ints(rng))); break;
+    case Data::Unsigned: result.push_back(i % 5 == 0 ? 0 : static_cast<uint64_t>(ints(rng)) + 1000); break;
+    case Data::Shift: result.push_back(shifts(rng)); break;
+    case Data::Float: result.push_back(std::bit_cast<uint64_t>(i % 7 == 0 ? 1.0 : floats(rng))); break;
+    case Data::Mask: result.push_back(rng() % 2 == 0 ? 0 : ~uint64_t(0)); break;
+    }
+  }
+  return result;
+}
+
+}
+
+TEST_CASE("always provides scalar kernels", "[BatchKernels]") {
+  auto supported = supportedBatchKernels();
+
+  REQUIRE(supported.back()->name == "scalar"sv);
+  REQUIRE(&batchKernels() == supported.front());
+}
+
+TEST_CASE("vector kernels match the scalar ones", "[BatchKernels]") {
+  auto [code, data] = GENERATE(
+      std::make_pair(OpCode::AddI64, Data::Signed), std::make_pair(OpCode::SubI64, Data::Signed),
+      std::make_pair(OpCode::MulI64, Data::Signed), std::make_pair(OpCode::DivI64, Data::Signed),
+      std::make_pair(OpCode::LtI64, Data::Signed), std::make_pair(OpCode::GeI64, Data::Signed),
+      std::make_pair(OpCode::EqI64, Data::Signed), std::make_pair(OpCode::NeI64, Data::Signed),
+      std::make_pair(OpCode::AddU64, Data::Unsigned), std::make_pair(OpCode::MulU64, Data::Unsigned),
+      std::make_pair(OpCode::DivU64, Data::Unsigned), std::make_pair(OpCode::ModU64, Data::Unsigned),
+      std::make_pair(OpCode::LtU64, Data::Unsigned), std::make_pair(OpCode::GtU64, Data::Unsigned),
+      std::make_pair(OpCode::XorU64, Data::Unsigned), std::make_pair(OpCode::AndU64, Data::Unsigned),
+      std::make_pair(OpCode::OrU64, Data::Unsigned), std::make_pair(OpCode::ShlU64, Data::Shift),
+      std::make_pair(OpCode::ShrU64, Data::Shift), std::make_pair(OpCode::ShlI64, Data::Shift),
+      std::make_pair(OpCode::AddF64, Data::Float), std::make_pair(OpCode::SubF64, Data::Float),
+      std::make_pair(OpCode::MulF64, Data::Float), std::make_pair(OpCode::DivF64, Data::Float),
+      std::make_pair(OpCode::LeF64, Data::Float), std::make_pair(OpCode::GtF64, Data::Float),
+      std::make_pair(OpCode::EqF64, Data::Float), std::make_pair(OpCode::AndBool, Data::Mask),
+      std::make_pair(OpCode::OrBool, Data::Mask), std::make_pair(OpCode::EqBool, Data::Mask),
+      std::make_pair(OpCode::NeBool, Data::Mask));
+  std::mt19937_64 rng(static_cast<uint64_t>(code));
+  auto lhs = generate(data, rng);
+  auto rhs = generate(data, rng);
+
+  auto expected = lhs;
+  const auto &scalar = *supportedBatchKernels().back();
+  scalar.binary[static_cast<size_t>(code)](expected.data(), rhs.data(), s_Count);
+
+  for (const auto *kernels : supportedBatchKernels()) {
+    INFO(kernels->name);
+    auto result = lhs;
+    kernels->binary[static_cast<size_t>(code)](result.data(), rhs.data(), s_Count);
+    REQUIRE(result == expected);
+  }
+}
+
+TEST_CASE("vector unary kernels match the scalar ones", "[BatchKernels]") {
+  auto [code, data] = GENERATE(std::make_pair(OpCode::NotBool, Data::Mask),
+                               std::make_pair(OpCode::ConvI64ToF64, Data::Signed),
+                               std::make_pair(OpCode::ConvU64ToF64, Data::Unsigned),
+                               std::make_pair(OpCode::ConvIntToBool, Data::Signed));
+  std::mt19937_64 rng(static_cast<uint64_t>(code));
+  auto values = generate(data, rng);
+
+  auto expected = values;
+  supportedBatchKernels().back()->unary[static_cast<size_t>(code)](expected.data(), s_Count);
+
+  for (const auto *kernels : supportedBatchKernels()) {
+    INFO(kernels->name);
+    auto result = values;
+    kernels->unary[static_cast<size_t>(code)](result.data(), s_Count);
+    REQUIRE(result == expected);
+  }
+}
+
+TEST_CASE("comparisons produce masks and select blends", "[BatchKernels]") {
+  for (const auto *kernels : supportedBatchKernels()) {
+    INFO(kernels->name);
+    std::vector<uint64_t> lhs{ 1, 5, 3, 7, 2 };
+    std::vector<uint64_t> rhs{ 4, 4, 4, 4, 4 };
+    auto mask = lhs;
+    kernels->binary[static_cast<size_t>(OpCode::LtI64)](mask.data(), rhs.data(), lhs.size());
+    REQUIRE(mask == std::vector<uint64_t>{ ~0ull, 0, ~0ull, 0, ~0ull });
+
+    auto result = lhs;
+    kernels->select(result.data(), mask.data(), rhs.data(), lhs.size());
+    REQUIRE(result == std::vector<uint64_t>{ 1, 4, 3, 4, 2 });
+  }
+}
+
+TEST_CASE("integer division by zero doesn't trap", "[BatchKernels]") {
+  for (const auto *kernels : supportedBatchKernels()) {
+    INFO(kernels->name);
+    std::vector<uint64_t> lhs{ 10, 10, std::bit_cast<uint64_t>(std::numeric_limits<int64_t>::min()) };
+    std::vector<uint64_t> rhs{ 0, 5, std::bit_cast<uint64_t>(int64_t(-1)) };
+    auto result = lhs;
+    kernels->binary[static_cast<size_t>(OpCode::DivI64)](result.data(), rhs.data(), lhs.size());
+    REQUIRE(result == std::vector<uint64_t>{ 0, 2, 0 });
+  }
+}
@@ -0,0 +1,156 @@
+#include "bytecode.h"
+#include "evaluate.h"
+#include "shunting_yard.h"
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+
+#include <algorithm>
+
+using namespace std::literals;
+using namespace SYP;
+
+namespace {
+
+std::vector<OpCode> opcodes(const Program &program) {
+  std::vector<OpCode> result;
+  for (const auto &instruction : program.code) {
+    result.push_back(instruction.code());
+  }
+  return result;
+}
+
+// compile without constant folding so the instructions for literals are kept
+Program compileUnoptimized(const std::string &term) {
+  auto tree = buildTree(tokenize(term));
+  typeCheck(tree, {});
+  return compile(tree);
+}
+
+Token run(const Program &program, std::span<const Token> slots) {
+  Workspace workspace;
+  return execute(program, slots, workspace);
+}
+
+}
+
+TEST_CASE("emits typed instructions for known types", "[Bytecode]") {
+  auto program = compileUnoptimized("3 * 2 == 6");
+
+  REQUIRE(opcodes(program) == std::vector<OpCode>{ OpCode::LoadConst, OpCode::LoadConst, OpCode::MulI64,
+                                                   OpCode::LoadConst, OpCode::EqI64, OpCode::Return });
+  REQUIRE(program.stackSize == 2);
+  REQUIRE(run(program, {}).boolValue);
+}
+
+TEST_CASE("falls back to dynamic operators for variables", "[Bytecode]") {
+  auto program = compile(tokenize("3 * two == 6"));
+
+  REQUIRE(opcodes(program) == std::vector<OpCode>{ OpCode::LoadConst, OpCode::LoadSlot, OpCode::Operator,
+                                                   OpCode::LoadConst, OpCode::EqI64, OpCode::Return });
+  REQUIRE(program.slots == std::vector<std::string>{ "two" });
+
+  std::vector<Token> slots{ Token(2) };
+  REQUIRE(run(program, slots).boolValue);
+  slots[0] = Token(3);
+  REQUIRE_FALSE(run(program, slots).boolValue);
+}
+
+TEST_CASE("executes typed operators", "[Bytecode]") {
+  auto [term, expected] = GENERATE(std::make_pair("9 + 2 * -4", Token(1)),
+                                   std::make_pair("7.5 / 2.5", Token(3.0)),
+                                   std::make_pair("0xF0 >> 4", Token(uint64_t(15))),
+                                   std::make_pair("5 % 3", Token(uint64_t(2))),
+                                   std::make_pair("!(1 < 2) || 2.0 >= 1.5", Token(true)));
+  auto result = run(compileUnoptimized(term), {});
+
+  REQUIRE(result.type == expected.type);
+  REQUIRE(toResult(result) == toResult(expected));
+}
+
+TEST_CASE("skips the right operand of logical operators", "[Bytecode]") {
+  SymbolTable symbols;
+  int calls = 0;
+  symbols.registerFunction("lookup", [&calls](const std::vector<Token> &) {
+    ++calls;
+    return Token(true);
+  });
+
+  auto [term, flag, expected, expectedCalls] = GENERATE(std::make_tuple("flag && lookup(1)", false, false, 0),
+                                                        std::make_tuple("flag && lookup(1)", true, true, 1),
+                                                        std::make_tuple("flag || lookup(1)", true, true, 0),
+                                                        std::make_tuple("flag || lookup(1)", false, true, 1));
+  auto program = compile(tokenize(term, symbols), { { "flag", TokenType::Boolean } });
+  std::vector<Token> slots{ Token(flag), Token("lookup", TokenType::Function, symbols) };
+  auto result = run(program, slots);
+
+  REQUIRE(result.type == TokenType::Boolean);
+  REQUIRE(result.boolValue == expected);
+  REQUIRE(calls == expectedCalls);
+}
+
+TEST_CASE("evaluates only the selected branch", "[Bytecode]") {
+  SymbolTable symbols;
+  int calls = 0;
+  symbols.registerFunction("lookup", [&calls](const std::vector<Token> &args) {
+    ++calls;
+    return args[0];
+  });
+
+  auto program = compile(tokenize("flag ? lookup(1) : lookup(2)", symbols));
+  REQUIRE(std::find_if(program.code.begin(), program.code.end(), [](const Instruction &instruction) {
+            return instruction.code() == OpCode::JumpIfFalse;
+          }) != program.code.end());
+
+  std::vector<Token> slots{ Token(false), Token("lookup", TokenType::Function, symbols) };
+  REQUIRE(toResult(run(program, slots)) == Result(int64_t(2)));
+  REQUIRE(calls == 1);
+  slots[0] = Token(true);
+  REQUIRE(toResult(run(program, slots)) == Result(int64_t(1)));
+  REQUIRE(calls == 2);
+}
+
+TEST_CASE("calls functions with the arguments on the stack", "[Bytecode]") {
+  SymbolTable symbols;
+  symbols.registerFunction("pick", [](FunctionArgs args) { return args[args[0].signedValue]; });
+
+  auto program = compileUnoptimized("pick(2, 10, 20) + pick(1, 30)");
+  auto calls = std::count_if(program.code.begin(), program.code.end(), [](const Instruction &instruction) {
+    return instruction.code() == OpCode::Call;
+  });
+  REQUIRE(calls == 2);
+  REQUIRE(std::find_if(program.code.begin(), program.code.end(), [](const Instruction &instruction) {
+            return (instruction.code() == OpCode::Call) && (instruction.operand() == 3);
+          }) != program.code.end());
+
+  std::vector<Token> slots{ Token("pick", TokenType::Function, symbols) };
+  REQUIRE(toResult(run(program, slots)) == Result(int64_t(50)));
+}
+
+TEST_CASE("converts dynamic logical operands to booleans", "[Bytecode]") {
+  auto [lhs, rhs, expected] = GENERATE(std::make_tuple(Token(0), Token(5), false),
+                                       std::make_tuple(Token(uint64_t(3)), Token(true), true),
+                                       std::make_tuple(Token(true), Token(0), false));
+  auto program = compile(tokenize("lhs && rhs"));
+  std::vector<Token> slots{ lhs, rhs };
+  auto result = run(program, slots);
+
+  REQUIRE(result.type == TokenType::Boolean);
+  REQUIRE(result.boolValue == expected);
+  REQUIRE_THROWS(run(program, std::vector<Token>{ Token(1.5), Token(true) }));
+}
+
+TEST_CASE("packs opcode and operand into one word", "[Bytecode]") {
+  Instruction instruction(OpCode::JumpIfFalse, Instruction::s_MaxOperand);
+  REQUIRE(instruction.code() == OpCode::JumpIfFalse);
+  REQUIRE(instruction.operand() == Instruction::s_MaxOperand);
+
+  instruction.setOperand(42);
+  REQUIRE(instruction.code() == OpCode::JumpIfFalse);
+  REQUIRE(instruction.operand() == 42);
+  REQUIRE_THROWS(instruction.setOperand(Instruction::s_MaxOperand + 1));
+
+  auto program = compile(tokenize("a * 2 + b"), { { "a", TokenType::Signed }, { "b", TokenType::Signed } });
+  REQUIRE(program.code.capacity() == program.code.size());
+  REQUIRE(program.constants.capacity() == program.constants.size());
+}
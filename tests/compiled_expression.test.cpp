@@ -0,0 +1,68 @@
+#include "compiled_expression.h"
+#include "shunting_yard.h"
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+
+using namespace std::literals;
+using namespace SYP;
+
+namespace {
+
+Token strlenFunc(const std::vector<Token> &input) {
+  return Token{ input.at(0).getVariableName().length() };
+}
+
+Token compiledVariables(const std::string &variable) {
+  if (variable == "two") {
+    return Token(2);
+  } else if (variable == "three") {
+    return Token(3);
+  } else if (variable == "length") {
+    return Token{ "length", strlenFunc };
+  }
+
+  throw std::runtime_error("unexpected variable name");
+}
+
+}
+
+TEST_CASE("lists referenced variables once", "[CompiledExpression]") {
+  CompiledExpression expr(tokenize("two * three + two"));
+
+  REQUIRE(expr.slotCount() == 2);
+  REQUIRE(expr.variables()[0] == "two");
+  REQUIRE(expr.variables()[1] == "three");
+  REQUIRE(expr.slotOf("three") == 1);
+  REQUIRE(expr.slotOf("four") == CompiledExpression::npos);
+}
+
+TEST_CASE("evaluates against bound slots", "[CompiledExpression]") {
+  CompiledExpression expr(tokenize("two * three + two"));
+
+  std::vector<Token> slots{ Token(2), Token(3) };
+  REQUIRE(std::get<int64_t>(expr.evaluate(slots)) == 8);
+
+  slots[expr.slotOf("three")] = Token(10);
+  REQUIRE(std::get<int64_t>(expr.evaluate(slots)) == 22);
+}
+
+TEST_CASE("matches evaluate for integration terms", "[CompiledExpression]") {
+  auto term = GENERATE("two + 3 == 5", "(two + 4) / 2 == 3", "!(two == 2) || three == 3",
+                       "(two == 2) ? (21 * 2) : (22 * 30 + 6)", "length(\"foo\" + \"bar\")",
+                       "two * length(\"foobar\", \"foo\") + 1");
+  auto tokens = tokenize(term);
+  CompiledExpression expr(tokens);
+  auto slots = expr.bind(compiledVariables);
+
+  REQUIRE(expr.evaluate(slots) == evaluate(tokens, compiledVariables));
+}
+
+TEST_CASE("rejects malformed terms", "[CompiledExpression]") {
+  std::vector<Token> tokens{ Token(1), Token(OperatorType::Add) };
+  REQUIRE_THROWS(CompiledExpression(tokens));
+
+  CompiledExpression expr(tokenize("two + three"));
+  std::vector<Token> slots{ Token(2) };
+  REQUIRE_THROWS(expr.evaluate(slots));
+}
@@ -0,0 +1,141 @@
+#include "batch.h"
+#include "compiled_expression.h"
+#include "evaluate.h"
+#include "shunting_yard.h"
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std::literals;
+using namespace SYP;
+
+namespace {
+
+constexpr int s_Iterations = 20000;
+
+unsigned threadCount() {
+  return std::clamp(std::thread::hardware_concurrency(), 4u, 16u);
+}
+
+/**
+ * run the function on all threads at once, returns the number of failed checks
+ */
+int runConcurrently(const std::function<bool(unsigned thread, int iteration)> &check) {
+  std::atomic<int> failures{0};
+  std::atomic<bool> start{false};
+  std::vector<std::thread> threads;
+  for (unsigned t = 0; t < threadCount(); ++t) {
+    threads.emplace_back([&, t]() {
+      while (!start) {
+        std::this_thread::yield();
+      }
+      for (int i = 0; i < s_Iterations; ++i) {
+        try {
+          if (!check(t, i)) {
+            ++failures;
+          }
+        } catch (const std::exception &) {
+          ++failures;
+        }
+      }
+    });
+  }
+  start = true;
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  return failures;
+}
+
+Token label(FunctionArgs args) {
+  return args[0].signedValue % 2 == 0 ? Token("even") : Token("odd");
+}
+
+}
+
+TEST_CASE("evaluates one compiled expression from many threads", "[Concurrency]") {
+  SymbolTable symbols;
+  symbols.registerFunction("label", label);
+  auto types = GENERATE(VariableTypes{}, VariableTypes{ { "x", TokenType::Signed }, { "y", TokenType::Signed } });
+
+  const CompiledExpression expr(tokenize("x > y ? label(x) + \"-\" + label(y) : \"none\"", symbols), types);
+
+  auto failures = runConcurrently([&expr, &symbols](unsigned thread, int iteration) {
+    int64_t x = iteration;
+    int64_t y = static_cast<int64_t>(thread);
+    std::vector<Token> slots{ Token(x), Token(y), Token("label", TokenType::Function, symbols) };
+    std::string expected = x <= y ? "none"
+                                  : std::string(x % 2 == 0 ? "even" : "odd") + "-" + (y % 2 == 0 ? "even" : "odd");
+    return std::get<std::string>(expr.evaluate(slots)) == expected;
+  });
+
+  REQUIRE(failures == 0);
+}
+
+TEST_CASE("evaluates with per thread workspaces", "[Concurrency]") {
+  const CompiledExpression expr(tokenize("(a * 3 + b) % 7"), { { "a", TokenType::Unsigned }, { "b", TokenType::Unsigned } });
+
+  auto failures = runConcurrently([&expr](unsigned thread, int iteration) {
+    thread_local Workspace workspace;
+    auto a = static_cast<uint64_t>(iteration);
+    auto b = static_cast<uint64_t>(thread);
+    std::vector<Token> slots{ Token(a), Token(b) };
+    return std::get<uint64_t>(expr.evaluate(slots, workspace)) == (a * 3 + b) % 7;
+  });
+
+  REQUIRE(failures == 0);
+}
+
+TEST_CASE("interprets one token queue from many threads", "[Concurrency]") {
+  SymbolTable symbols;
+  const auto tokens = tokenize("twice(value) + 1", symbols);
+
+  auto failures = runConcurrently([&tokens, &symbols](unsigned thread, int iteration) {
+    int64_t value = iteration + static_cast<int64_t>(thread);
+    auto resolve = [&symbols, value](const std::string &name) {
+      // constructs the function token on every evaluation, after the first registration this
+      // must neither change the entry nor block other threads
+      return name == "value" ? Token(value)
+                             : Token(name, [](FunctionArgs args) { return Token(args[0].signedValue * 2); }, symbols);
+    };
+    return std::get<int64_t>(evaluate(tokens, resolve)) == value * 2 + 1;
+  });
+
+  REQUIRE(failures == 0);
+  REQUIRE(symbols.functionCount() == 1);
+}
+
+TEST_CASE("evaluates batches of one expression from many threads", "[Concurrency]") {
+  const CompiledExpression expr(tokenize("count * 2 > limit"), { { "count", TokenType::Signed }, { "limit", TokenType::Signed } });
+  constexpr size_t rows = 300;
+  std::vector<int64_t> counts(rows);
+  std::vector<int64_t> limits(rows, 250);
+  for (size_t i = 0; i < rows; ++i) {
+    counts[i] = static_cast<int64_t>(i);
+  }
+  std::vector<Column> columns{ Column(counts.data()), Column(limits.data()) };
+
+  auto failures = runConcurrently([&](unsigned, int iteration) {
+    if (iteration % 20 != 0) {
+      return true;
+    }
+    std::unique_ptr<bool[]> out(new bool[rows]);
+    evaluateBatch(expr, columns, rows, OutputColumn(out.get()));
+    for (size_t i = 0; i < rows; ++i) {
+      if (out[i] != (counts[i] * 2 > 250)) {
+        return false;
+      }
+    }
+    return true;
+  });
+
+  REQUIRE(failures == 0);
+}
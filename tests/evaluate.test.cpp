@@ -1,6 +1,9 @@
 #include <catch2/catch_test_macros.hpp>
 
 #include "evaluate.h"
+#include "trace.h"
+
+#include <tuple>
 
 using namespace std::literals;
 using namespace SYP;
@@ -94,3 +97,47 @@ TEST_CASE("Performance", "[Evalute]") {
   }
 }
 
+
+TEST_CASE("DoesNotInternRuntimeStrings", "[Evalute]") {
+  std::vector<Token> tokens {
+    Token{ "foo" },
+    Token{ "bar" },
+    Token{ OperatorType::Add },
+    Token{ "baz" },
+    Token{ OperatorType::Add },
+  };
+
+  auto known = SymbolTable::defaultTable().variableCount();
+  for (int i = 0; i < 100; i++) {
+    REQUIRE(std::get<std::string>(evaluate(tokens)) == "foobarbaz");
+  }
+  REQUIRE(SymbolTable::defaultTable().variableCount() == known);
+  REQUIRE(SymbolTable::defaultTable().findVariable("foobarbaz") == nullptr);
+}
+
+#ifdef PAGAN_EXPR_TRACE
+TEST_CASE("ReportsOperationsToObserver", "[Evalute]") {
+  struct Recorder : EvalObserver {
+    std::vector<std::tuple<OperatorType, size_t, std::string>> calls;
+    void onOperation(OperatorType op, std::span<const Token> operands, const Token &result) override {
+      calls.emplace_back(op, operands.size(), toString(result));
+    }
+  } recorder;
+
+  std::vector<Token> tokens {
+    Token(1),
+    Token(2),
+    Token(OperatorType::Add),
+    Token(3),
+    Token(OperatorType::Multiply),
+  };
+
+  setEvalObserver(&recorder);
+  REQUIRE(std::get<int64_t>(evaluate(tokens)) == 9);
+  setEvalObserver(nullptr);
+
+  REQUIRE(recorder.calls.size() == 2);
+  REQUIRE(recorder.calls[0] == std::make_tuple(OperatorType::Add, size_t(2), "3"s));
+  REQUIRE(recorder.calls[1] == std::make_tuple(OperatorType::Multiply, size_t(2), "9"s));
+}
+#endif
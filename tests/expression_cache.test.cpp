@@ -0,0 +1,154 @@
+#include "expression_cache.h"
+#include "evaluate.h"
+#include "shunting_yard.h"
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <format>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std::literals;
+using namespace SYP;
+
+namespace {
+
+Token resolveVariable(const std::string &name) {
+  if (name == "a") {
+    return Token(int64_t(7));
+  } else if (name == "b") {
+    return Token(int64_t(3));
+  }
+  return Token(int64_t(-2));
+}
+
+}
+
+TEST_CASE("normalizes expression text", "[ExpressionCache]") {
+  auto [input, expected] = GENERATE(table<std::string, std::string>({
+    { "a + b", "a+b" },
+    { "  a\t+\n b ", "a+b" },
+    { "(a + b)", "a+b" },
+    { "((a + b)) * c", "(a+b)*c" },
+    { "(a) * (3)", "a*3" },
+    { "a * ((b + c))", "a*(b+c)" },
+    { "(a + b) * (b - c)", "(a+b)*(b-c)" },
+    { "a and b", "a and b" },
+    { "(a)and(b)", "a and b" },
+    { "a < = b", "a< =b" },
+    { "a - -2", "a- -2" },
+    { "- 2", "- 2" },
+    { "-(2)", "- 2" },
+    { "1e -2", "1e -2" },
+    { "name == \"a  b\"", "name==\"a  b\"" },
+    { "f (x, y)", "f(x y)" },
+    { "f((x))", "f(x)" },
+    { "(f) (x)", "f x" },
+    { "f\t(x)", "f x" },
+    { "f\t(x, y)", "f,(x y)" },
+    { "(a", "(a" },
+  }));
+  INFO(input);
+  REQUIRE(ExpressionCache::normalize(input) == expected);
+}
+
+TEST_CASE("normalized text means the same", "[ExpressionCache]") {
+  auto input = GENERATE("((a + b)) * c"s, "(a) * (3) - (b)"s, "a - -2"s, "(b)+(a) - 2"s, "(a)and(b)"s,
+                        "!(a > b) || ((c)) == -2"s, "(a > b) ? (a) : ((b))"s, "a << (1 + (b))"s);
+  INFO(input);
+  auto normalized = ExpressionCache::normalize(input);
+  REQUIRE(evaluate(tokenize(normalized), resolveVariable) == evaluate(tokenize(input), resolveVariable));
+}
+
+TEST_CASE("returns cached expressions", "[ExpressionCache]") {
+  ExpressionCache cache(16);
+
+  auto first = cache.get("a * 2 + 1");
+  auto second = cache.get("(a*2) + 1");
+  auto third = cache.get("(a * 2 + 1)");
+  REQUIRE(first.get() != second.get());
+  REQUIRE(first.get() == third.get());
+
+  auto stats = cache.statistics();
+  REQUIRE(stats.hits == 1);
+  REQUIRE(stats.misses == 2);
+  REQUIRE(stats.evictions == 0);
+  REQUIRE(stats.size == 2);
+
+  std::vector<Token> slots{ Token(int64_t(4)) };
+  REQUIRE(std::get<int64_t>(third->evaluate(slots)) == 9);
+}
+
+TEST_CASE("declared types are part of the key", "[ExpressionCache]") {
+  ExpressionCache cache(16);
+  auto untyped = cache.get("a + 1");
+  auto typed = cache.get("a + 1", { { "a", TokenType::Signed } });
+  REQUIRE(untyped.get() != typed.get());
+  REQUIRE(typed->resultType() == TokenType::Signed);
+  REQUIRE(cache.get("a+1", { { "a", TokenType::Signed } }).get() == typed.get());
+}
+
+TEST_CASE("evicts least recently used expressions", "[ExpressionCache]") {
+  ExpressionCache cache(3, SymbolTable::defaultTable(), 1);
+  auto one = cache.get("a + 1");
+  auto two = cache.get("a + 2");
+  auto three = cache.get("a + 3");
+  // makes "a + 2" the least recently used
+  REQUIRE(cache.get("a+1").get() == one.get());
+  auto four = cache.get("a + 4");
+  REQUIRE(four.get() != three.get());
+
+  auto stats = cache.statistics();
+  REQUIRE(stats.evictions == 1);
+  REQUIRE(stats.size == 3);
+
+  REQUIRE(cache.get("a + 1").get() == one.get());
+  REQUIRE(cache.statistics().misses == 4);
+  REQUIRE(cache.get("a + 2").get() != two.get());
+  REQUIRE(cache.statistics().misses == 5);
+
+  // evicted expressions stay usable
+  cache.clear();
+  REQUIRE(cache.statistics().size == 0);
+  std::vector<Token> slots{ Token(int64_t(1)) };
+  REQUIRE(std::get<int64_t>(one->evaluate(slots)) == 2);
+}
+
+TEST_CASE("doesn't cache invalid expressions", "[ExpressionCache]") {
+  ExpressionCache cache(16);
+  REQUIRE_THROWS(cache.get("\"unterminated"));
+  REQUIRE_THROWS(cache.get("a +", { { "a", TokenType::Boolean } }));
+  REQUIRE(cache.statistics().size == 0);
+}
+
+TEST_CASE("can be used from multiple threads", "[ExpressionCache]") {
+  ExpressionCache cache(32, SymbolTable::defaultTable(), 4);
+  std::atomic<int> failures{0};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 8; ++t) {
+    threads.emplace_back([&, t]() {
+      for (int i = 0; i < 2000; ++i) {
+        // more distinct expressions than fit into the cache so there are evictions too
+        int value = (i * 7 + t) % 48;
+        auto expr = cache.get(std::format("a * {} + {}", value, t % 2));
+        std::vector<Token> slots{ Token(int64_t(2)) };
+        if (std::get<int64_t>(expr->evaluate(slots)) != 2 * value + t % 2) {
+          ++failures;
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  REQUIRE(failures == 0);
+  auto stats = cache.statistics();
+  REQUIRE(stats.hits + stats.misses == 16000);
+  REQUIRE(stats.size <= 32);
+  REQUIRE(stats.evictions > 0);
+}
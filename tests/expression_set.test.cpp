@@ -0,0 +1,145 @@
+#include "compiled_expression.h"
+#include "expression_set.h"
+#include "native_function.h"
+#include "shunting_yard.h"
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+
+#include <cstdint>
+#include <format>
+#include <string>
+#include <vector>
+
+using namespace std::literals;
+using namespace SYP;
+
+namespace {
+
+int s_Calls = 0;
+
+int64_t costly(int64_t value) {
+  ++s_Calls;
+  return value * 10;
+}
+
+SymbolTable &setSymbols() {
+  static SymbolTable s_Symbols;
+  static bool s_Registered = [] {
+    s_Symbols.registerFunction("costly", &costly, true);
+    s_Symbols.registerFunction("costly_impure", &costly);
+    return true;
+  }();
+  (void)s_Registered;
+  return s_Symbols;
+}
+
+std::vector<TokenQueue> tokenizeAll(const std::vector<std::string> &terms) {
+  std::vector<TokenQueue> result;
+  for (const auto &term : terms) {
+    result.push_back(tokenize(term, setSymbols()));
+  }
+  return result;
+}
+
+Token resolve(const std::string &name, int64_t price) {
+  if (name == "price") {
+    return Token(price);
+  } else if (name == "qty") {
+    return Token(int64_t(3));
+  } else if (name == "name") {
+    return Token("pagan");
+  }
+  return Token(name, TokenType::Function, setSymbols());
+}
+
+}
+
+TEST_CASE("evaluates like the individual expressions", "[ExpressionSet]") {
+  std::vector<std::string> terms{
+    "price * qty > 100",
+    "price * qty < 10 || price * qty == 42",
+    "(price * qty) * 2 + costly(price)",
+    "costly(price) > 50 ? price * qty : qty",
+    "name + \".expr\"",
+    "name + \".expr\" + name",
+  };
+  auto types = GENERATE(VariableTypes{}, VariableTypes{ { "price", TokenType::Signed }, { "qty", TokenType::Signed } });
+  auto price = GENERATE(int64_t(1), int64_t(14), int64_t(40));
+
+  ExpressionSet set(tokenizeAll(terms), types);
+  REQUIRE(set.size() == terms.size());
+  auto results = set.evaluate(set.bind([price](const std::string &name) { return resolve(name, price); }));
+
+  for (size_t i = 0; i < terms.size(); ++i) {
+    INFO(std::format("{} with price {}", terms[i], price));
+    CompiledExpression expr(tokenize(terms[i], setSymbols()), types);
+    REQUIRE(results[i] == expr.evaluate(expr.bind([price](const std::string &name) { return resolve(name, price); })));
+    REQUIRE(set.resultType(i) == expr.resultType());
+  }
+}
+
+TEST_CASE("merges common sub-expressions", "[ExpressionSet]") {
+  ExpressionSet set(tokenizeAll({ "price * qty > 100", "(price * qty) * 2", "qty * price" }));
+  // qty * price is a different expression as far as the set is concerned
+  REQUIRE(set.sharedCount() == 1);
+  REQUIRE(set.variables() == std::vector<std::string>{ "price", "qty" });
+  REQUIRE(set.slotOf("qty") == 1);
+  REQUIRE(set.slotOf("missing") == ExpressionSet::npos);
+
+  ExpressionSet separate(tokenizeAll({ "price * qty", "price + qty" }));
+  REQUIRE(separate.sharedCount() == 0);
+}
+
+TEST_CASE("computes shared sub-expressions once", "[ExpressionSet]") {
+  auto evaluateWith = [](const ExpressionSet &set, int64_t price) {
+    s_Calls = 0;
+    auto results = set.evaluate(set.bind([price](const std::string &name) { return resolve(name, price); }));
+    return results;
+  };
+
+  SECTION("pure functions") {
+    ExpressionSet set(tokenizeAll({ "costly(price) + 1", "costly(price) * 2", "costly(price) > 30" }));
+    auto results = evaluateWith(set, 4);
+    REQUIRE(s_Calls == 1);
+    REQUIRE(std::get<int64_t>(results[0]) == 41);
+    REQUIRE(std::get<int64_t>(results[1]) == 80);
+    REQUIRE(std::get<bool>(results[2]));
+  }
+
+  SECTION("within one expression") {
+    ExpressionSet set(tokenizeAll({ "costly(price) + costly(price)" }));
+    REQUIRE(std::get<int64_t>(evaluateWith(set, 2)[0]) == 40);
+    REQUIRE(s_Calls == 1);
+  }
+
+  SECTION("impure functions") {
+    ExpressionSet set(tokenizeAll({ "costly_impure(price) + 1", "costly_impure(price) * 2" }));
+    REQUIRE(set.sharedCount() == 0);
+    (void)evaluateWith(set, 4);
+    REQUIRE(s_Calls == 2);
+  }
+
+  SECTION("uses in branches") {
+    ExpressionSet set(tokenizeAll({ "price > 5 ? costly(price) : 0", "price > 10 ? costly(price) + 1 : 1" }));
+    REQUIRE(std::get<int64_t>(evaluateWith(set, 2)[0]) == 0);
+    REQUIRE(s_Calls == 0);
+    REQUIRE(std::get<int64_t>(evaluateWith(set, 7)[0]) == 70);
+    REQUIRE(s_Calls == 1);
+    auto results = evaluateWith(set, 12);
+    REQUIRE(std::get<int64_t>(results[1]) == 121);
+    REQUIRE(s_Calls == 1);
+  }
+}
+
+TEST_CASE("reports invalid expression sets", "[ExpressionSet]") {
+  REQUIRE_THROWS(ExpressionSet(tokenizeAll({ "costly + 1", "costly(price)" })));
+  REQUIRE_THROWS(ExpressionSet(tokenizeAll({ "price + 1", "flag * 2" }), { { "flag", TokenType::Boolean } }));
+
+  ExpressionSet set(tokenizeAll({ "price + 1", "qty" }));
+  std::vector<Token> slots{ Token(int64_t(1)) };
+  REQUIRE_THROWS(set.evaluate(slots));
+  std::vector<Result> results(1);
+  slots.push_back(Token(int64_t(2)));
+  REQUIRE_THROWS(set.evaluate(slots, results));
+}
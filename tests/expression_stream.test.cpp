@@ -0,0 +1,84 @@
+#include "compiled_expression.h"
+#include "expression_stream.h"
+#include "shunting_yard.h"
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+
+#include <cstdint>
+#include <format>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace std::literals;
+using namespace SYP;
+
+namespace {
+
+const std::unordered_map<std::string, Token> s_Values{
+  { "a", Token(int64_t(7)) }, { "b", Token(int64_t(-3)) }, { "x", Token(2.5) }, { "name", Token("pagan") },
+};
+
+Token resolve(const std::string &name) {
+  return s_Values.at(name);
+}
+
+}
+
+TEST_CASE("compiles statements of a chunked script", "[ExpressionStream]") {
+  const std::vector<std::string> terms{
+    "a * 2 + b", "x * 1e2 - a", "name + \"; not the end\"", "(a > b) && (x < 3.0)", "b << 2",
+  };
+  VariableTypes types{ { "a", TokenType::Signed }, { "x", TokenType::Float } };
+  std::string script;
+  for (const auto &term : terms) {
+    script += std::format("{};\n", term);
+  }
+
+  std::vector<CompiledExpression> compiled;
+  ExpressionStream stream([&compiled](CompiledExpression &&expression) { compiled.push_back(std::move(expression)); },
+                          types);
+  std::istringstream in(script);
+  // 0 gets treated as 1
+  stream.read(in, GENERATE(0, 1, 7, 4096));
+
+  REQUIRE(stream.statementCount() == terms.size());
+  REQUIRE(compiled.size() == terms.size());
+  for (size_t i = 0; i < terms.size(); ++i) {
+    INFO(terms[i]);
+    CompiledExpression expected(tokenize(terms[i]), types);
+    REQUIRE(compiled[i].resultType() == expected.resultType());
+    REQUIRE(compiled[i].evaluate(compiled[i].bind(resolve)) == expected.evaluate(expected.bind(resolve)));
+  }
+}
+
+TEST_CASE("passes on expressions before the script ends", "[ExpressionStream]") {
+  std::vector<CompiledExpression> compiled;
+  ExpressionStream stream([&compiled](CompiledExpression &&expression) { compiled.push_back(std::move(expression)); });
+
+  stream.feed("1 + 2; 3 *");
+  REQUIRE(compiled.size() == 1);
+  REQUIRE(compiled[0].evaluate({}) == Result(int64_t(3)));
+  stream.feed(" 4");
+  REQUIRE(compiled.size() == 1);
+  stream.finish();
+  REQUIRE(compiled.size() == 2);
+  REQUIRE(compiled[1].evaluate({}) == Result(int64_t(12)));
+}
+
+TEST_CASE("reports the statement that failed to compile", "[ExpressionStream]") {
+  int count = 0;
+  ExpressionStream stream([&count](CompiledExpression &&) { ++count; }, { { "a", TokenType::Signed } });
+
+  REQUIRE_THROWS(stream.feed("a + 1; a + \"text\"; a * 2;"));
+  REQUIRE(count == 1);
+  REQUIRE(stream.statementCount() == 1);
+
+  stream.reset();
+  REQUIRE(stream.statementCount() == 0);
+  stream.feed("a * 3;");
+  REQUIRE(count == 2);
+  REQUIRE(stream.statementCount() == 1);
+}
@@ -0,0 +1,171 @@
+#include "compiled_expression.h"
+#include "incremental_engine.h"
+#include "native_function.h"
+#include "shunting_yard.h"
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+
+#include <cstdint>
+#include <format>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace std::literals;
+using namespace SYP;
+
+namespace {
+
+int s_Calls = 0;
+
+int64_t expensive(int64_t value) {
+  ++s_Calls;
+  return value * 100;
+}
+
+SymbolTable &engineSymbols() {
+  static SymbolTable s_Symbols;
+  static bool s_Registered = [] {
+    s_Symbols.registerFunction("expensive", &expensive, true);
+    return true;
+  }();
+  (void)s_Registered;
+  return s_Symbols;
+}
+
+std::vector<TokenQueue> tokenizeAll(const std::vector<std::string> &terms) {
+  std::vector<TokenQueue> result;
+  for (const auto &term : terms) {
+    result.push_back(tokenize(term, engineSymbols()));
+  }
+  return result;
+}
+
+}
+
+TEST_CASE("keeps results up to date", "[IncrementalEngine]") {
+  std::vector<std::string> rules{
+    "price * qty > 100",
+    "(price * qty - discount) * 2",
+    "expensive(qty) + price",
+    "flag ? price : discount",
+    "name + \"-\" + name",
+    "label + name",
+  };
+  auto types = GENERATE(VariableTypes{},
+                        VariableTypes{ { "price", TokenType::Signed }, { "qty", TokenType::Signed },
+                                       { "discount", TokenType::Signed }, { "flag", TokenType::Boolean },
+                                       { "name", TokenType::String }, { "label", TokenType::String } });
+
+  IncrementalEngine engine(tokenizeAll(rules), types);
+  std::vector<CompiledExpression> reference;
+  for (const auto &rule : rules) {
+    reference.emplace_back(tokenize(rule, engineSymbols()), types);
+  }
+
+  std::unordered_map<std::string, Token> values{
+    { "price", Token(int64_t(10)) }, { "qty", Token(int64_t(3)) }, { "discount", Token(int64_t(4)) },
+    { "flag", Token(true) }, { "name", Token("a") }, { "label", Token("a-") },
+  };
+  for (const auto &[name, value] : values) {
+    REQUIRE(engine.set(name, value));
+  }
+  REQUIRE(engine.update().size() == rules.size());
+
+  std::mt19937 random(42);
+  const std::vector<std::string> names{ "price", "qty", "discount", "flag", "name", "label" };
+  const std::vector<Token> strings{ Token("a"), Token("b"), Token("a-"), Token("b-") };
+  for (int step = 0; step < 200; ++step) {
+    const auto &name = names[random() % names.size()];
+    Token value;
+    if (name == "flag") {
+      value = Token(random() % 2 == 0);
+    } else if ((name == "name") || (name == "label")) {
+      value = strings[random() % strings.size()];
+    } else {
+      value = Token(static_cast<int64_t>(random() % 20));
+    }
+    values[name] = value;
+    engine.set(name, value);
+
+    std::vector<Result> before;
+    for (size_t i = 0; i < rules.size(); ++i) {
+      before.push_back(*engine.result(i));
+    }
+    const auto &changed = engine.update();
+
+    for (size_t i = 0; i < rules.size(); ++i) {
+      INFO(std::format("step {} rule {}", step, rules[i]));
+      auto expected = reference[i].evaluate(reference[i].bind([&values](const std::string &var) {
+        auto iter = values.find(var);
+        return iter != values.end() ? iter->second : Token(var, TokenType::Function, engineSymbols());
+      }));
+      REQUIRE(*engine.result(i) == expected);
+      bool reported = std::find(changed.begin(), changed.end(), i) != changed.end();
+      REQUIRE(reported == (before[i] != expected));
+    }
+  }
+}
+
+TEST_CASE("only evaluates what a change invalidates", "[IncrementalEngine]") {
+  IncrementalEngine engine(tokenizeAll({ "expensive(a) + b", "expensive(a) * 2 > c", "c > 3" }));
+  // expensive(a) and expensive(a) * 2 read fewer variables than the expressions using them
+  REQUIRE(engine.memoCount() == 2);
+  engine.set("a", Token(int64_t(2)));
+  engine.set("b", Token(int64_t(1)));
+  engine.set("c", Token(int64_t(5)));
+
+  s_Calls = 0;
+  REQUIRE(engine.update() == std::vector<size_t>{ 0, 1, 2 });
+  REQUIRE(s_Calls == 1);
+  REQUIRE(std::get<int64_t>(*engine.result(0)) == 201);
+
+  // expensive(a) doesn't read b and keeps its value
+  s_Calls = 0;
+  engine.set("b", Token(int64_t(7)));
+  REQUIRE(engine.update() == std::vector<size_t>{ 0 });
+  REQUIRE(s_Calls == 0);
+  REQUIRE(std::get<int64_t>(*engine.result(0)) == 207);
+
+  // evaluated again but with the same result
+  engine.set("c", Token(int64_t(4)));
+  REQUIRE(engine.update().empty());
+  REQUIRE(s_Calls == 0);
+
+  engine.set("a", Token(int64_t(0)));
+  REQUIRE(engine.update() == std::vector<size_t>{ 0, 1 });
+  REQUIRE(s_Calls == 1);
+
+  REQUIRE(engine.update().empty());
+}
+
+TEST_CASE("waits for variables to be set", "[IncrementalEngine]") {
+  IncrementalEngine engine(tokenizeAll({ "a + 1", "a + b" }));
+  REQUIRE(engine.update().empty());
+  REQUIRE(engine.result(0) == nullptr);
+
+  engine.set("a", Token(int64_t(1)));
+  REQUIRE(engine.update() == std::vector<size_t>{ 0 });
+  REQUIRE(engine.result(1) == nullptr);
+
+  engine.set("b", Token(int64_t(1)));
+  REQUIRE(engine.update() == std::vector<size_t>{ 1 });
+  REQUIRE(std::get<int64_t>(*engine.result(1)) == 2);
+}
+
+TEST_CASE("reports invalid changes", "[IncrementalEngine]") {
+  IncrementalEngine engine(tokenizeAll({ "expensive(b) + a", "a * 2" }), { { "a", TokenType::Signed } });
+  REQUIRE_FALSE(engine.set("unknown", Token(int64_t(1))));
+  REQUIRE_THROWS(engine.set("a", Token(1.5)));
+  REQUIRE_THROWS(engine.set("expensive", Token(int64_t(1))));
+
+  // failing rules are evaluated again on the next update
+  engine.set("a", Token(int64_t(1)));
+  engine.set("b", Token("text"));
+  REQUIRE_THROWS(engine.update());
+  engine.set("b", Token(int64_t(2)));
+  REQUIRE(engine.update() == std::vector<size_t>{ 0, 1 });
+  REQUIRE(std::get<int64_t>(*engine.result(0)) == 201);
+}
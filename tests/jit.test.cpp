@@ -0,0 +1,193 @@
+#include "evaluate.h"
+#include "jit.h"
+#include "shunting_yard.h"
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+
+#include <cmath>
+#include <cstdint>
+#include <format>
+#include <random>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+using namespace std::literals;
+using namespace SYP;
+
+namespace {
+
+const VariableTypes s_Types{
+  { "a", TokenType::Signed }, { "b", TokenType::Signed }, { "x", TokenType::Float },
+  { "y", TokenType::Float },  { "p", TokenType::Boolean }, { "q", TokenType::Boolean },
+};
+
+/**
+ * random well typed terms of the operations the jit translates
+ */
+class TermGenerator {
+public:
+  explicit TermGenerator(uint32_t seed) : m_Random(seed) {}
+
+  std::string integer(int depth) {
+    if ((depth == 0) || (pick(4) == 0)) {
+      return pick(2) == 0 ? std::to_string(pick(10)) : (pick(2) == 0 ? "a" : "b");
+    }
+    switch (pick(4)) {
+    case 0: return std::format("({} + {})", integer(depth - 1), integer(depth - 1));
+    case 1: return std::format("({} - {})", integer(depth - 1), integer(depth - 1));
+    case 2: return std::format("({} * {})", integer(depth - 1), integer(depth - 1));
+    default: return std::format("({} ? {} : {})", boolean(depth - 1), integer(depth - 1), integer(depth - 1));
+    }
+  }
+
+  std::string floating(int depth) {
+    if ((depth == 0) || (pick(4) == 0)) {
+      return pick(2) == 0 ? std::format("{}.5", pick(10)) : (pick(2) == 0 ? "x" : "y");
+    }
+    switch (pick(6)) {
+    case 0: return std::format("({} + {})", floating(depth - 1), floating(depth - 1));
+    case 1: return std::format("({} - {})", floating(depth - 1), integer(depth - 1));
+    case 2: return std::format("({} * {})", integer(depth - 1), floating(depth - 1));
+    case 3: return std::format("({} / {})", floating(depth - 1), floating(depth - 1));
+    case 4: return std::format("({} ? {} : {})", boolean(depth - 1), floating(depth - 1), floating(depth - 1));
+    default: return std::format("({} + {})", floating(depth - 1), integer(depth - 1));
+    }
+  }
+
+  std::string boolean(int depth) {
+    static const char *s_Comparisons[] = { "<", "<=", ">", ">=", "==", "!=" };
+    if ((depth == 0) || (pick(5) == 0)) {
+      return pick(2) == 0 ? "p" : "q";
+    }
+    const char *comparison = s_Comparisons[pick(6)];
+    switch (pick(6)) {
+    case 0: return std::format("({} {} {})", integer(depth - 1), comparison, integer(depth - 1));
+    case 1: return std::format("({} {} {})", floating(depth - 1), comparison, floating(depth - 1));
+    case 2: return std::format("({} && {})", boolean(depth - 1), boolean(depth - 1));
+    case 3: return std::format("({} || {})", boolean(depth - 1), boolean(depth - 1));
+    case 4: return std::format("!{}", boolean(depth - 1));
+    default: return std::format("({} == {})", boolean(depth - 1), boolean(depth - 1));
+    }
+  }
+
+  int pick(int count) { return static_cast<int>(m_Random() % count); }
+
+private:
+  std::mt19937 m_Random;
+};
+
+bool sameResult(const Result &lhs, const Result &rhs) {
+  if (std::holds_alternative<double>(lhs) && std::holds_alternative<double>(rhs) &&
+      std::isnan(std::get<double>(lhs))) {
+    return std::isnan(std::get<double>(rhs));
+  }
+  return lhs == rhs;
+}
+
+}
+
+TEST_CASE("native code matches the bytecode interpreter", "[Jit]") {
+  TermGenerator generator(GENERATE(1u, 2u, 3u));
+
+  for (int i = 0; i < 60; ++i) {
+    std::string term;
+    switch (i % 3) {
+    case 0: term = generator.integer(4); break;
+    case 1: term = generator.floating(4); break;
+    default: term = generator.boolean(4); break;
+    }
+    auto tokens = tokenize(term);
+    JitExpression expr(tokens, s_Types, 0);
+#ifdef PAGAN_JIT
+    INFO(term);
+    REQUIRE(expr.isNative());
+#endif
+
+    for (int round = 0; round < 10; ++round) {
+      // zeros so divisions produce infinities and NaN
+      std::unordered_map<std::string, Token> values{
+        { "a", Token(int64_t(generator.pick(41) - 20)) }, { "b", Token(int64_t(generator.pick(5) - 2)) },
+        { "x", Token(generator.pick(41) * 0.25 - 5.0) }, { "y", Token(double(generator.pick(3) - 1)) },
+        { "p", Token(generator.pick(2) == 0) }, { "q", Token(generator.pick(2) == 0) },
+      };
+      auto slots = expr.bind([&values](const std::string &name) { return values.at(name); });
+      auto expected = expr.expression().evaluate(slots);
+      auto actual = expr.evaluate(slots);
+      INFO(std::format("{} with a={} b={} x={} y={} p={} q={}", term, values["a"].signedValue,
+                       values["b"].signedValue, values["x"].floatValue, values["y"].floatValue,
+                       values["p"].boolValue, values["q"].boolValue));
+      REQUIRE(sameResult(actual, expected));
+    }
+  }
+}
+
+TEST_CASE("native code matches evaluate", "[Jit]") {
+  // evaluate doesn't convert between integers and floats and picks the wrong branch of conditionals,
+  // neither is used here
+  auto term = GENERATE("a * 3 + b - 4", "(a < b) || (a * b >= 6) && p", "(a - b) * (b + 2)", "!p && (a != b)",
+                       "x * y - 0.5 < x + y", "x / y + 2.5 >= y", "(x == y) || (x != x)", "a * a * a - b");
+  auto tokens = tokenize(term);
+  JitExpression expr(tokens, s_Types, 0);
+
+  for (auto [a, b, x, y, p] : { std::tuple(3, 2, 1.5, -2.0, true), std::tuple(-4, 7, 0.0, 0.0, false),
+                               std::tuple(0, 0, -1.25, 3.5, true) }) {
+    std::unordered_map<std::string, Token> values{
+      { "a", Token(int64_t(a)) }, { "b", Token(int64_t(b)) }, { "x", Token(x) }, { "y", Token(y) },
+      { "p", Token(p) },          { "q", Token(!p) },
+    };
+    auto resolve = [&values](const std::string &name) { return values.at(name); };
+    INFO(std::format("{} with a={} b={} x={} y={} p={}", term, a, b, x, y, p));
+    REQUIRE(expr.evaluate(expr.bind(resolve)) == evaluate(tokens, resolve));
+  }
+}
+
+TEST_CASE("compiles after the threshold", "[Jit]") {
+  JitExpression expr(tokenize("a * 2 + b > 10"), s_Types, 3);
+  std::vector<Token> slots{ Token(int64_t(4)), Token(int64_t(3)) };
+
+  for (int i = 0; i < 3; ++i) {
+    REQUIRE(std::get<bool>(expr.evaluate(slots)));
+    REQUIRE_FALSE(expr.isNative());
+  }
+  REQUIRE(std::get<bool>(expr.evaluate(slots)));
+#ifdef PAGAN_JIT
+  REQUIRE(expr.isNative());
+#endif
+
+  slots[1] = Token(int64_t(2));
+  REQUIRE_FALSE(std::get<bool>(expr.evaluate(slots)));
+  REQUIRE_THROWS(expr.evaluate(std::span<const Token>(slots.data(), 1)));
+}
+
+TEST_CASE("keeps interpreting unsupported expressions", "[Jit]") {
+  auto [term, expected] = GENERATE(table<std::string, Result>({
+    { "a / b", Result(int64_t(2)) },
+    { "a % b", Result(uint64_t(1)) },
+    { "c + 1", Result(int64_t(8)) },
+    { "name + \"!\"", Result("text!"s) },
+  }));
+  std::unordered_map<std::string, Token> values{
+    { "a", Token(int64_t(7)) }, { "b", Token(int64_t(3)) }, { "c", Token(int64_t(7)) }, { "name", Token("text") },
+  };
+  VariableTypes types{ { "a", TokenType::Signed }, { "b", TokenType::Signed }, { "name", TokenType::String } };
+
+  JitExpression expr(tokenize(term), types, 0);
+  REQUIRE_FALSE(expr.isNative());
+  REQUIRE(expr.evaluate(expr.bind([&values](const std::string &name) { return values.at(name); })) == expected);
+}
+
+TEST_CASE("supports typed programs only", "[Jit]") {
+  REQUIRE_FALSE(NativeProgram::isSupported(compile(tokenize("a + 1"))));
+  REQUIRE_FALSE(NativeProgram::isSupported(compile(tokenize("a / 2"), { { "a", TokenType::Signed } })));
+#ifdef PAGAN_JIT
+  REQUIRE(NativeProgram::isSupported(compile(tokenize("a / 2.0 < 1.0 || p"),
+                                             { { "a", TokenType::Signed }, { "p", TokenType::Boolean } })));
+  auto native = NativeProgram::compile(compile(tokenize("x * 2.0"), { { "x", TokenType::Float } }));
+  REQUIRE(native != nullptr);
+  std::vector<Token> slots{ Token(1.25) };
+  REQUIRE(native->execute(slots).floatValue == 2.5);
+#endif
+}
@@ -0,0 +1,112 @@
+#include "compiled_expression.h"
+#include "evaluate.h"
+#include "native_function.h"
+#include "shunting_yard.h"
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <string_view>
+
+using namespace std::literals;
+using namespace SYP;
+
+namespace {
+
+int64_t clampValue(int64_t value, int64_t low, int64_t high) {
+  return std::clamp(value, low, high);
+}
+
+double scale(double value, float factor) {
+  return value * factor;
+}
+
+bool startsWith(std::string_view text, std::string_view prefix) {
+  return text.starts_with(prefix);
+}
+
+uint32_t length(std::string_view text) {
+  return static_cast<uint32_t>(text.size());
+}
+
+SymbolTable &nativeSymbols() {
+  static SymbolTable s_Symbols;
+  static bool s_Registered = [] {
+    s_Symbols.registerFunction("clamp", &clampValue, true);
+    s_Symbols.registerFunction("scale", &scale);
+    s_Symbols.registerFunction<&startsWith>("starts_with");
+    s_Symbols.registerFunction<&length>("length");
+    return true;
+  }();
+  (void)s_Registered;
+  return s_Symbols;
+}
+
+Result run(const std::string &term, const VariableTypes &types = {}) {
+  auto &symbols = nativeSymbols();
+  CompiledExpression expr(tokenize(term, symbols), types);
+  auto slots = expr.bind([&symbols](const std::string &name) {
+    if (name == "value") {
+      return Token(int64_t(12));
+    } else if (name == "name") {
+      return Token("pagan.expr");
+    }
+    return Token(name, TokenType::Function, symbols);
+  });
+  return expr.evaluate(slots);
+}
+
+}
+
+TEST_CASE("calls functions with native signatures", "[NativeFunction]") {
+  REQUIRE(run("clamp(value, 0, 10)") == Result(int64_t(10)));
+  REQUIRE(run("clamp(value, 0, 10)", { { "value", TokenType::Signed } }) == Result(int64_t(10)));
+  REQUIRE(run("scale(2.0, 1.5)") == Result(3.0));
+  REQUIRE(run("starts_with(name, \"pagan\")") == Result(true));
+  REQUIRE(run("length(name) + 0x1") == Result(uint64_t(11)));
+}
+
+TEST_CASE("converts integer arguments", "[NativeFunction]") {
+  // statically by the type checker and dynamically in the generated wrapper
+  REQUIRE(run("scale(2, 0x2)") == Result(4.0));
+  REQUIRE(run("scale(value, 1.0)") == Result(12.0));
+  REQUIRE(run("clamp(0x5, 0, 10)") == Result(int64_t(5)));
+}
+
+TEST_CASE("knows the result type of native functions", "[NativeFunction]") {
+  auto &symbols = nativeSymbols();
+  CompiledExpression expr(tokenize("clamp(value, 0, 10) * 2", symbols), { { "value", TokenType::Signed } });
+
+  REQUIRE(expr.resultType() == TokenType::Signed);
+  REQUIRE(CompiledExpression(tokenize("length(name)", symbols)).resultType() == TokenType::Unsigned);
+}
+
+TEST_CASE("reports invalid calls at compile time", "[NativeFunction]") {
+  auto [term, types] = GENERATE(std::make_pair("clamp(1, 2)", VariableTypes{}),
+                                std::make_pair("clamp(1, 2, 3, 4)", VariableTypes{}),
+                                std::make_pair("clamp(1.5, 0, 10)", VariableTypes{}),
+                                std::make_pair("starts_with(name, 1)", VariableTypes{}),
+                                std::make_pair("length(flag)", VariableTypes{ { "flag", TokenType::Boolean } }));
+
+  REQUIRE_THROWS(CompiledExpression(tokenize(term, nativeSymbols()), types));
+}
+
+TEST_CASE("checks dynamically typed arguments when called", "[NativeFunction]") {
+  auto &symbols = nativeSymbols();
+  auto resolve = [&symbols](const std::string &name) {
+    return name == "text" ? Token(1.5) : Token(name, TokenType::Function, symbols);
+  };
+
+  REQUIRE_THROWS(evaluate(tokenize("length(text)", symbols), resolve));
+  REQUIRE(std::get<int64_t>(evaluate(tokenize("clamp(-5, 0, 10)", symbols), resolve)) == 0);
+}
+
+TEST_CASE("folds pure native functions", "[NativeFunction]") {
+  CompiledExpression expr(tokenize("clamp(20, 0, 10) + 1", nativeSymbols()));
+
+  REQUIRE(expr.program().code.size() == 2);
+  std::vector<Token> slots{ Token("clamp", TokenType::Function, nativeSymbols()) };
+  REQUIRE(expr.evaluate(slots) == Result(int64_t(11)));
+}
@@ -0,0 +1,147 @@
+#include "bytecode.h"
+#include "evaluate.h"
+#include "shunting_yard.h"
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+
+#include <algorithm>
+
+using namespace std::literals;
+using namespace SYP;
+
+namespace {
+
+const VariableTypes s_Types{
+  { "two", TokenType::Signed },
+  { "size", TokenType::Unsigned },
+  { "ratio", TokenType::Float },
+  { "flag", TokenType::Boolean },
+};
+
+std::vector<OpCode> opcodes(const Program &program) {
+  std::vector<OpCode> result;
+  for (const auto &instruction : program.code) {
+    result.push_back(instruction.code());
+  }
+  return result;
+}
+
+bool contains(const Program &program, OpCode code) {
+  return std::any_of(program.code.begin(), program.code.end(),
+                     [code](const Instruction &instruction) { return instruction.code() == code; });
+}
+
+Token variables(const std::string &variable) {
+  if (variable == "two") {
+    return Token(2);
+  } else if (variable == "size") {
+    return Token(uint64_t(10));
+  } else if (variable == "ratio") {
+    return Token(0.5);
+  } else if (variable == "flag") {
+    return Token(true);
+  }
+
+  throw std::runtime_error("unexpected variable name");
+}
+
+Token run(const Program &program) {
+  std::vector<Token> slots;
+  for (size_t i = 0; i < program.slots.size(); ++i) {
+    slots.push_back(program.functionSlots[i] ? Token() : variables(program.slots[i]));
+  }
+  Workspace workspace;
+  return execute(program, slots, workspace);
+}
+
+}
+
+TEST_CASE("folds constant sub-expressions", "[Optimizer]") {
+  auto [term, expected] = GENERATE(std::make_pair("9 + 2 * -4", Result(int64_t(1))),
+                                   std::make_pair("(1 + 2) * 1.5", Result(4.5)),
+                                   std::make_pair("0xF0 >> 4 == 15", Result(true)),
+                                   std::make_pair("1 < 2 ? 3 : 4", Result(int64_t(3))));
+  auto program = compile(tokenize(term));
+
+  REQUIRE(opcodes(program) == std::vector<OpCode>{ OpCode::LoadConst, OpCode::Return });
+  REQUIRE(program.constants.size() == 1);
+  REQUIRE(toResult(run(program)) == expected);
+}
+
+TEST_CASE("folds only the constant part of an expression", "[Optimizer]") {
+  auto program = compile(tokenize("two + 3 * 4"), s_Types);
+
+  REQUIRE(opcodes(program) == std::vector<OpCode>{ OpCode::LoadSlot, OpCode::LoadConst, OpCode::AddI64,
+                                                   OpCode::Return });
+  REQUIRE(toResult(run(program)) == Result(int64_t(14)));
+}
+
+TEST_CASE("folds integer division by zero to zero", "[Optimizer]") {
+  auto term = GENERATE("1 / 0", "5 % 0", "-9223372036854775808 / -1");
+  auto program = compile(tokenize(term));
+
+  REQUIRE(opcodes(program) == std::vector<OpCode>{ OpCode::LoadConst, OpCode::Return });
+  REQUIRE(toResult(run(program)) == toResult(program.constants[0]));
+  REQUIRE(program.constants[0].unsignedValue == 0);
+}
+
+TEST_CASE("removes identities", "[Optimizer]") {
+  auto term = GENERATE("two * 1", "1 * two", "two + 0", "two / 1", "(1 < 2) && flag", "flag || 1 > 2",
+                       "!(!flag)", "ratio * 1.0");
+  auto program = compile(tokenize(term), s_Types);
+
+  REQUIRE(opcodes(program) == std::vector<OpCode>{ OpCode::LoadSlot, OpCode::Return });
+  REQUIRE(toResult(run(program)) == toResult(variables(program.slots[0])));
+}
+
+TEST_CASE("keeps float additions of zero", "[Optimizer]") {
+  auto program = compile(tokenize("ratio + 0.0"), s_Types);
+
+  REQUIRE(contains(program, OpCode::AddF64));
+}
+
+TEST_CASE("replaces powers of two with shifts", "[Optimizer]") {
+  auto [term, code, expected] = GENERATE(
+      std::make_tuple("two * 8", OpCode::ShlI64, Result(int64_t(16))),
+      std::make_tuple("4 * two", OpCode::ShlI64, Result(int64_t(8))),
+      std::make_tuple("size * 0x2", OpCode::ShlU64, Result(uint64_t(20))),
+      std::make_tuple("size / 0x4", OpCode::ShrU64, Result(uint64_t(2))),
+      std::make_tuple("size % 8", OpCode::AndU64, Result(uint64_t(2))));
+  auto program = compile(tokenize(term), s_Types);
+
+  REQUIRE(contains(program, code));
+  REQUIRE(toResult(run(program)) == expected);
+}
+
+TEST_CASE("evaluates pure functions at compile time", "[Optimizer]") {
+  SymbolTable symbols;
+  int calls = 0;
+  auto square = [&calls](const std::vector<Token> &args) {
+    ++calls;
+    return Token(args[0].signedValue * args[0].signedValue);
+  };
+  symbols.registerFunction("square", square, true);
+  symbols.registerFunction("impure", square);
+
+  auto program = compile(tokenize("square(3) + 1", symbols));
+  REQUIRE(calls == 1);
+  REQUIRE(opcodes(program) == std::vector<OpCode>{ OpCode::LoadConst, OpCode::Return });
+  REQUIRE(toResult(run(program)) == Result(int64_t(10)));
+
+  auto impure = compile(tokenize("impure(3) + 1", symbols));
+  REQUIRE(calls == 1);
+  REQUIRE(impure.code.size() > 2);
+}
+
+TEST_CASE("produces the same results as the unoptimized program", "[Optimizer]") {
+  auto term = GENERATE("two * 8 + size / 0x4", "(size % 16) * 3", "ratio * 2.0 + 0.0", "flag && 1 < 2",
+                       "flag ? two * 4 : 3", "0 * two + size * 1");
+  auto tree = buildTree(tokenize(term));
+  typeCheck(tree, s_Types);
+  auto reference = compile(tree);
+  auto program = compile(tokenize(term), s_Types);
+
+  REQUIRE(program.code.size() <= reference.code.size());
+  REQUIRE(toResult(run(program)) == toResult(run(reference)));
+}
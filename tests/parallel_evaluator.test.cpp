@@ -0,0 +1,127 @@
+#include "parallel_evaluator.h"
+#include "shunting_yard.h"
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <format>
+#include <memory>
+#include <vector>
+
+using namespace std::literals;
+using namespace SYP;
+
+namespace {
+
+const VariableTypes s_Types{
+  { "count", TokenType::Signed },
+  { "price", TokenType::Float },
+  { "active", TokenType::Boolean },
+};
+
+struct Table {
+  std::vector<int64_t> count;
+  std::vector<double> price;
+  std::unique_ptr<bool[]> active;
+  RowSet rows;
+
+  explicit Table(size_t size) : active(new bool[size]), rows(size) {
+    for (size_t i = 0; i < size; ++i) {
+      count.push_back(static_cast<int64_t>(i % 11));
+      price.push_back(static_cast<double>(i % 100) * 0.25);
+      active[i] = (i % 3) == 0;
+    }
+    rows.add("count", Column(count.data())).add("price", Column(price.data())).add("active", Column(active.get()));
+  }
+
+  std::vector<Column> columns(const CompiledExpression &expr) const {
+    std::vector<Column> result;
+    for (const auto &name : expr.variables()) {
+      result.push_back(*rows.find(name));
+    }
+    return result;
+  }
+};
+
+}
+
+TEST_CASE("evaluates sets of expressions in parallel", "[ParallelEvaluator]") {
+  auto [threads, rows] = GENERATE(std::make_pair(1, 10000), std::make_pair(4, 10000), std::make_pair(3, 1),
+                                  std::make_pair(8, 100003));
+  Table table(rows);
+
+  std::vector<CompiledExpression> expressions{
+    CompiledExpression(tokenize("count * 3 > 10 && active"), s_Types),
+    CompiledExpression(tokenize("price > 10.0 || count == 2"), s_Types),
+    // untyped, gets evaluated row by row
+    CompiledExpression(tokenize("count % 2 == 0 ? active : !active")),
+  };
+
+  std::vector<std::unique_ptr<bool[]>> results;
+  std::vector<OutputColumn> outputs;
+  for (size_t i = 0; i < expressions.size(); ++i) {
+    results.emplace_back(new bool[rows]);
+    outputs.emplace_back(results.back().get());
+  }
+
+  ParallelEvaluator evaluator(threads, 1000);
+  REQUIRE(evaluator.threadCount() == static_cast<size_t>(threads));
+  evaluator.evaluate(expressions, table.rows, outputs);
+
+  for (size_t i = 0; i < expressions.size(); ++i) {
+    std::unique_ptr<bool[]> expected(new bool[rows]);
+    evaluateBatch(expressions[i], table.columns(expressions[i]), rows, OutputColumn(expected.get()));
+    for (int row = 0; row < rows; ++row) {
+      INFO(std::format("expression {} row {}", i, row));
+      REQUIRE(results[i][row] == expected[row]);
+    }
+  }
+}
+
+TEST_CASE("can be reused for multiple evaluations", "[ParallelEvaluator]") {
+  Table table(5000);
+  std::vector<CompiledExpression> expressions{ CompiledExpression(tokenize("count * 2"), s_Types) };
+  std::vector<int64_t> result(5000);
+  std::vector<OutputColumn> outputs{ OutputColumn(result.data()) };
+
+  ParallelEvaluator evaluator(4, 256);
+  for (int i = 0; i < 5; ++i) {
+    std::fill(result.begin(), result.end(), -1);
+    evaluator.evaluate(expressions, table.rows, outputs);
+    for (size_t row = 0; row < result.size(); ++row) {
+      REQUIRE(result[row] == table.count[row] * 2);
+    }
+  }
+}
+
+TEST_CASE("reports errors of parallel evaluations", "[ParallelEvaluator]") {
+  Table table(5000);
+  ParallelEvaluator evaluator(4, 256);
+  std::unique_ptr<bool[]> flags(new bool[5000]);
+  std::vector<OutputColumn> outputs{ OutputColumn(flags.get()) };
+
+  SECTION("missing column") {
+    std::vector<CompiledExpression> expressions{ CompiledExpression(tokenize("missing > 1")) };
+    REQUIRE_THROWS(evaluator.evaluate(expressions, table.rows, outputs));
+  }
+
+  SECTION("output type") {
+    std::vector<CompiledExpression> expressions{ CompiledExpression(tokenize("count + 1"), s_Types) };
+    REQUIRE_THROWS(evaluator.evaluate(expressions, table.rows, outputs));
+  }
+
+  SECTION("failing row") {
+    // without declared types the result type is only known per row, it only fits the output
+    // for some of them
+    std::vector<CompiledExpression> expressions{ CompiledExpression(tokenize("count > 9 ? count : active")) };
+    REQUIRE_THROWS(evaluator.evaluate(expressions, table.rows, outputs));
+  }
+
+  // still usable afterwards
+  std::vector<CompiledExpression> expressions{ CompiledExpression(tokenize("count > 5"), s_Types) };
+  evaluator.evaluate(expressions, table.rows, outputs);
+  REQUIRE(flags[6]);
+  REQUIRE_FALSE(flags[5]);
+}
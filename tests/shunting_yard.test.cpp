@@ -1,13 +1,50 @@
 #include <catch2/catch_test_macros.hpp>
 #include <catch2/generators/catch_generators.hpp>
 
+#include <cstdint>
+#include <format>
+#include <limits>
 #include <memory>
+#include <string>
+#include <vector>
 
 #include "shunting_yard.h"
 
 using namespace std::literals;
 using namespace SYP;
 
+namespace {
+
+std::string describe(const TokenQueue &tokens) {
+  std::string result;
+  for (const auto &tok : tokens) {
+    switch (tok.type) {
+    case TokenType::Operator: result += std::format("op{} ", static_cast<unsigned>(tok.op)); break;
+    case TokenType::Signed: result += std::format("{} ", tok.signedValue); break;
+    case TokenType::Unsigned: result += std::format("{}u ", tok.unsignedValue); break;
+    case TokenType::Float: result += std::format("{}f ", tok.floatValue); break;
+    case TokenType::Boolean: result += std::format("{} ", tok.boolValue); break;
+    case TokenType::String: result += std::format("\"{}\" ", *tok.name); break;
+    case TokenType::FunctionName: result += std::format("{}() ", *tok.name); break;
+    default: result += std::format("{} ", *tok.name); break;
+    }
+  }
+  return result;
+}
+
+std::vector<std::string> tokenizeStream(std::string_view script, size_t chunkSize) {
+  std::vector<std::string> result;
+  auto collect = [&result](const TokenQueue &tokens) { result.push_back(describe(tokens)); };
+  StreamTokenizer tokenizer;
+  for (size_t offset = 0; offset < script.size(); offset += chunkSize) {
+    tokenizer.feed(script.substr(offset, chunkSize), collect);
+  }
+  tokenizer.finish(collect);
+  return result;
+}
+
+}
+
 TEST_CASE("parses two operand statement", "[ShuntingYard]") {
   auto tokens = tokenize("1 + 1"sv);
 
@@ -80,3 +117,128 @@ TEST_CASE("supports various simple terms", "[ShuntingYardTerms]") {
   REQUIRE(tokens.size() == 3);
   REQUIRE(tokens[2].type == TokenType::Operator);
 }
+
+TEST_CASE("distinguishes subtraction from negative numbers", "[ShuntingYard]") {
+  auto [term, size, last] = GENERATE(std::make_tuple("7 - 2", size_t{ 3 }, OperatorType::Subtract),
+                                     std::make_tuple("7-2", size_t{ 3 }, OperatorType::Subtract),
+                                     std::make_tuple("two -2", size_t{ 3 }, OperatorType::Subtract),
+                                     std::make_tuple("(1) - 2", size_t{ 3 }, OperatorType::Subtract),
+                                     std::make_tuple("3 * -2", size_t{ 3 }, OperatorType::Multiply),
+                                     std::make_tuple("(-2) * 3", size_t{ 3 }, OperatorType::Multiply));
+  auto tokens = tokenize(term);
+
+  REQUIRE(tokens.size() == size);
+  REQUIRE(tokens.back().op == last);
+}
+
+TEST_CASE("only treats whole words as word operators", "[ShuntingYard]") {
+  auto tokens = tokenize("order and android or candor"sv);
+
+  REQUIRE(tokens.size() == 5);
+  REQUIRE(tokens[0].getVariableName() == "order");
+  REQUIRE(tokens[1].getVariableName() == "android");
+  REQUIRE(tokens[2].op == OperatorType::LogicalAnd);
+  REQUIRE(tokens[3].getVariableName() == "candor");
+  REQUIRE(tokens[4].op == OperatorType::LogicalOr);
+}
+
+TEST_CASE("supports stacked prefix operators", "[ShuntingYard]") {
+  auto tokens = tokenize("!!flag"sv);
+
+  REQUIRE(tokens.size() == 3);
+  REQUIRE(tokens[1].op == OperatorType::LogicalNot);
+  REQUIRE(tokens[2].op == OperatorType::LogicalNot);
+}
+
+TEST_CASE("ignores surrounding whitespace", "[ShuntingYard]") {
+  auto tokens = tokenize("\t 1 +\n1  "sv);
+
+  REQUIRE(tokens.size() == 3);
+  REQUIRE(tokens[2].op == OperatorType::Add);
+}
+
+TEST_CASE("parses float literals", "[ShuntingYard]") {
+  auto [term, expected] = GENERATE(std::make_pair("1.5", 1.5), std::make_pair("-0.25", -0.25),
+                                   std::make_pair("1e-3", 1e-3), std::make_pair("2.5E+2", 250.0),
+                                   std::make_pair("3e2", 300.0), std::make_pair("1.", 1.0));
+  auto tokens = tokenize(term);
+
+  REQUIRE(tokens.size() == 1);
+  REQUIRE(tokens[0].type == TokenType::Float);
+  REQUIRE(tokens[0].floatValue == expected);
+}
+
+TEST_CASE("parses integer literals", "[ShuntingYard]") {
+  REQUIRE(tokenize("0x1F"sv)[0].unsignedValue == 31);
+  REQUIRE(tokenize("0XffffFFFFffffFFFF"sv)[0].unsignedValue == ~uint64_t(0));
+  REQUIRE(tokenize("0b1011"sv)[0].unsignedValue == 11);
+  REQUIRE(tokenize("0b1011"sv)[0].type == TokenType::Unsigned);
+
+  auto min = tokenize("-9223372036854775808"sv);
+  REQUIRE(min[0].type == TokenType::Signed);
+  REQUIRE(min[0].signedValue == std::numeric_limits<int64_t>::min());
+}
+
+TEST_CASE("rejects invalid input", "[ShuntingYard]") {
+  auto term = GENERATE("1 # 2", "\"unterminated", "1 @ 2", "1.2.3", "1e", "1e+", "0x", "0b12",
+                       "0xfg", "12abc", "-0x1", "99999999999999999999", "0x10000000000000000");
+
+  REQUIRE_THROWS(tokenize(term));
+}
+
+TEST_CASE("tokenizes chunked statements like whole ones", "[ShuntingYard]") {
+  const std::vector<std::string_view> statements{
+    "alpha * 12 + -3 >= beta2",  "\"semi;colon\" + name",     "max (1.5e-3, 0x1F, 0b101) << 2",
+    "!done && (a <= b || c != d)", "x == -9223372036854775808", "cond ? 1 : 2 and flag or other",
+  };
+  std::string script;
+  std::vector<std::string> expected;
+  for (auto statement : statements) {
+    script += std::format("{};\n  ", statement);
+    expected.push_back(describe(tokenize(statement)));
+  }
+
+  // every possible cut through every token
+  for (size_t chunkSize = 1; chunkSize <= script.size(); ++chunkSize) {
+    INFO(chunkSize);
+    REQUIRE(tokenizeStream(script, chunkSize) == expected);
+  }
+}
+
+TEST_CASE("passes on statements as they end", "[ShuntingYard]") {
+  std::vector<std::string> statements;
+  auto collect = [&statements](const TokenQueue &tokens) { statements.push_back(describe(tokens)); };
+  StreamTokenizer tokenizer;
+
+  tokenizer.feed("a + 1; ;; b", collect);
+  REQUIRE(statements.size() == 1);
+  REQUIRE(statements[0] == describe(tokenize("a + 1")));
+  tokenizer.feed(" * 2", collect);
+  REQUIRE(statements.size() == 1);
+  tokenizer.finish(collect);
+  REQUIRE(statements.size() == 2);
+  REQUIRE(statements[1] == describe(tokenize("b * 2")));
+  REQUIRE(tokenizer.statementCount() == 2);
+
+  // ready for the next script
+  tokenizer.feed("3", collect);
+  tokenizer.finish(collect);
+  REQUIRE(statements.back() == "3 ");
+  REQUIRE(tokenizer.statementCount() == 3);
+
+  tokenizer.reset();
+  REQUIRE(tokenizer.statementCount() == 0);
+}
+
+TEST_CASE("rejects invalid chunked input", "[ShuntingYard]") {
+  auto [first, second] = GENERATE(std::make_pair("1.", "2.3;"), std::make_pair("1 + \"open", " string"),
+                                  std::make_pair("0x", "g;"), std::make_pair("1 #", " 2"));
+  StreamTokenizer tokenizer;
+  auto ignore = [](const TokenQueue &) {};
+
+  REQUIRE_THROWS([&] {
+    tokenizer.feed(first, ignore);
+    tokenizer.feed(second, ignore);
+    tokenizer.finish(ignore);
+  }());
+}
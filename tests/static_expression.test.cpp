@@ -0,0 +1,91 @@
+#include "compiled_expression.h"
+#include "shunting_yard.h"
+#include "static_expression.h"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+using namespace std::literals;
+using namespace SYP;
+using namespace SYP::literals;
+
+namespace {
+
+template <typename T>
+Result asResult(T value) {
+  return Result(value);
+}
+
+}
+
+// constant expressions are evaluated by the compiler
+static_assert(PAGAN_EXPR("2 + 3 * 4")() == 14);
+static_assert(PAGAN_EXPR("(2 + 3) * 4")() == 20);
+static_assert(PAGAN_EXPR("10 - 4 - 3")() == 3);
+static_assert(PAGAN_EXPR("1 < 2 && !(3 > 4)")());
+static_assert(PAGAN_EXPR("1 == 2 ? 10 : 20")() == 20);
+static_assert(PAGAN_EXPR("0x10 | 0b11")() == 19u);
+static_assert(PAGAN_EXPR("7 % 4 << 2")() == 12u);
+static_assert(PAGAN_EXPR("1.5 * 4")() == 6.0);
+static_assert(PAGAN_EXPR("-2 * -3")() == 6);
+static_assert(PAGAN_EXPR("2 > 1 and 3 < 1 or 1 == 1")());
+static_assert("x * 2"_expr(21) == 42);
+
+static_assert(std::is_same_v<decltype(PAGAN_EXPR("a + b")(int64_t(1), 2.0)), double>);
+static_assert(std::is_same_v<decltype(PAGAN_EXPR("a % 3")(int64_t(7))), uint64_t>);
+static_assert(std::is_same_v<decltype(PAGAN_EXPR("a > 1 ? a : 0.5")(int64_t(7))), double>);
+
+TEST_CASE("lists variables in order of appearance", "[StaticExpression]") {
+  constexpr auto expr = PAGAN_EXPR("b * a + b - c");
+  static_assert(expr.s_VariableCount == 3);
+  REQUIRE(expr.variables()[0] == "b");
+  REQUIRE(expr.variables()[1] == "a");
+  REQUIRE(expr.variables()[2] == "c");
+  REQUIRE(expr(int64_t(2), int64_t(5), int64_t(1)) == 11);
+}
+
+TEST_CASE("matches compiled expressions", "[StaticExpression]") {
+  std::unordered_map<std::string, Token> values{
+    { "a", Token(int64_t(7)) }, { "b", Token(int64_t(-3)) }, { "x", Token(2.5) }, { "p", Token(true) },
+  };
+  VariableTypes types{
+    { "a", TokenType::Signed }, { "b", TokenType::Signed }, { "x", TokenType::Float }, { "p", TokenType::Boolean },
+  };
+  auto compiled = [&](const char *term) {
+    CompiledExpression expr(tokenize(term), types);
+    return expr.evaluate(expr.bind([&values](const std::string &name) { return values.at(name); }));
+  };
+  int64_t a = 7;
+  int64_t b = -3;
+  double x = 2.5;
+  bool p = true;
+
+  REQUIRE(asResult(PAGAN_EXPR("a * 2 + b")(a, b)) == compiled("a * 2 + b"));
+  REQUIRE(asResult(PAGAN_EXPR("a - b * x")(a, b, x)) == compiled("a - b * x"));
+  REQUIRE(asResult(PAGAN_EXPR("a / b")(a, b)) == compiled("a / b"));
+  REQUIRE(asResult(PAGAN_EXPR("a % 4 ^ b")(a, b)) == compiled("a % 4 ^ b"));
+  REQUIRE(asResult(PAGAN_EXPR("a > b == p")(a, b, p)) == compiled("a > b == p"));
+  REQUIRE(asResult(PAGAN_EXPR("p && a || !b")(p, a, b)) == compiled("p && a || !b"));
+  REQUIRE(asResult(PAGAN_EXPR("p ? a : x")(p, a, x)) == compiled("p ? a : x"));
+  REQUIRE(asResult(PAGAN_EXPR("!p ? 1 : (a < 2 ? 2 : 3)")(p, a)) == compiled("!p ? 1 : (a < 2 ? 2 : 3)"));
+  REQUIRE(asResult(PAGAN_EXPR("x * 1e2 + 0.5e-1 * 2")(x)) == compiled("x * 1e2 + 0.5e-1 * 2"));
+}
+
+TEST_CASE("converts arguments like token values", "[StaticExpression]") {
+  constexpr auto expr = PAGAN_EXPR("a + b");
+  REQUIRE(expr(1, 2) == 3);
+  REQUIRE(expr(uint32_t(1), uint64_t(2)) == 3u);
+  REQUIRE(expr(1.5f, 2) == 3.5);
+}
+
+TEST_CASE("only evaluates the selected branch", "[StaticExpression]") {
+  constexpr auto expr = PAGAN_EXPR("b != 0 && a / b > 1 ? a / b : 0");
+  // b appears first
+  REQUIRE(expr(int64_t(0), int64_t(1)) == 0);
+  REQUIRE(expr(int64_t(3), int64_t(9)) == 3);
+}
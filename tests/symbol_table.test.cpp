@@ -0,0 +1,103 @@
+#include "compiled_expression.h"
+#include "evaluate.h"
+#include "shunting_yard.h"
+#include "symbol_table.h"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <atomic>
+#include <format>
+#include <thread>
+
+using namespace std::literals;
+using namespace SYP;
+
+TEST_CASE("interns names once", "[SymbolTable]") {
+  SymbolTable symbols;
+
+  auto first = symbols.internVariable("foo");
+  REQUIRE(symbols.internVariable("foo"sv) == first);
+  REQUIRE(symbols.internVariable("bar") != first);
+  REQUIRE(symbols.variableCount() == 2);
+  REQUIRE(*symbols.findVariable("foo") == "foo");
+  REQUIRE(symbols.findVariable("baz") == nullptr);
+
+  auto func = symbols.internFunction("foo");
+  REQUIRE(func->function == nullptr);
+  REQUIRE(symbols.functionCount() == 1);
+}
+
+namespace {
+
+Token sumArgs(FunctionArgs args) {
+  int64_t result = 0;
+  for (const auto &arg : args) {
+    result += arg.signedValue;
+  }
+  return Token(result);
+}
+
+}
+
+TEST_CASE("registers functions of every calling convention", "[SymbolTable]") {
+  SymbolTable symbols;
+  int64_t offset = 100;
+
+  auto native = symbols.registerFunction("native", sumArgs);
+  auto inlined = symbols.registerFunction<sumArgs>("inlined");
+  auto span = symbols.registerFunction("span", [offset](FunctionArgs args) { return Token(offset + args[0].signedValue); });
+  auto vector = symbols.registerFunction("vector", [](const std::vector<Token> &args) { return Token(int64_t(args.size())); });
+
+  REQUIRE(native->native != nullptr);
+  REQUIRE(inlined->native != nullptr);
+  REQUIRE(span->native == nullptr);
+  REQUIRE(span->defined());
+  REQUIRE(vector->native == nullptr);
+  REQUIRE(vector->defined());
+  REQUIRE(!symbols.internFunction("missing")->defined());
+
+  auto resolve = [&symbols](const std::string &name) {
+    return Token(name, TokenType::Function, symbols);
+  };
+  auto tokens = tokenize("native(1, 2) + inlined(3, 4) + span(5) + vector(6, 7, 8)", symbols);
+  REQUIRE(std::get<int64_t>(evaluate(tokens, resolve)) == 3 + 7 + 105 + 3);
+
+  CompiledExpression expr(tokens);
+  REQUIRE(std::get<int64_t>(expr.evaluate(expr.bind(resolve))) == 3 + 7 + 105 + 3);
+
+  REQUIRE_THROWS(evaluate(tokenize("missing(1)", symbols), resolve));
+}
+
+TEST_CASE("keeps tables separate", "[SymbolTable]") {
+  SymbolTable lhs;
+  SymbolTable rhs;
+
+  auto tokens = tokenize("first + second", lhs);
+  REQUIRE(tokens[0].getVariableName() == "first");
+  REQUIRE(lhs.variableCount() == 2);
+  REQUIRE(rhs.variableCount() == 0);
+  REQUIRE(lhs.findVariable("first") == tokens[0].name);
+}
+
+TEST_CASE("tokenizes concurrently", "[SymbolTable]") {
+  SymbolTable symbols;
+  std::vector<std::thread> threads;
+  std::atomic<int> failures{0};
+
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&symbols, &failures, t]() {
+      for (int i = 0; i < 1000; ++i) {
+        auto tokens = tokenize(std::format("var{} + shared{} * 2", i, (i + t) % 10), symbols);
+        if (tokens.size() != 5) {
+          ++failures;
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  REQUIRE(failures == 0);
+  REQUIRE(symbols.variableCount() == 1010);
+}
@@ -0,0 +1,88 @@
+#include "bytecode.h"
+#include "compiled_expression.h"
+#include "shunting_yard.h"
+#include "type_check.h"
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+
+#include <algorithm>
+
+using namespace std::literals;
+using namespace SYP;
+
+namespace {
+
+const VariableTypes s_Types{
+  { "two", TokenType::Signed },
+  { "size", TokenType::Unsigned },
+  { "ratio", TokenType::Float },
+  { "flag", TokenType::Boolean },
+  { "name", TokenType::String },
+};
+
+Token typedVariables(const std::string &variable) {
+  if (variable == "two") {
+    return Token(2);
+  } else if (variable == "size") {
+    return Token(uint64_t(10));
+  } else if (variable == "ratio") {
+    return Token(0.5);
+  } else if (variable == "flag") {
+    return Token(true);
+  } else if (variable == "name") {
+    return Token("foo");
+  }
+
+  throw std::runtime_error("unexpected variable name");
+}
+
+bool isDynamic(const Program &program) {
+  return std::any_of(program.code.begin(), program.code.end(),
+                     [](const Instruction &instruction) { return instruction.code() == OpCode::Operator; });
+}
+
+}
+
+TEST_CASE("selects typed operations for declared variables", "[TypeCheck]") {
+  auto term = GENERATE("3 * two == 6", "two + size", "ratio * two", "flag && two", "name == \"foo\"",
+                       "!(size > 3) || ratio < 1", "flag ? two : ratio");
+  auto program = compile(tokenize(term), s_Types);
+
+  REQUIRE_FALSE(isDynamic(program));
+  REQUIRE(program.resultType != TokenType::Undefined);
+}
+
+TEST_CASE("converts operands to a common type", "[TypeCheck]") {
+  auto [term, type, expected] = GENERATE(
+      std::make_tuple("ratio * two", TokenType::Float, Result(1.0)),
+      std::make_tuple("two + size", TokenType::Signed, Result(int64_t(12))),
+      std::make_tuple("size % two", TokenType::Unsigned, Result(uint64_t(0))),
+      std::make_tuple("flag ? two : ratio", TokenType::Float, Result(2.0)),
+      std::make_tuple("size && 0", TokenType::Boolean, Result(false)),
+      std::make_tuple("name + \"bar\" == \"foobar\"", TokenType::Boolean, Result(true)));
+  CompiledExpression expr(tokenize(term), s_Types);
+
+  REQUIRE(expr.resultType() == type);
+  REQUIRE(expr.evaluate(expr.bind(typedVariables)) == expected);
+}
+
+TEST_CASE("reports type errors when compiling", "[TypeCheck]") {
+  auto term = GENERATE("flag + 1", "name * 2", "ratio % 2", "name && flag", "flag ? name : two",
+                       "ratio < name", "!name");
+
+  REQUIRE_THROWS(compile(tokenize(term), s_Types));
+}
+
+TEST_CASE("keeps undeclared variables dynamic", "[TypeCheck]") {
+  auto program = compile(tokenize("two * other"), s_Types);
+
+  REQUIRE(isDynamic(program));
+  REQUIRE(program.slotTypes == std::vector<TokenType>{ TokenType::Signed, TokenType::Undefined });
+}
+
+TEST_CASE("rejects bound values of the wrong type", "[TypeCheck]") {
+  CompiledExpression expr(tokenize("two * 2"), { { "two", TokenType::Float } });
+
+  REQUIRE_THROWS(expr.bind(typedVariables));
+}
@@ -0,0 +1,86 @@
+#include "compiled_expression.h"
+#include "evaluate.h"
+#include "shunting_yard.h"
+#include "workspace.h"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <string>
+
+using namespace std::literals;
+using namespace SYP;
+
+TEST_CASE("parses and evaluates with a caller owned workspace", "[Workspace]") {
+  Workspace workspace;
+  SymbolTable symbols;
+
+  const auto &tokens = tokenize("(1 + 2) * 3 == 9", symbols, workspace);
+  REQUIRE(std::get<bool>(evaluate(tokens, workspace)) == true);
+
+  auto resolve = [](const std::string &name) {
+    return name == "name" ? Token("pagan") : Token(int64_t(42));
+  };
+  const auto &strings = tokenize("name + \".expr\"", symbols, workspace);
+  REQUIRE(std::get<std::string>(evaluate(strings, workspace, resolve)) == "pagan.expr");
+  REQUIRE(workspace.strings().size() == 1);
+}
+
+TEST_CASE("calls functions with a caller owned workspace", "[Workspace]") {
+  Workspace workspace;
+  Token sum("workspace_sum", [](const std::vector<Token> &args) {
+    int64_t result = 0;
+    for (const auto &arg : args) {
+      result += arg.signedValue;
+    }
+    return Token(result);
+  });
+
+  auto tokens = tokenize("workspace_sum(1, 2, workspace_sum(3, 4)) + 1");
+  auto resolve = [&sum](const std::string &) { return sum; };
+
+  for (int i = 0; i < 3; ++i) {
+    REQUIRE(std::get<int64_t>(evaluate(tokens, workspace, resolve)) == 11);
+  }
+}
+
+TEST_CASE("reuses buffers across resets", "[Workspace]") {
+  Workspace workspace;
+  CompiledExpression expr(tokenize("a * 2 + b"));
+  std::vector<Token> slots{ Token(int64_t(3)), Token(int64_t(4)) };
+
+  REQUIRE(std::get<int64_t>(expr.evaluate(slots, workspace)) == 10);
+  auto capacity = workspace.capacity();
+  REQUIRE(capacity > 0);
+
+  for (int i = 0; i < 10; ++i) {
+    workspace.reset();
+    REQUIRE(std::get<int64_t>(expr.evaluate(slots, workspace)) == 10);
+    REQUIRE(workspace.capacity() == capacity);
+  }
+}
+
+TEST_CASE("releases buffers above the shrink threshold", "[Workspace]") {
+  Workspace workspace(16);
+  SymbolTable symbols;
+
+  std::string term = "1";
+  for (int i = 0; i < 100; ++i) {
+    term += " + 1";
+  }
+  const auto &tokens = tokenize(term, symbols, workspace);
+  REQUIRE(std::get<int64_t>(evaluate(tokens, workspace)) == 101);
+  REQUIRE(workspace.capacity() > 16);
+
+  workspace.reset();
+  REQUIRE(workspace.capacity() < 16);
+
+  SECTION("unless shrinking is disabled") {
+    workspace.setShrinkThreshold(0);
+    const auto &again = tokenize(term, symbols, workspace);
+    REQUIRE(std::get<int64_t>(evaluate(again, workspace)) == 101);
+    auto capacity = workspace.capacity();
+
+    workspace.reset();
+    REQUIRE(workspace.capacity() == capacity);
+  }
+}